@@ -0,0 +1,373 @@
+#include "BatchFileIo.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <functional>
+#include <iostream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+namespace {
+
+// Larger requests are split; a single read/write returns at most ~2 GiB on Linux anyway
+constexpr size_t MAX_IO_BYTES = (size_t) 1 << 30;
+
+void reportFailure(const char *what, const std::string &path, int error) {
+    std::cout << "ERROR::FILE_IO:: " << what << " " << path << ": " << std::strerror(error) << std::endl;
+}
+
+}
+
+#ifdef __linux__
+
+// Minimal raw-syscall io_uring: one SQ/CQ pair, no SQPOLL, no registered files.
+struct BatchFileIo::Ring {
+    int fd = -1;
+    unsigned int entries = 0;
+    void *sqMap = MAP_FAILED, *cqMap = MAP_FAILED;
+    size_t sqMapSize = 0, cqMapSize = 0, sqeMapSize = 0;
+    io_uring_sqe *sqes = (io_uring_sqe *) MAP_FAILED;
+    unsigned int *sqHead = nullptr, *sqTail = nullptr, *sqMask = nullptr, *sqArray = nullptr;
+    unsigned int *cqHead = nullptr, *cqTail = nullptr, *cqMask = nullptr;
+    io_uring_cqe *cqes = nullptr;
+
+    ~Ring() {
+        if (sqes != MAP_FAILED) munmap(sqes, sqeMapSize);
+        if (cqMap != MAP_FAILED && cqMap != sqMap) munmap(cqMap, cqMapSize);
+        if (sqMap != MAP_FAILED) munmap(sqMap, sqMapSize);
+        if (fd >= 0) close(fd);
+    }
+
+    bool init(unsigned int depth) {
+        io_uring_params params = {};
+        fd = (int) syscall(__NR_io_uring_setup, depth, &params);
+        if (fd < 0)
+            return false;
+        entries = params.sq_entries;
+
+        sqMapSize = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+        cqMapSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        if (params.features & IORING_FEAT_SINGLE_MMAP)
+            sqMapSize = cqMapSize = std::max(sqMapSize, cqMapSize);
+
+        sqMap = mmap(nullptr, sqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (sqMap == MAP_FAILED)
+            return false;
+        cqMap = params.features & IORING_FEAT_SINGLE_MMAP
+                    ? sqMap
+                    : mmap(nullptr, cqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (cqMap == MAP_FAILED)
+            return false;
+        sqeMapSize = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = (io_uring_sqe *) mmap(nullptr, sqeMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                                     IORING_OFF_SQES);
+        if (sqes == MAP_FAILED)
+            return false;
+
+        auto *sq = (unsigned char *) sqMap, *cq = (unsigned char *) cqMap;
+        sqHead = (unsigned int *) (sq + params.sq_off.head);
+        sqTail = (unsigned int *) (sq + params.sq_off.tail);
+        sqMask = (unsigned int *) (sq + params.sq_off.ring_mask);
+        sqArray = (unsigned int *) (sq + params.sq_off.array);
+        cqHead = (unsigned int *) (cq + params.cq_off.head);
+        cqTail = (unsigned int *) (cq + params.cq_off.tail);
+        cqMask = (unsigned int *) (cq + params.cq_off.ring_mask);
+        cqes = (io_uring_cqe *) (cq + params.cq_off.cqes);
+        return supportsOps();
+    }
+
+    // Everything the batches use must exist on this kernel (5.6+), otherwise we fall back
+    bool supportsOps() {
+        std::vector<unsigned char> buffer(sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op));
+        auto *probe = (io_uring_probe *) buffer.data();
+        if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, 256) < 0)
+            return false;
+        for (int op : {IORING_OP_OPENAT, IORING_OP_STATX, IORING_OP_READ, IORING_OP_WRITE, IORING_OP_CLOSE}) {
+            if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED))
+                return false;
+        }
+        return true;
+    }
+
+    // Runs ops [0, count) with at most `entries` in flight. prepare() fills the SQE for
+    // op i; complete() gets its result and returns false to have it prepared and queued again.
+    void run(size_t count, const std::function<void(io_uring_sqe &, size_t)> &prepare,
+             const std::function<bool(size_t, int)> &complete, uint64_t &enterCalls) {
+        std::deque<size_t> pending;
+        for (size_t i = 0; i < count; i++)
+            pending.push_back(i);
+        unsigned int inFlight = 0;
+
+        while (!pending.empty() || inFlight > 0) {
+            unsigned int tail = *sqTail;
+            while (!pending.empty() && inFlight + (tail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE)) < entries) {
+                size_t op = pending.front();
+                pending.pop_front();
+                unsigned int index = tail & *sqMask;
+                io_uring_sqe &sqe = sqes[index];
+                std::memset(&sqe, 0, sizeof(sqe));
+                prepare(sqe, op);
+                sqe.user_data = op;
+                sqArray[index] = index;
+                tail++;
+            }
+            __atomic_store_n(sqTail, tail, __ATOMIC_RELEASE);
+
+            // Waiting for half of what is in flight keeps the ring busy without one enter per completion
+            unsigned int toSubmit = tail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+            unsigned int waitFor = pending.empty() ? inFlight + toSubmit : std::max(1u, (inFlight + toSubmit) / 2);
+            int submitted = (int) syscall(__NR_io_uring_enter, fd, toSubmit, waitFor, IORING_ENTER_GETEVENTS, nullptr, 0);
+            enterCalls++;
+            if (submitted < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                std::cout << "ERROR::FILE_IO:: io_uring_enter failed: " << std::strerror(errno) << std::endl;
+                return;
+            }
+            if (submitted > 0)
+                inFlight += (unsigned int) submitted;
+
+            unsigned int head = *cqHead;
+            unsigned int cqTailNow = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+            for (; head != cqTailNow; head++) {
+                const io_uring_cqe &cqe = cqes[head & *cqMask];
+                inFlight--;
+                if (!complete((size_t) cqe.user_data, cqe.res))
+                    pending.push_back((size_t) cqe.user_data);
+            }
+            __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+        }
+    }
+};
+
+#else
+
+struct BatchFileIo::Ring {};
+
+#endif
+
+BatchFileIo::BatchFileIo(unsigned int queueDepth, bool allowUring) {
+#ifdef __linux__
+    if (allowUring) {
+        ring = std::make_unique<Ring>();
+        if (!ring->init(queueDepth))
+            ring.reset();
+    }
+#else
+    (void) queueDepth;
+    (void) allowUring;
+#endif
+}
+
+BatchFileIo::~BatchFileIo() = default;
+
+void BatchFileIo::readFiles(std::vector<FileRead> &files) {
+    for (FileRead &file : files) {
+        file.data.clear();
+        file.ok = false;
+    }
+
+#ifdef __linux__
+    if (ring) {
+        size_t n = files.size();
+        std::vector<int> fds(n, -1);
+        std::vector<struct statx> stats(n);
+        std::vector<size_t> done(n, 0);
+
+        // Opens and stats together: ops [0, n) open, [n, 2n) stat
+        ring->run(2 * n, [&](io_uring_sqe &sqe, size_t op) {
+            size_t i = op % n;
+            sqe.fd = AT_FDCWD;
+            sqe.addr = (uint64_t) files[i].path.c_str();
+            if (op < n) {
+                sqe.opcode = IORING_OP_OPENAT;
+                sqe.open_flags = O_RDONLY | O_CLOEXEC;
+            } else {
+                sqe.opcode = IORING_OP_STATX;
+                sqe.len = STATX_SIZE;
+                sqe.off = (uint64_t) &stats[i];
+            }
+        }, [&](size_t op, int result) {
+            size_t i = op % n;
+            if (op < n) {
+                if (result >= 0) fds[i] = result;
+                else reportFailure("Failed to open", files[i].path, -result);
+            } else if (result < 0) {
+                stats[i].stx_size = 0;
+                stats[i].stx_mask = 0;
+            }
+            return true;
+        }, syscalls);
+
+        std::vector<size_t> reads;
+        for (size_t i = 0; i < n; i++) {
+            if (fds[i] < 0)
+                continue;
+            if (!(stats[i].stx_mask & STATX_SIZE)) {
+                reportFailure("Failed to stat", files[i].path, EIO);
+                continue;
+            }
+            files[i].data.resize((size_t) stats[i].stx_size);
+            if (files[i].data.empty())
+                files[i].ok = true;
+            else
+                reads.push_back(i);
+        }
+
+        // Short reads resubmit the remainder
+        ring->run(reads.size(), [&](io_uring_sqe &sqe, size_t op) {
+            size_t i = reads[op];
+            sqe.opcode = IORING_OP_READ;
+            sqe.fd = fds[i];
+            sqe.addr = (uint64_t) (files[i].data.data() + done[i]);
+            sqe.len = (uint32_t) std::min(files[i].data.size() - done[i], MAX_IO_BYTES);
+            sqe.off = done[i];
+        }, [&](size_t op, int result) {
+            size_t i = reads[op];
+            if (result < 0) {
+                reportFailure("Failed to read", files[i].path, -result);
+                return true;
+            }
+            done[i] += (size_t) result;
+            if (result == 0 || done[i] == files[i].data.size()) {
+                files[i].data.resize(done[i]); // the file shrank since statx
+                files[i].ok = true;
+                return true;
+            }
+            return false;
+        }, syscalls);
+
+        std::vector<size_t> opened;
+        for (size_t i = 0; i < n; i++)
+            if (fds[i] >= 0) opened.push_back(i);
+        ring->run(opened.size(), [&](io_uring_sqe &sqe, size_t op) {
+            sqe.opcode = IORING_OP_CLOSE;
+            sqe.fd = fds[opened[op]];
+        }, [](size_t, int) { return true; }, syscalls);
+        return;
+    }
+#endif
+
+    for (FileRead &file : files) {
+        int fd = open(file.path.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat info;
+        syscalls += 2;
+        if (fd < 0 || fstat(fd, &info) != 0) {
+            reportFailure("Failed to open", file.path, errno);
+            if (fd >= 0) close(fd);
+            continue;
+        }
+        file.data.resize((size_t) info.st_size);
+        size_t done = 0;
+        while (done < file.data.size()) {
+            ssize_t n = pread(fd, file.data.data() + done, std::min(file.data.size() - done, MAX_IO_BYTES), (off_t) done);
+            syscalls++;
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                break;
+            done += (size_t) n;
+        }
+        file.ok = done == file.data.size();
+        if (!file.ok)
+            reportFailure("Failed to read", file.path, errno ? errno : EIO);
+        close(fd);
+        syscalls++;
+    }
+}
+
+void BatchFileIo::writeFiles(std::vector<FileWrite> &files) {
+    for (FileWrite &file : files)
+        file.ok = false;
+
+#ifdef __linux__
+    if (ring) {
+        size_t n = files.size();
+        std::vector<int> fds(n, -1);
+        std::vector<size_t> done(n, 0);
+
+        ring->run(n, [&](io_uring_sqe &sqe, size_t i) {
+            sqe.opcode = IORING_OP_OPENAT;
+            sqe.fd = AT_FDCWD;
+            sqe.addr = (uint64_t) files[i].path.c_str();
+            sqe.open_flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+            sqe.len = 0644;
+        }, [&](size_t i, int result) {
+            if (result >= 0) fds[i] = result;
+            else reportFailure("Failed to create", files[i].path, -result);
+            return true;
+        }, syscalls);
+
+        std::vector<size_t> writes, opened;
+        for (size_t i = 0; i < n; i++) {
+            if (fds[i] < 0)
+                continue;
+            opened.push_back(i);
+            if (files[i].data.empty())
+                files[i].ok = true;
+            else
+                writes.push_back(i);
+        }
+
+        ring->run(writes.size(), [&](io_uring_sqe &sqe, size_t op) {
+            size_t i = writes[op];
+            sqe.opcode = IORING_OP_WRITE;
+            sqe.fd = fds[i];
+            sqe.addr = (uint64_t) (files[i].data.data() + done[i]);
+            sqe.len = (uint32_t) std::min(files[i].data.size() - done[i], MAX_IO_BYTES);
+            sqe.off = done[i];
+        }, [&](size_t op, int result) {
+            size_t i = writes[op];
+            if (result <= 0) {
+                reportFailure("Failed to write", files[i].path, result < 0 ? -result : EIO);
+                return true;
+            }
+            done[i] += (size_t) result;
+            files[i].ok = done[i] == files[i].data.size();
+            return files[i].ok;
+        }, syscalls);
+
+        ring->run(opened.size(), [&](io_uring_sqe &sqe, size_t op) {
+            sqe.opcode = IORING_OP_CLOSE;
+            sqe.fd = fds[opened[op]];
+        }, [&](size_t op, int result) {
+            if (result < 0) {
+                files[opened[op]].ok = false;
+                reportFailure("Failed to close", files[opened[op]].path, -result);
+            }
+            return true;
+        }, syscalls);
+        return;
+    }
+#endif
+
+    for (FileWrite &file : files) {
+        int fd = open(file.path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        syscalls++;
+        if (fd < 0) {
+            reportFailure("Failed to create", file.path, errno);
+            continue;
+        }
+        size_t done = 0;
+        while (done < file.data.size()) {
+            ssize_t n = pwrite(fd, file.data.data() + done, std::min(file.data.size() - done, MAX_IO_BYTES), (off_t) done);
+            syscalls++;
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                break;
+            done += (size_t) n;
+        }
+        bool closed = close(fd) == 0;
+        syscalls++;
+        file.ok = done == file.data.size() && closed;
+        if (!file.ok)
+            reportFailure("Failed to write", file.path, errno ? errno : EIO);
+    }
+}
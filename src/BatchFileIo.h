@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct FileRead {
+    std::string path;
+    std::vector<unsigned char> data;
+    bool ok = false;
+};
+
+struct FileWrite {
+    std::string path;
+    std::vector<unsigned char> data;
+    bool ok = false;
+};
+
+// Whole-file reads and writes for many small files at once. On Linux the opens,
+// stats, reads, writes and closes of a batch go through io_uring with up to
+// queueDepth requests in flight, so a batch costs a handful of syscalls instead
+// of four or five per file. Without io_uring (other systems, old kernels,
+// seccomp) it falls back to open/fstat/pread/pwrite/close per file.
+// One instance per thread.
+class BatchFileIo {
+public:
+    explicit BatchFileIo(unsigned int queueDepth = 64, bool allowUring = true);
+    ~BatchFileIo();
+
+    // Fills data and ok for every entry; failures are reported and leave ok false.
+    void readFiles(std::vector<FileRead> &files);
+    // Creates or truncates each path; ok is set per entry.
+    void writeFiles(std::vector<FileWrite> &files);
+
+    bool usingUring() const { return ring != nullptr; }
+
+    // Kernel entries so far: io_uring_enter calls, or plain I/O syscalls in the fallback
+    uint64_t syscalls = 0;
+
+private:
+    struct Ring;
+    std::unique_ptr<Ring> ring;
+};
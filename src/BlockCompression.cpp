@@ -0,0 +1,636 @@
+#include "BlockCompression.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+int blockBytes(BlockFormat format) {
+    return format == BlockFormat::BC1 ? 8 : 16;
+}
+
+const char *blockFormatName(BlockFormat format) {
+    switch (format) {
+        case BlockFormat::BC1: return "BC1";
+        case BlockFormat::BC3: return "BC3";
+        case BlockFormat::BC7: return "BC7";
+    }
+    return "?";
+}
+
+// ---------------------------
+// Shared helpers
+// ---------------------------
+namespace {
+
+struct BitWriter {
+    unsigned char *out;
+    int pos = 0;
+
+    void write(uint32_t value, int bits) {
+        for (int i = 0; i < bits; i++, pos++)
+            if (value >> i & 1)
+                out[pos >> 3] |= (unsigned char) (1 << (pos & 7));
+    }
+};
+
+struct BitReader {
+    const unsigned char *in;
+    int pos = 0;
+
+    uint32_t read(int bits) {
+        uint32_t value = 0;
+        for (int i = 0; i < bits; i++, pos++)
+            value |= (uint32_t) (in[pos >> 3] >> (pos & 7) & 1) << i;
+        return value;
+    }
+};
+
+// Principal axis of the block via power iteration on the covariance matrix.
+// Returns false when the block is a single flat color.
+template<int C>
+bool principalAxis(const float (&px)[16][C], float (&mean)[C], float (&axis)[C]) {
+    for (int c = 0; c < C; c++) {
+        mean[c] = 0.0f;
+        for (int i = 0; i < 16; i++) mean[c] += px[i][c];
+        mean[c] /= 16.0f;
+    }
+
+    float cov[C][C] = {};
+    for (int i = 0; i < 16; i++)
+        for (int a = 0; a < C; a++)
+            for (int b = 0; b < C; b++)
+                cov[a][b] += (px[i][a] - mean[a]) * (px[i][b] - mean[b]);
+
+    for (int c = 0; c < C; c++) axis[c] = 1.0f;
+    for (int iter = 0; iter < 8; iter++) {
+        float next[C] = {};
+        for (int a = 0; a < C; a++)
+            for (int b = 0; b < C; b++)
+                next[a] += cov[a][b] * axis[b];
+        float len = 0.0f;
+        for (int c = 0; c < C; c++) len += next[c] * next[c];
+        if (len < 1e-8f)
+            return false;
+        len = 1.0f / std::sqrt(len);
+        for (int c = 0; c < C; c++) axis[c] = next[c] * len;
+    }
+    return true;
+}
+
+// ---------------------------
+// BC1 color block
+// ---------------------------
+uint16_t packRGB565(const float *c) {
+    int r = std::clamp((int) std::lround(c[0] * 31.0f / 255.0f), 0, 31);
+    int g = std::clamp((int) std::lround(c[1] * 63.0f / 255.0f), 0, 63);
+    int b = std::clamp((int) std::lround(c[2] * 31.0f / 255.0f), 0, 31);
+    return (uint16_t) (r << 11 | g << 5 | b);
+}
+
+void unpackRGB565(uint16_t v, int *c) {
+    int r = v >> 11 & 31, g = v >> 5 & 63, b = v & 31;
+    c[0] = r << 3 | r >> 2;
+    c[1] = g << 2 | g >> 4;
+    c[2] = b << 3 | b >> 2;
+}
+
+// Fills the 4-entry palette and picks the closest entry per texel. Returns the squared error.
+int fitColorIndices(const float (&px)[16][3], uint16_t c0, uint16_t c1, uint32_t &indices) {
+    int palette[4][3];
+    unpackRGB565(c0, palette[0]);
+    unpackRGB565(c1, palette[1]);
+    for (int c = 0; c < 3; c++) {
+        palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+
+    int total = 0;
+    indices = 0;
+    for (int i = 0; i < 16; i++) {
+        int best = 0, bestErr = 1 << 30;
+        for (int p = 0; p < 4; p++) {
+            int err = 0;
+            for (int c = 0; c < 3; c++) {
+                int d = (int) px[i][c] - palette[p][c];
+                err += d * d;
+            }
+            if (err < bestErr) { bestErr = err; best = p; }
+        }
+        indices |= (uint32_t) best << (2 * i);
+        total += bestErr;
+    }
+    return total;
+}
+
+void encodeColorBlock(const unsigned char *rgba, unsigned char *out) {
+    float px[16][3];
+    for (int i = 0; i < 16; i++)
+        for (int c = 0; c < 3; c++)
+            px[i][c] = rgba[i * 4 + c];
+
+    float mean[3], axis[3];
+    uint16_t c0, c1;
+    if (!principalAxis(px, mean, axis)) {
+        c0 = c1 = packRGB565(mean);
+    } else {
+        float tMin = 1e9f, tMax = -1e9f;
+        for (auto &p : px) {
+            float t = 0.0f;
+            for (int c = 0; c < 3; c++) t += (p[c] - mean[c]) * axis[c];
+            tMin = std::min(tMin, t);
+            tMax = std::max(tMax, t);
+        }
+        float e0[3], e1[3];
+        for (int c = 0; c < 3; c++) {
+            e0[c] = mean[c] + axis[c] * tMax;
+            e1[c] = mean[c] + axis[c] * tMin;
+        }
+        c0 = packRGB565(e0);
+        c1 = packRGB565(e1);
+    }
+
+    uint32_t indices;
+    int err = fitColorIndices(px, c0, c1, indices);
+
+    // One least-squares refinement of the endpoints against the chosen indices
+    static const float weights[4] = {1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f};
+    float aa = 0, ab = 0, bb = 0, ax[3] = {}, bx[3] = {};
+    for (int i = 0; i < 16; i++) {
+        float a = weights[indices >> (2 * i) & 3], b = 1.0f - a;
+        aa += a * a; ab += a * b; bb += b * b;
+        for (int c = 0; c < 3; c++) { ax[c] += a * px[i][c]; bx[c] += b * px[i][c]; }
+    }
+    float det = aa * bb - ab * ab;
+    if (std::fabs(det) > 1e-6f) {
+        float e0[3], e1[3];
+        for (int c = 0; c < 3; c++) {
+            e0[c] = std::clamp((ax[c] * bb - bx[c] * ab) / det, 0.0f, 255.0f);
+            e1[c] = std::clamp((bx[c] * aa - ax[c] * ab) / det, 0.0f, 255.0f);
+        }
+        uint16_t r0 = packRGB565(e0), r1 = packRGB565(e1);
+        uint32_t refined;
+        int refinedErr = fitColorIndices(px, r0, r1, refined);
+        if (refinedErr < err) { c0 = r0; c1 = r1; indices = refined; }
+    }
+
+    // Four-color mode requires c0 > c1; swapping endpoints swaps index pairs (0,1) and (2,3)
+    if (c0 < c1) {
+        std::swap(c0, c1);
+        indices ^= 0x55555555;
+    } else if (c0 == c1) {
+        indices = 0;
+    }
+
+    out[0] = (unsigned char) (c0 & 0xFF);
+    out[1] = (unsigned char) (c0 >> 8);
+    out[2] = (unsigned char) (c1 & 0xFF);
+    out[3] = (unsigned char) (c1 >> 8);
+    for (int i = 0; i < 4; i++)
+        out[4 + i] = (unsigned char) (indices >> (8 * i));
+}
+
+void decodeColorBlock(const unsigned char *block, unsigned char *rgba, bool allowThreeColor) {
+    uint16_t c0 = (uint16_t) (block[0] | block[1] << 8);
+    uint16_t c1 = (uint16_t) (block[2] | block[3] << 8);
+    int palette[4][4];
+    unpackRGB565(c0, palette[0]);
+    unpackRGB565(c1, palette[1]);
+    palette[0][3] = palette[1][3] = palette[2][3] = palette[3][3] = 255;
+
+    if (c0 > c1 || !allowThreeColor) {
+        for (int c = 0; c < 3; c++) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+    } else {
+        for (int c = 0; c < 3; c++) {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+        palette[3][3] = 0;
+    }
+
+    uint32_t indices = block[4] | block[5] << 8 | block[6] << 16 | (uint32_t) block[7] << 24;
+    for (int i = 0; i < 16; i++) {
+        const int *p = palette[indices >> (2 * i) & 3];
+        for (int c = 0; c < 4; c++)
+            rgba[i * 4 + c] = (unsigned char) p[c];
+    }
+}
+
+// ---------------------------
+// BC3 alpha block
+// ---------------------------
+void encodeAlphaBlock(const unsigned char *rgba, unsigned char *out) {
+    int a0 = 0, a1 = 255;
+    for (int i = 0; i < 16; i++) {
+        a0 = std::max(a0, (int) rgba[i * 4 + 3]);
+        a1 = std::min(a1, (int) rgba[i * 4 + 3]);
+    }
+
+    uint64_t indices = 0;
+    if (a0 != a1) {
+        for (int i = 0; i < 16; i++) {
+            // Ordinal 0..7 along a0 -> a1, then remapped to the BC3 code order (0, 2..7, 1)
+            int ord = (int) std::lround((a0 - rgba[i * 4 + 3]) * 7.0f / (a0 - a1));
+            int code = ord == 0 ? 0 : ord == 7 ? 1 : ord + 1;
+            indices |= (uint64_t) code << (3 * i);
+        }
+    }
+
+    out[0] = (unsigned char) a0;
+    out[1] = (unsigned char) a1;
+    for (int i = 0; i < 6; i++)
+        out[2 + i] = (unsigned char) (indices >> (8 * i));
+}
+
+void decodeAlphaBlock(const unsigned char *block, unsigned char *rgba) {
+    int a0 = block[0], a1 = block[1];
+    int palette[8] = {a0, a1};
+    if (a0 > a1) {
+        for (int i = 2; i < 8; i++) palette[i] = ((8 - i) * a0 + (i - 1) * a1) / 7;
+    } else {
+        for (int i = 2; i < 6; i++) palette[i] = ((6 - i) * a0 + (i - 1) * a1) / 5;
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+
+    uint64_t indices = 0;
+    for (int i = 0; i < 6; i++)
+        indices |= (uint64_t) block[2 + i] << (8 * i);
+    for (int i = 0; i < 16; i++)
+        rgba[i * 4 + 3] = (unsigned char) palette[indices >> (3 * i) & 7];
+}
+
+// ---------------------------
+// BC7
+// ---------------------------
+struct BC7Mode {
+    int subsets, partitionBits, rotationBits, indexSelectionBits;
+    int colorBits, alphaBits, endpointPBits, sharedPBits, indexBits, index2Bits;
+};
+
+const BC7Mode bc7Modes[8] = {
+    {3, 4, 0, 0, 4, 0, 1, 0, 3, 0},
+    {2, 6, 0, 0, 6, 0, 0, 1, 3, 0},
+    {3, 6, 0, 0, 5, 0, 0, 0, 2, 0},
+    {2, 6, 0, 0, 7, 0, 1, 0, 2, 0},
+    {1, 0, 2, 1, 5, 6, 0, 0, 2, 3},
+    {1, 0, 2, 0, 7, 8, 0, 0, 2, 2},
+    {1, 0, 0, 0, 7, 7, 1, 0, 4, 0},
+    {2, 6, 0, 0, 5, 5, 1, 0, 2, 0},
+};
+
+// Bit i set => texel i belongs to subset 1
+const uint16_t bc7Partitions2[64] = {
+    0xcccc, 0x8888, 0xeeee, 0xecc8, 0xc880, 0xfeec, 0xfec8, 0xec80,
+    0xc800, 0xffec, 0xfe80, 0xe800, 0xffe8, 0xff00, 0xfff0, 0xf000,
+    0xf710, 0x008e, 0x7100, 0x08ce, 0x008c, 0x7310, 0x3100, 0x8cce,
+    0x088c, 0x3110, 0x6666, 0x366c, 0x17e8, 0x0ff0, 0x718e, 0x399c,
+    0xaaaa, 0xf0f0, 0x5a5a, 0x33cc, 0x3c3c, 0x55aa, 0x9696, 0xa55a,
+    0x73ce, 0x13c8, 0x324c, 0x3bdc, 0x6996, 0xc33c, 0x9966, 0x0660,
+    0x0272, 0x04e4, 0x4e40, 0x2720, 0xc936, 0x936c, 0x39c6, 0x639c,
+    0x9336, 0x9cc6, 0x817e, 0xe718, 0xccf0, 0x0fcc, 0x7744, 0xee22,
+};
+
+// Two bits per texel, texel 0 in the low bits
+const uint32_t bc7Partitions3[64] = {
+    0xaa685050, 0x6a5a5040, 0x5a5a4200, 0x5450a0a8, 0xa5a50000, 0xa0a05050, 0x5555a0a0, 0x5a5a5050,
+    0xaa550000, 0xaa555500, 0xaaaa5500, 0x90909090, 0x94949494, 0xa4a4a4a4, 0xa9a59450, 0x2a0a4250,
+    0xa5945040, 0x0a425054, 0xa5a5a500, 0x55a0a0a0, 0xa8a85454, 0x6a6a4040, 0xa4a45000, 0x1a1a0500,
+    0x0050a4a4, 0xaaa59090, 0x14696914, 0x69691400, 0xa08585a0, 0xaa821414, 0x50a4a450, 0x6a5a0200,
+    0xa9a58000, 0x5090a0a8, 0xa8a09050, 0x24242424, 0x00aa5500, 0x24924924, 0x24499224, 0x50a50a50,
+    0x500aa550, 0xaaaa4444, 0x66660000, 0xa5a0a5a0, 0x50a050a0, 0x69286928, 0x44aaaa44, 0x66666600,
+    0xaa444444, 0x54a854a8, 0x95809580, 0x96969600, 0xa85454a8, 0x80959580, 0xaa141414, 0x96960000,
+    0xaaaa1414, 0xa05050a0, 0xa0a5a5a0, 0x96000000, 0x40804080, 0xa9a8a9a8, 0xaaaaaa44, 0x2a4a5254,
+};
+
+const unsigned char bc7Anchor2[64] = {
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+    15,  2,  8,  2,  2,  8,  8, 15,  2,  8,  2,  2,  8,  8,  2,  2,
+    15, 15,  6,  8,  2,  8, 15, 15,  2,  8,  2,  2,  2, 15, 15,  6,
+     6,  2,  6,  8, 15, 15,  2,  2, 15, 15, 15, 15, 15,  2,  2, 15,
+};
+
+const unsigned char bc7Anchor3a[64] = {
+     3,  3, 15, 15,  8,  3, 15, 15,  8,  8,  6,  6,  6,  5,  3,  3,
+     3,  3,  8, 15,  3,  3,  6, 10,  5,  8,  8,  6,  8,  5, 15, 15,
+     8, 15,  3,  5,  6, 10,  8, 15, 15,  3, 15,  5, 15, 15, 15, 15,
+     3, 15,  5,  5,  5,  8,  5, 10,  5, 10,  8, 13, 15, 12,  3,  3,
+};
+
+const unsigned char bc7Anchor3b[64] = {
+    15,  8,  8,  3, 15, 15,  3,  8, 15, 15, 15, 15, 15, 15, 15,  8,
+    15,  8, 15,  3, 15,  8, 15,  8,  3, 15,  6, 10, 15, 15, 10,  8,
+    15,  3, 15, 10, 10,  8,  9, 10,  6, 15,  8, 15,  3,  6,  6,  8,
+    15,  3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,  3, 15, 15,  8,
+};
+
+const int bc7Weights2[4] = {0, 21, 43, 64};
+const int bc7Weights3[8] = {0, 9, 18, 27, 37, 46, 55, 64};
+const int bc7Weights4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+const int *bc7Weights(int bits) {
+    return bits == 2 ? bc7Weights2 : bits == 3 ? bc7Weights3 : bc7Weights4;
+}
+
+int bc7Interpolate(int e0, int e1, int weight) {
+    return ((64 - weight) * e0 + weight * e1 + 32) >> 6;
+}
+
+int bc7Subset(int subsets, int partition, int texel) {
+    if (subsets == 2) return bc7Partitions2[partition] >> texel & 1;
+    if (subsets == 3) return bc7Partitions3[partition] >> (2 * texel) & 3;
+    return 0;
+}
+
+bool bc7IsAnchor(int subsets, int partition, int texel) {
+    if (texel == 0) return true;
+    if (subsets == 2) return texel == bc7Anchor2[partition];
+    if (subsets == 3) return texel == bc7Anchor3a[partition] || texel == bc7Anchor3b[partition];
+    return false;
+}
+
+// Mode 6 only: one subset, RGBA 7.7.7.7 endpoints with a p-bit each and 4-bit indices.
+// It handles alpha and smooth gradients well, which covers our scene textures.
+int fitBC7Mode6(const float (&px)[16][4], const int (&q)[2][4], const int (&p)[2], unsigned char (&indices)[16]) {
+    int e[2][4];
+    for (int k = 0; k < 2; k++)
+        for (int c = 0; c < 4; c++)
+            e[k][c] = q[k][c] << 1 | p[k];
+
+    int palette[16][4];
+    for (int i = 0; i < 16; i++)
+        for (int c = 0; c < 4; c++)
+            palette[i][c] = bc7Interpolate(e[0][c], e[1][c], bc7Weights4[i]);
+
+    int total = 0;
+    for (int i = 0; i < 16; i++) {
+        int best = 0, bestErr = 1 << 30;
+        for (int k = 0; k < 16; k++) {
+            int err = 0;
+            for (int c = 0; c < 4; c++) {
+                int d = (int) px[i][c] - palette[k][c];
+                err += d * d;
+            }
+            if (err < bestErr) { bestErr = err; best = k; }
+        }
+        indices[i] = (unsigned char) best;
+        total += bestErr;
+    }
+    return total;
+}
+
+struct BC7Mode6Fit {
+    int q[2][4];
+    int p[2];
+    unsigned char indices[16];
+    int error = 1 << 30;
+};
+
+void quantizeBC7Mode6(const float (&px)[16][4], const float (&e0)[4], const float (&e1)[4], BC7Mode6Fit &best) {
+    for (int pbits = 0; pbits < 4; pbits++) {
+        BC7Mode6Fit fit;
+        fit.p[0] = pbits & 1;
+        fit.p[1] = pbits >> 1;
+        for (int c = 0; c < 4; c++) {
+            fit.q[0][c] = std::clamp((int) std::lround((e0[c] - fit.p[0]) / 2.0f), 0, 127);
+            fit.q[1][c] = std::clamp((int) std::lround((e1[c] - fit.p[1]) / 2.0f), 0, 127);
+        }
+        fit.error = fitBC7Mode6(px, fit.q, fit.p, fit.indices);
+        if (fit.error < best.error)
+            best = fit;
+    }
+}
+
+}
+
+void encodeBlockBC1(const unsigned char *rgba, unsigned char *out) {
+    encodeColorBlock(rgba, out);
+}
+
+void encodeBlockBC3(const unsigned char *rgba, unsigned char *out) {
+    encodeAlphaBlock(rgba, out);
+    encodeColorBlock(rgba, out + 8);
+}
+
+void encodeBlockBC7(const unsigned char *rgba, unsigned char *out) {
+    float px[16][4];
+    for (int i = 0; i < 16; i++)
+        for (int c = 0; c < 4; c++)
+            px[i][c] = rgba[i * 4 + c];
+
+    float mean[4], axis[4], e0[4], e1[4];
+    if (!principalAxis(px, mean, axis)) {
+        for (int c = 0; c < 4; c++) e0[c] = e1[c] = mean[c];
+    } else {
+        float tMin = 1e9f, tMax = -1e9f;
+        for (auto &p : px) {
+            float t = 0.0f;
+            for (int c = 0; c < 4; c++) t += (p[c] - mean[c]) * axis[c];
+            tMin = std::min(tMin, t);
+            tMax = std::max(tMax, t);
+        }
+        for (int c = 0; c < 4; c++) {
+            e0[c] = std::clamp(mean[c] + axis[c] * tMin, 0.0f, 255.0f);
+            e1[c] = std::clamp(mean[c] + axis[c] * tMax, 0.0f, 255.0f);
+        }
+    }
+
+    BC7Mode6Fit best;
+    quantizeBC7Mode6(px, e0, e1, best);
+
+    // Least-squares refinement of the endpoints against the chosen indices
+    float aa = 0, ab = 0, bb = 0, ax[4] = {}, bx[4] = {};
+    for (int i = 0; i < 16; i++) {
+        float b = bc7Weights4[best.indices[i]] / 64.0f, a = 1.0f - b;
+        aa += a * a; ab += a * b; bb += b * b;
+        for (int c = 0; c < 4; c++) { ax[c] += a * px[i][c]; bx[c] += b * px[i][c]; }
+    }
+    float det = aa * bb - ab * ab;
+    if (std::fabs(det) > 1e-6f) {
+        float r0[4], r1[4];
+        for (int c = 0; c < 4; c++) {
+            r0[c] = std::clamp((ax[c] * bb - bx[c] * ab) / det, 0.0f, 255.0f);
+            r1[c] = std::clamp((bx[c] * aa - ax[c] * ab) / det, 0.0f, 255.0f);
+        }
+        quantizeBC7Mode6(px, r0, r1, best);
+    }
+
+    // The anchor texel's index MSB is implicit zero: flip the endpoints if needed
+    if (best.indices[0] & 8) {
+        for (int c = 0; c < 4; c++) std::swap(best.q[0][c], best.q[1][c]);
+        std::swap(best.p[0], best.p[1]);
+        for (auto &index : best.indices) index = (unsigned char) (15 - index);
+    }
+
+    std::memset(out, 0, 16);
+    BitWriter bits{out};
+    bits.write(1 << 6, 7);
+    for (int c = 0; c < 4; c++) {
+        bits.write(best.q[0][c], 7);
+        bits.write(best.q[1][c], 7);
+    }
+    bits.write(best.p[0], 1);
+    bits.write(best.p[1], 1);
+    bits.write(best.indices[0], 3);
+    for (int i = 1; i < 16; i++)
+        bits.write(best.indices[i], 4);
+}
+
+void decodeBlockBC1(const unsigned char *block, unsigned char *rgba) {
+    decodeColorBlock(block, rgba, true);
+}
+
+void decodeBlockBC3(const unsigned char *block, unsigned char *rgba) {
+    decodeColorBlock(block + 8, rgba, false);
+    decodeAlphaBlock(block, rgba);
+}
+
+void decodeBlockBC7(const unsigned char *block, unsigned char *rgba) {
+    int modeIndex = 0;
+    while (modeIndex < 8 && !(block[0] >> modeIndex & 1))
+        modeIndex++;
+    if (modeIndex == 8) {
+        // Reserved encoding decodes to transparent black
+        std::memset(rgba, 0, 64);
+        return;
+    }
+
+    const BC7Mode &mode = bc7Modes[modeIndex];
+    BitReader bits{block, modeIndex + 1};
+    int partition = (int) bits.read(mode.partitionBits);
+    int rotation = (int) bits.read(mode.rotationBits);
+    int indexSelection = (int) bits.read(mode.indexSelectionBits);
+
+    int endpoints = mode.subsets * 2;
+    int e[6][4];
+    for (int c = 0; c < 3; c++)
+        for (int k = 0; k < endpoints; k++)
+            e[k][c] = (int) bits.read(mode.colorBits);
+    for (int k = 0; k < endpoints; k++)
+        e[k][3] = mode.alphaBits ? (int) bits.read(mode.alphaBits) : 255;
+
+    int colorBits = mode.colorBits, alphaBits = mode.alphaBits;
+    if (mode.endpointPBits || mode.sharedPBits) {
+        int pbits[6];
+        if (mode.endpointPBits) {
+            for (int k = 0; k < endpoints; k++) pbits[k] = (int) bits.read(1);
+        } else {
+            for (int s = 0; s < mode.subsets; s++) pbits[2 * s] = pbits[2 * s + 1] = (int) bits.read(1);
+        }
+        for (int k = 0; k < endpoints; k++) {
+            for (int c = 0; c < 3; c++) e[k][c] = e[k][c] << 1 | pbits[k];
+            if (alphaBits) e[k][3] = e[k][3] << 1 | pbits[k];
+        }
+        colorBits++;
+        if (alphaBits) alphaBits++;
+    }
+
+    // Expand to 8 bits by replicating the high bits into the low ones
+    for (int k = 0; k < endpoints; k++) {
+        for (int c = 0; c < 3; c++)
+            e[k][c] = e[k][c] << (8 - colorBits) | e[k][c] >> (2 * colorBits - 8);
+        if (alphaBits)
+            e[k][3] = e[k][3] << (8 - alphaBits) | e[k][3] >> (2 * alphaBits - 8);
+    }
+
+    int index[16], index2[16];
+    for (int i = 0; i < 16; i++) {
+        int n = bc7IsAnchor(mode.subsets, partition, i) ? mode.indexBits - 1 : mode.indexBits;
+        index[i] = (int) bits.read(n);
+    }
+    if (mode.index2Bits) {
+        for (int i = 0; i < 16; i++)
+            index2[i] = (int) bits.read(i == 0 ? mode.index2Bits - 1 : mode.index2Bits);
+    }
+
+    for (int i = 0; i < 16; i++) {
+        int s = bc7Subset(mode.subsets, partition, i);
+        const int *e0 = e[2 * s], *e1 = e[2 * s + 1];
+        int colorWeight, alphaWeight;
+        if (!mode.index2Bits) {
+            colorWeight = alphaWeight = bc7Weights(mode.indexBits)[index[i]];
+        } else if (indexSelection) {
+            colorWeight = bc7Weights(mode.index2Bits)[index2[i]];
+            alphaWeight = bc7Weights(mode.indexBits)[index[i]];
+        } else {
+            colorWeight = bc7Weights(mode.indexBits)[index[i]];
+            alphaWeight = bc7Weights(mode.index2Bits)[index2[i]];
+        }
+
+        int texel[4];
+        for (int c = 0; c < 3; c++) texel[c] = bc7Interpolate(e0[c], e1[c], colorWeight);
+        texel[3] = bc7Interpolate(e0[3], e1[3], alphaWeight);
+        if (rotation) std::swap(texel[3], texel[rotation - 1]);
+
+        for (int c = 0; c < 4; c++)
+            rgba[i * 4 + c] = (unsigned char) texel[c];
+    }
+}
+
+std::vector<unsigned char> compressImage(const unsigned char *rgba, int width, int height,
+                                         BlockFormat format, ThreadPool *pool) {
+    int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    int bytes = blockBytes(format);
+    std::vector<unsigned char> out((size_t) blocksX * blocksY * bytes);
+
+    auto encodeRows = [&](int begin, int end) {
+        unsigned char texels[64];
+        for (int by = begin; by < end; by++) {
+            for (int bx = 0; bx < blocksX; bx++) {
+                for (int y = 0; y < 4; y++) {
+                    int sy = std::min(by * 4 + y, height - 1);
+                    for (int x = 0; x < 4; x++) {
+                        int sx = std::min(bx * 4 + x, width - 1);
+                        std::memcpy(texels + (y * 4 + x) * 4, rgba + ((size_t) sy * width + sx) * 4, 4);
+                    }
+                }
+                unsigned char *block = out.data() + ((size_t) by * blocksX + bx) * bytes;
+                switch (format) {
+                    case BlockFormat::BC1: encodeBlockBC1(texels, block); break;
+                    case BlockFormat::BC3: encodeBlockBC3(texels, block); break;
+                    case BlockFormat::BC7: encodeBlockBC7(texels, block); break;
+                }
+            }
+        }
+    };
+
+    if (pool)
+        pool->parallelFor(blocksY, encodeRows);
+    else
+        encodeRows(0, blocksY);
+    return out;
+}
+
+std::vector<unsigned char> decompressImage(const unsigned char *blocks, int width, int height,
+                                           BlockFormat format, ThreadPool *pool) {
+    int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    int bytes = blockBytes(format);
+    std::vector<unsigned char> out((size_t) width * height * 4);
+
+    auto decodeRows = [&](int begin, int end) {
+        unsigned char texels[64];
+        for (int by = begin; by < end; by++) {
+            for (int bx = 0; bx < blocksX; bx++) {
+                const unsigned char *block = blocks + ((size_t) by * blocksX + bx) * bytes;
+                switch (format) {
+                    case BlockFormat::BC1: decodeBlockBC1(block, texels); break;
+                    case BlockFormat::BC3: decodeBlockBC3(block, texels); break;
+                    case BlockFormat::BC7: decodeBlockBC7(block, texels); break;
+                }
+                for (int y = 0; y < 4 && by * 4 + y < height; y++) {
+                    int w = std::min(4, width - bx * 4);
+                    std::memcpy(out.data() + ((size_t) (by * 4 + y) * width + bx * 4) * 4, texels + y * 16, w * 4);
+                }
+            }
+        }
+    };
+
+    if (pool)
+        pool->parallelFor(blocksY, decodeRows);
+    else
+        decodeRows(0, blocksY);
+    return out;
+}
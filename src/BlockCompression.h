@@ -0,0 +1,26 @@
+#pragma once
+#include <vector>
+
+class ThreadPool;
+
+// Block-compressed formats we can encode offline and decode on the CPU when the
+// driver lacks S3TC/BPTC support.
+enum class BlockFormat { BC1, BC3, BC7 };
+
+int blockBytes(BlockFormat format);
+const char *blockFormatName(BlockFormat format);
+
+// A block is 4x4 RGBA8 texels (64 bytes, row-major).
+void encodeBlockBC1(const unsigned char *rgba, unsigned char *out);
+void encodeBlockBC3(const unsigned char *rgba, unsigned char *out);
+void encodeBlockBC7(const unsigned char *rgba, unsigned char *out);
+
+void decodeBlockBC1(const unsigned char *block, unsigned char *rgba);
+void decodeBlockBC3(const unsigned char *block, unsigned char *rgba);
+void decodeBlockBC7(const unsigned char *block, unsigned char *rgba);
+
+// Whole-image helpers. Edge blocks of non multiple-of-4 images replicate the border texels.
+std::vector<unsigned char> compressImage(const unsigned char *rgba, int width, int height,
+                                         BlockFormat format, ThreadPool *pool = nullptr);
+std::vector<unsigned char> decompressImage(const unsigned char *blocks, int width, int height,
+                                           BlockFormat format, ThreadPool *pool = nullptr);
@@ -0,0 +1,86 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+// Blocking FIFO with a fixed capacity; push() waits while full, pop() while empty.
+// close() wakes everyone: pushes are then rejected and pops drain what is left.
+template<typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : capacity(capacity) {}
+
+    bool push(T item) {
+        std::unique_lock lock(mutex);
+        notFull.wait(lock, [this] { return closed || items.size() < capacity; });
+        if (closed)
+            return false;
+        items.push_back(std::move(item));
+        notEmpty.notify_one();
+        return true;
+    }
+
+    // Non-blocking variant used for backpressure: false when full or closed.
+    bool tryPush(T &item) {
+        std::lock_guard lock(mutex);
+        if (closed || items.size() >= capacity)
+            return false;
+        items.push_back(std::move(item));
+        notEmpty.notify_one();
+        return true;
+    }
+
+    // Waits for room until the deadline; on failure the item is left untouched.
+    bool pushUntil(T &item, std::chrono::steady_clock::time_point deadline) {
+        std::unique_lock lock(mutex);
+        if (!notFull.wait_until(lock, deadline, [this] { return closed || items.size() < capacity; }) || closed)
+            return false;
+        items.push_back(std::move(item));
+        notEmpty.notify_one();
+        return true;
+    }
+
+    std::optional<T> pop() {
+        std::unique_lock lock(mutex);
+        notEmpty.wait(lock, [this] { return closed || !items.empty(); });
+        if (items.empty())
+            return std::nullopt;
+        T item = std::move(items.front());
+        items.pop_front();
+        notFull.notify_one();
+        return item;
+    }
+
+    // Like pop(), but gives up at the deadline; used to coalesce items into batches.
+    std::optional<T> popUntil(std::chrono::steady_clock::time_point deadline) {
+        std::unique_lock lock(mutex);
+        notEmpty.wait_until(lock, deadline, [this] { return closed || !items.empty(); });
+        if (items.empty())
+            return std::nullopt;
+        T item = std::move(items.front());
+        items.pop_front();
+        notFull.notify_one();
+        return item;
+    }
+
+    void close() {
+        std::lock_guard lock(mutex);
+        closed = true;
+        notEmpty.notify_all();
+        notFull.notify_all();
+    }
+
+    size_t size() const {
+        std::lock_guard lock(mutex);
+        return items.size();
+    }
+
+private:
+    size_t capacity;
+    std::deque<T> items;
+    mutable std::mutex mutex;
+    std::condition_variable notEmpty, notFull;
+    bool closed = false;
+};
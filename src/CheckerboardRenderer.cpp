@@ -0,0 +1,97 @@
+#include "CheckerboardRenderer.h"
+#include "GpuMemory.h"
+
+CheckerboardRenderer::CheckerboardRenderer()
+    : maskShader("shaders/vertex.txt", "shaders/fragment_checkerboard_mask.txt"),
+      reconstructShader("shaders/vertex.txt", "shaders/fragment_checkerboard.txt") {
+    quad.initQuad();
+    reconstructShader.use();
+    reconstructShader.setInt("uCurrent", 0);
+    reconstructShader.setInt("uVelocity", 1);
+    reconstructShader.setInt("uDepth", 2);
+    reconstructShader.setInt("uPrevious", 3);
+    glGenTextures(2, frameTexture);
+    glGenFramebuffers(2, frameFbo);
+}
+
+CheckerboardRenderer::~CheckerboardRenderer() {
+    gpuDeleteTextures(2, frameTexture);
+    glDeleteFramebuffers(2, frameFbo);
+    quad.releaseQuad();
+}
+
+void CheckerboardRenderer::resize(int w, int h) {
+    if (w != width || h != height) {
+        width = w;
+        height = h;
+        for (int i = 0; i < 2; i++) {
+            glBindTexture(GL_TEXTURE_2D, frameTexture[i]);
+            gpuTexImage2D(frameTexture[i], GpuMemoryCategory::RenderTarget, "checkerboard frames", 0, GL_RGBA8, w, h,
+                          GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glBindFramebuffer(GL_FRAMEBUFFER, frameFbo[i]);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, frameTexture[i], 0);
+            if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+                std::cout << "ERROR::FRAMEBUFFER:: Checkerboard framebuffer is not complete!" << std::endl;
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+    reset();
+}
+
+void CheckerboardRenderer::reset() {
+    historyValid = false;
+}
+
+void CheckerboardRenderer::nextFrame() {
+    frameIndex++;
+}
+
+void CheckerboardRenderer::beginScene() {
+    glEnable(GL_STENCIL_TEST);
+    glStencilFunc(GL_ALWAYS, 1, 0xFF);
+    glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glDisable(GL_DEPTH_TEST);
+    maskShader.use();
+    maskShader.setInt("uParity", frameIndex & 1);
+    quad.renderQuad();
+
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glEnable(GL_DEPTH_TEST);
+    glStencilFunc(GL_EQUAL, 1, 0xFF);
+    glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+}
+
+void CheckerboardRenderer::endScene() {
+    glDisable(GL_STENCIL_TEST);
+}
+
+void CheckerboardRenderer::reconstruct(unsigned int colorTexture, unsigned int velocityTexture,
+                                       unsigned int depthTexture) {
+    int target = 1 - current;
+    glBindFramebuffer(GL_FRAMEBUFFER, frameFbo[target]);
+    glViewport(0, 0, width, height);
+    glDisable(GL_DEPTH_TEST);
+
+    reconstructShader.use();
+    reconstructShader.setInt("uParity", frameIndex & 1);
+    reconstructShader.setFloat("uHistoryValid", historyValid ? 1.0f : 0.0f);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, colorTexture);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, velocityTexture);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, depthTexture);
+    glActiveTexture(GL_TEXTURE3);
+    glBindTexture(GL_TEXTURE_2D, frameTexture[current]);
+    quad.renderQuad();
+    glActiveTexture(GL_TEXTURE0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    current = target;
+    historyValid = true;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include "config.h"
+#include "Renderer.h"
+
+// Checkerboard rendering: each frame only half of the low-res target's pixels are
+// shaded, alternating between the two halves of a checkerboard. A stencil mask rejects
+// the other half before shading. reconstruct() then fills each missing pixel from the
+// previous frame, reprojected with the neighbours' motion vectors and clamped to their
+// colour range, or, where that fails, by interpolating along the smoother direction.
+// The result is a full render-resolution image for the spatial upscalers.
+// Needs a current GL 3.3 context and a scene target with a stencil buffer (Renderer::initFBO).
+class CheckerboardRenderer {
+public:
+    CheckerboardRenderer();
+    ~CheckerboardRenderer();
+
+    void resize(int width, int height);
+    // Drops the previous frame; the next reconstruction is spatial only.
+    void reset();
+    // Swaps the shaded half; call once per frame before rendering.
+    void nextFrame();
+
+    // With the scene target bound and cleared: writes this frame's half into the stencil
+    // and leaves the stencil test on (and the depth test enabled) for the scene draw.
+    void beginScene();
+    void endScene();
+
+    // Fills in the unshaded half from the scene target's colour, velocity and depth.
+    void reconstruct(unsigned int colorTexture, unsigned int velocityTexture, unsigned int depthTexture);
+    unsigned int outputTexture() const { return frameTexture[current]; }
+    unsigned int outputFbo() const { return frameFbo[current]; }
+
+    int width = 0, height = 0;
+    int frameIndex = 0;
+
+private:
+    unsigned int frameTexture[2] = {}, frameFbo[2] = {};
+    int current = 0;
+    bool historyValid = false;
+
+    Renderer quad;
+    Shader maskShader, reconstructShader;
+};
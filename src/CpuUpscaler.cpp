@@ -0,0 +1,224 @@
+#include "CpuUpscaler.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+// Per-column (or per-row) sampling coordinates, 8-bit fractional weights
+struct Taps {
+    std::vector<int> a, b, f;
+
+    void build(int begin, int end, int srcSize, int dstSize) {
+        int n = end - begin;
+        a.resize(n);
+        b.resize(n);
+        f.resize(n);
+        double scale = (double) srcSize / dstSize;
+        for (int i = 0; i < n; i++) {
+            double s = (begin + i + 0.5) * scale - 0.5;
+            int base = (int) std::floor(s);
+            f[i] = (int) std::lround((s - base) * 256.0);
+            if (f[i] == 256) { base++; f[i] = 0; }
+            a[i] = std::clamp(base, 0, srcSize - 1);
+            b[i] = std::clamp(base + 1, 0, srcSize - 1);
+        }
+    }
+};
+
+int nearestTap(int i, int srcSize, int dstSize) {
+    return std::min((int) ((i + 0.5) * srcSize / dstSize), srcSize - 1);
+}
+
+template<int C>
+void nearestRect(const ImageView &src, const MutableImageView &dst, int x0, int y0, int x1, int y1) {
+    thread_local std::vector<int> xs;
+    xs.resize(x1 - x0);
+    for (int x = x0; x < x1; x++)
+        xs[x - x0] = nearestTap(x, src.width, dst.width);
+
+    for (int y = y0; y < y1; y++) {
+        const unsigned char *row = src.pixel(0, nearestTap(y, src.height, dst.height));
+        unsigned char *out = dst.pixel(x0, y);
+        for (int x = 0; x < x1 - x0; x++) {
+            if constexpr (C == 4)
+                ((uint32_t *) out)[x] = ((const uint32_t *) row)[xs[x]];
+            else
+                out[x] = row[xs[x]];
+        }
+    }
+}
+
+template<int C>
+void bilinearRect(const ImageView &src, const MutableImageView &dst, int x0, int y0, int x1, int y1) {
+    thread_local Taps tx, ty;
+    tx.build(x0, x1, src.width, dst.width);
+    ty.build(y0, y1, src.height, dst.height);
+
+    for (int y = 0; y < y1 - y0; y++) {
+        const unsigned char *rowA = src.pixel(0, ty.a[y]);
+        const unsigned char *rowB = src.pixel(0, ty.b[y]);
+        int fy = ty.f[y];
+        unsigned char *out = dst.pixel(x0, y0 + y);
+        for (int x = 0; x < x1 - x0; x++) {
+            int xa = tx.a[x] * C, xb = tx.b[x] * C, fx = tx.f[x];
+            for (int c = 0; c < C; c++) {
+                int top = rowA[xa + c] * (256 - fx) + rowA[xb + c] * fx;
+                int bot = rowB[xa + c] * (256 - fx) + rowB[xb + c] * fx;
+                out[x * C + c] = (unsigned char) ((top * (256 - fy) + bot * fy + 32768) >> 16);
+            }
+        }
+    }
+}
+
+// Both shaders compute c - s * lap(bilinear) with lap = n + s + e + w - 4c.
+// Sharpen uses the Laplacian as is, EASU clamps it to +-0.5.
+// RGBA sharpens the color channels and writes opaque alpha, like the shaders.
+template<int C>
+void sharpenRect(const ImageView &src, const MutableImageView &dst, int x0, int y0, int x1, int y1,
+                 float sharpness, bool clampLaplacian) {
+    constexpr int L = C == 4 ? 3 : C;
+    thread_local Taps tx, ty;
+    thread_local std::vector<int16_t> lap;
+    tx.build(x0, x1, src.width, dst.width);
+    ty.build(y0, y1, src.height, dst.height);
+
+    // Source footprint of this rectangle
+    int fx0 = tx.a.front(), fx1 = tx.b.back();
+    int fy0 = ty.a.front(), fy1 = ty.b.back();
+    int fw = fx1 - fx0 + 1;
+    lap.resize((size_t) fw * (fy1 - fy0 + 1) * L);
+
+    for (int y = fy0; y <= fy1; y++) {
+        const unsigned char *row = src.pixel(0, y);
+        const unsigned char *up = src.pixel(0, std::max(y - 1, 0));
+        const unsigned char *down = src.pixel(0, std::min(y + 1, src.height - 1));
+        int16_t *out = lap.data() + (size_t) (y - fy0) * fw * L;
+        for (int x = fx0; x <= fx1; x++) {
+            int l = std::max(x - 1, 0) * C, r = std::min(x + 1, src.width - 1) * C, m = x * C;
+            for (int c = 0; c < L; c++)
+                out[(x - fx0) * L + c] = (int16_t) (up[m + c] + down[m + c] + row[l + c] + row[r + c] - 4 * row[m + c]);
+        }
+    }
+
+    const int s = (int) std::lround(sharpness * 256.0f);
+    const int limit = 128 * 255; // 0.5 in 8.8 fixed point
+
+    for (int y = 0; y < y1 - y0; y++) {
+        const unsigned char *rowA = src.pixel(0, ty.a[y]);
+        const unsigned char *rowB = src.pixel(0, ty.b[y]);
+        const int16_t *lapA = lap.data() + (size_t) (ty.a[y] - fy0) * fw * L;
+        const int16_t *lapB = lap.data() + (size_t) (ty.b[y] - fy0) * fw * L;
+        int fy = ty.f[y];
+        unsigned char *out = dst.pixel(x0, y0 + y);
+
+        for (int x = 0; x < x1 - x0; x++) {
+            int xa = tx.a[x], xb = tx.b[x], fx = tx.f[x];
+            int la = (xa - fx0) * L, lb = (xb - fx0) * L;
+            for (int c = 0; c < L; c++) {
+                int top = rowA[xa * C + c] * (256 - fx) + rowA[xb * C + c] * fx;
+                int bot = rowB[xa * C + c] * (256 - fx) + rowB[xb * C + c] * fx;
+                int color = (top * (256 - fy) + bot * fy + 128) >> 8;           // 8.8 fixed point
+
+                int ltop = lapA[la + c] * (256 - fx) + lapA[lb + c] * fx;
+                int lbot = lapB[la + c] * (256 - fx) + lapB[lb + c] * fx;
+                int l = (ltop * (256 - fy) + lbot * fy) >> 8;                    // 8.8 fixed point
+                if (clampLaplacian) l = std::clamp(l, -limit, limit);
+
+                int v = (color * 256 - s * l + 32768) >> 16;
+                out[x * C + c] = (unsigned char) std::clamp(v, 0, 255);
+            }
+            if constexpr (C == 4)
+                out[x * 4 + 3] = 255;
+        }
+    }
+}
+
+template<int C>
+void upscaleRectChannels(const ImageView &src, const MutableImageView &dst, int x0, int y0, int x1, int y1,
+                         UpscaleMode mode, float sharpness) {
+    switch (mode) {
+        case UpscaleMode::Nearest: nearestRect<C>(src, dst, x0, y0, x1, y1); break;
+        case UpscaleMode::Bilinear: bilinearRect<C>(src, dst, x0, y0, x1, y1); break;
+        case UpscaleMode::Sharpen: sharpenRect<C>(src, dst, x0, y0, x1, y1, sharpness, false); break;
+        case UpscaleMode::Easu: sharpenRect<C>(src, dst, x0, y0, x1, y1, sharpness, true); break;
+    }
+}
+
+}
+
+void upscaleRect(const ImageView &src, const MutableImageView &dst, int x0, int y0, int x1, int y1,
+                 UpscaleMode mode, float sharpness) {
+    if (x1 <= x0 || y1 <= y0)
+        return;
+    if (src.channels == 1)
+        upscaleRectChannels<1>(src, dst, x0, y0, x1, y1, mode, sharpness);
+    else
+        upscaleRectChannels<4>(src, dst, x0, y0, x1, y1, mode, sharpness);
+}
+
+void upscaleFootprint(int srcWidth, int srcHeight, int dstWidth, int dstHeight, int x0, int y0, int x1, int y1,
+                      int &sx0, int &sy0, int &sx1, int &sy1) {
+    // Bilinear taps are floor(s) and floor(s) + 1 (+1 more when the weight rounds up),
+    // and the Laplacian reaches one texel further on each side: floor(s) - 1 .. floor(s) + 3
+    auto range = [](int begin, int end, int srcSize, int dstSize, int &first, int &last) {
+        double scale = (double) srcSize / dstSize;
+        first = std::clamp((int) std::floor((begin + 0.5) * scale - 0.5) - 1, 0, srcSize - 1);
+        last = std::clamp((int) std::floor((end - 0.5) * scale - 0.5) + 4, 1, srcSize);
+    };
+    range(x0, x1, srcWidth, dstWidth, sx0, sx1);
+    range(y0, y1, srcHeight, dstHeight, sy0, sy1);
+}
+
+void upscaleImage(const ImageView &src, const MutableImageView &dst, UpscaleMode mode, float sharpness,
+                  ThreadPool *pool) {
+    if (!pool) {
+        upscaleRect(src, dst, 0, 0, dst.width, dst.height, mode, sharpness);
+        return;
+    }
+    pool->parallelFor(dst.height, [&](int begin, int end) {
+        upscaleRect(src, dst, 0, begin, dst.width, end, mode, sharpness);
+    });
+}
+
+void upscaleBatch(const UpscaleTask *tasks, size_t count, ThreadPool *pool) {
+    if (!pool) {
+        for (size_t i = 0; i < count; i++)
+            upscaleRect(tasks[i].src, tasks[i].dst, 0, 0, tasks[i].dst.width, tasks[i].dst.height,
+                        tasks[i].mode, tasks[i].sharpness);
+        return;
+    }
+
+    // Rows of all tasks laid end to end; each chunk fills the tasks it overlaps
+    thread_local std::vector<int> firstRow;
+    firstRow.resize(count + 1);
+    firstRow[0] = 0;
+    for (size_t i = 0; i < count; i++)
+        firstRow[i + 1] = firstRow[i] + tasks[i].dst.height;
+
+    const std::vector<int> &rows = firstRow;
+    pool->parallelFor(rows[count], [&](int begin, int end) {
+        size_t i = std::upper_bound(rows.begin(), rows.end(), begin) - rows.begin() - 1;
+        for (; i < count && rows[i] < end; i++) {
+            const UpscaleTask &t = tasks[i];
+            int b = std::max(begin, rows[i]) - rows[i], e = std::min(end, rows[i + 1]) - rows[i];
+            if (b < e)
+                upscaleRect(t.src, t.dst, 0, b, t.dst.width, e, t.mode, t.sharpness);
+        }
+    });
+}
+
+void upscaleYuv420(const YuvFrame &src, YuvFrame &dst, UpscaleMode mode, float sharpness, ThreadPool *pool) {
+    UpscaleMode chromaMode = mode == UpscaleMode::Nearest ? UpscaleMode::Nearest : UpscaleMode::Bilinear;
+    UpscaleTask planes[3] = {
+        {ImageView(src.y.data(), src.width, src.height, src.width, 1),
+         MutableImageView(dst.y.data(), dst.width, dst.height, dst.width, 1), mode, sharpness},
+        {ImageView(src.u.data(), src.chromaWidth(), src.chromaHeight(), src.chromaWidth(), 1),
+         MutableImageView(dst.u.data(), dst.chromaWidth(), dst.chromaHeight(), dst.chromaWidth(), 1), chromaMode, sharpness},
+        {ImageView(src.v.data(), src.chromaWidth(), src.chromaHeight(), src.chromaWidth(), 1),
+         MutableImageView(dst.v.data(), dst.chromaWidth(), dst.chromaHeight(), dst.chromaWidth(), 1), chromaMode, sharpness},
+    };
+    upscaleBatch(planes, 3, pool);
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <cstddef>
+#include "Image.h"
+#include "UpscaleMode.h"
+#include "Yuv.h"
+
+class ThreadPool;
+
+// Non-owning 8-bit view with an arbitrary row stride: RGBA (4 channels) or a single plane.
+// A view can also cover only a window of a larger image (e.g. one tile): width and
+// height stay the full image's, since they drive sampling and edge clamping, and
+// data points at pixel (originX, originY). The window must cover every pixel read.
+struct ImageView {
+    const unsigned char *data = nullptr;
+    int width = 0, height = 0;
+    size_t stride = 0;
+    int channels = 4;
+    int originX = 0, originY = 0;
+
+    ImageView() = default;
+    ImageView(const unsigned char *data, int width, int height, size_t stride, int channels = 4)
+        : data(data), width(width), height(height), stride(stride), channels(channels) {}
+    ImageView(const Image &image)
+        : ImageView(image.pixels.data(), image.width, image.height, (size_t) image.width * image.channels, image.channels) {}
+
+    const unsigned char *pixel(int x, int y) const {
+        return data + (ptrdiff_t) (y - originY) * (ptrdiff_t) stride + (ptrdiff_t) (x - originX) * channels;
+    }
+};
+
+struct MutableImageView {
+    unsigned char *data = nullptr;
+    int width = 0, height = 0;
+    size_t stride = 0;
+    int channels = 4;
+    int originX = 0, originY = 0;
+
+    MutableImageView() = default;
+    MutableImageView(unsigned char *data, int width, int height, size_t stride, int channels = 4)
+        : data(data), width(width), height(height), stride(stride), channels(channels) {}
+    MutableImageView(Image &image)
+        : MutableImageView(image.pixels.data(), image.width, image.height, (size_t) image.width * image.channels, image.channels) {}
+
+    unsigned char *pixel(int x, int y) const {
+        return data + (ptrdiff_t) (y - originY) * (ptrdiff_t) stride + (ptrdiff_t) (x - originX) * channels;
+    }
+};
+
+// CPU versions of the GL upscale shaders (fragment_upscale/sharpen/easu) for RGBA8
+// images or single 8-bit planes; src and dst must have the same channel count.
+// Sampling follows GL conventions: texel centers, clamp-to-edge.
+//
+// Both sharpening modes are linear in the source up to the final clamp, so the
+// Laplacian is computed once per source texel and then interpolated, instead of
+// taking five bilinear taps per output pixel.
+
+// Fills the output rectangle [x0, x1) x [y0, y1) of dst.
+void upscaleRect(const ImageView &src, const MutableImageView &dst, int x0, int y0, int x1, int y1,
+                 UpscaleMode mode, float sharpness);
+
+// Source pixels [sx0, sx1) x [sy0, sy1) that any mode reads for the output rectangle
+// [x0, x1) x [y0, y1), Laplacian neighbours included. Used to fetch just that window.
+void upscaleFootprint(int srcWidth, int srcHeight, int dstWidth, int dstHeight, int x0, int y0, int x1, int y1,
+                      int &sx0, int &sy0, int &sx1, int &sy1);
+
+// Whole image, split by rows across the pool when given.
+void upscaleImage(const ImageView &src, const MutableImageView &dst, UpscaleMode mode, float sharpness,
+                  ThreadPool *pool = nullptr);
+
+struct UpscaleTask {
+    ImageView src;
+    MutableImageView dst;
+    UpscaleMode mode = UpscaleMode::Bilinear;
+    float sharpness = 0.0f;
+};
+
+// Every task in one parallel dispatch over the combined destination rows, so a
+// batch of small images costs a single pool wakeup.
+void upscaleBatch(const UpscaleTask *tasks, size_t count, ThreadPool *pool = nullptr);
+
+// Planar 4:2:0 without any RGB round trip: luma goes through the requested mode,
+// chroma is bilinear (nearest in nearest mode). dst must already be sized.
+void upscaleYuv420(const YuvFrame &src, YuvFrame &dst, UpscaleMode mode, float sharpness,
+                   ThreadPool *pool = nullptr);
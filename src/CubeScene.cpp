@@ -0,0 +1,146 @@
+#include "CubeScene.h"
+#include "GpuMemory.h"
+#include "TextureLoader.h"
+
+CubeScene::CubeScene()
+    : shader("shaders/3d_vertex.txt", "shaders/3d_fragment.txt") {
+    float cubeVertices[] = {
+        // positions          // texcoords
+        // Front face
+        -0.5f, -0.5f, 0.5f, 0.0f, 0.0f,
+        0.5f, -0.5f, 0.5f, 1.0f, 0.0f,
+        0.5f, 0.5f, 0.5f, 1.0f, 1.0f,
+        0.5f, 0.5f, 0.5f, 1.0f, 1.0f,
+        -0.5f, 0.5f, 0.5f, 0.0f, 1.0f,
+        -0.5f, -0.5f, 0.5f, 0.0f, 0.0f,
+
+        // Back face
+        -0.5f, -0.5f, -0.5f, 1.0f, 0.0f,
+        0.5f, -0.5f, -0.5f, 0.0f, 0.0f,
+        0.5f, 0.5f, -0.5f, 0.0f, 1.0f,
+        0.5f, 0.5f, -0.5f, 0.0f, 1.0f,
+        -0.5f, 0.5f, -0.5f, 1.0f, 1.0f,
+        -0.5f, -0.5f, -0.5f, 1.0f, 0.0f,
+
+        // Left face
+        -0.5f, -0.5f, -0.5f, 0.0f, 0.0f,
+        -0.5f, -0.5f, 0.5f, 1.0f, 0.0f,
+        -0.5f, 0.5f, 0.5f, 1.0f, 1.0f,
+        -0.5f, 0.5f, 0.5f, 1.0f, 1.0f,
+        -0.5f, 0.5f, -0.5f, 0.0f, 1.0f,
+        -0.5f, -0.5f, -0.5f, 0.0f, 0.0f,
+
+        // Right face
+        0.5f, -0.5f, -0.5f, 1.0f, 0.0f,
+        0.5f, -0.5f, 0.5f, 0.0f, 0.0f,
+        0.5f, 0.5f, 0.5f, 0.0f, 1.0f,
+        0.5f, 0.5f, 0.5f, 0.0f, 1.0f,
+        0.5f, 0.5f, -0.5f, 1.0f, 1.0f,
+        0.5f, -0.5f, -0.5f, 1.0f, 0.0f,
+
+        // Top face
+        -0.5f, 0.5f, -0.5f, 0.0f, 1.0f,
+        0.5f, 0.5f, -0.5f, 1.0f, 1.0f,
+        0.5f, 0.5f, 0.5f, 1.0f, 0.0f,
+        0.5f, 0.5f, 0.5f, 1.0f, 0.0f,
+        -0.5f, 0.5f, 0.5f, 0.0f, 0.0f,
+        -0.5f, 0.5f, -0.5f, 0.0f, 1.0f,
+
+        // Bottom face
+        -0.5f, -0.5f, -0.5f, 0.0f, 0.0f,
+        0.5f, -0.5f, -0.5f, 1.0f, 0.0f,
+        0.5f, -0.5f, 0.5f, 1.0f, 1.0f,
+        0.5f, -0.5f, 0.5f, 1.0f, 1.0f,
+        -0.5f, -0.5f, 0.5f, 0.0f, 1.0f,
+        -0.5f, -0.5f, -0.5f, 0.0f, 0.0f
+    };
+
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    gpuBufferData(vbo, GL_ARRAY_BUFFER, "cube vertices", sizeof(cubeVertices), cubeVertices, GL_STATIC_DRAW);
+
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void *) 0);
+    glEnableVertexAttribArray(0);
+
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void *) (3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+
+    glBindVertexArray(0);
+
+    // Prefer the offline block-compressed asset (see the compress_assets target)
+    texture = loadTextureKTX2("assets/low_res_image.ktx2");
+    if (!texture) {
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        int width, height, nrChannels;
+        unsigned char *data = stbi_load("assets/low_res_image.png", &width, &height, &nrChannels, 0);
+        if (data) {
+            GLenum format = (nrChannels == 3) ? GL_RGB : GL_RGBA;
+            gpuTexImage2D(texture, GpuMemoryCategory::Texture, "cube texture", 0, format, width, height, format,
+                          GL_UNSIGNED_BYTE, data);
+            gpuGenerateMipmap(texture);
+        } else {
+            std::cout << "Failed to load texture" << std::endl;
+        }
+        stbi_image_free(data);
+    }
+
+    shader.use();
+    shader.setInt("uTexture", 0);
+}
+
+CubeScene::~CubeScene() {
+    glDeleteVertexArrays(1, &vao);
+    gpuDeleteBuffers(1, &vbo);
+    gpuDeleteTextures(1, &texture);
+}
+
+glm::mat4 CubeScene::model(float time) const {
+    return glm::scale(glm::rotate(glm::mat4(1.0f), time / 10, glm::vec3(0, 1, 0)), glm::vec3(2.0f));
+}
+
+glm::mat4 CubeScene::view() const {
+    return glm::lookAt(glm::vec3(0, 0, 4.0f), glm::vec3(0, 0, 0), glm::vec3(0, 1, 0));
+}
+
+glm::mat4 CubeScene::projection(float aspect) const {
+    return glm::perspective(glm::radians(45.0f), aspect, 0.1f, 100.0f);
+}
+
+void CubeScene::draw(const glm::mat4 &model, const glm::mat4 &view, const glm::mat4 &projection) {
+    draw(model, view, projection, projection);
+}
+
+void CubeScene::draw(const glm::mat4 &model, const glm::mat4 &view, const glm::mat4 &projection,
+                     const glm::mat4 &jitteredProjection) {
+    glm::mat4 mvp = projection * view * model;
+    if (!hasPreviousMvp)
+        previousMvp = mvp;
+
+    shader.use();
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    shader.setMat4("model", model);
+    shader.setMat4("view", view);
+    shader.setMat4("projection", jitteredProjection);
+    shader.setMat4("uMvp", mvp);
+    shader.setMat4("uPreviousMvp", previousMvp);
+
+    glBindVertexArray(vao);
+    glDrawArrays(GL_TRIANGLES, 0, 36);
+    glBindVertexArray(0);
+
+    previousMvp = mvp;
+    hasPreviousMvp = true;
+}
+
+void CubeScene::resetMotion() {
+    hasPreviousMvp = false;
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include "config.h"
+
+// The demo's textured, slowly spinning cube, shared with the GL scene benchmarks.
+// Needs a current GL 3.3 context and assets/ and shaders/ in the working directory.
+class CubeScene {
+public:
+    CubeScene();
+    ~CubeScene();
+
+    // Transform at animation time t (seconds)
+    glm::mat4 model(float time) const;
+    glm::mat4 view() const;
+    glm::mat4 projection(float aspect) const;
+
+    // Draws the cube into the bound framebuffer (depth test is up to the caller). Colour goes
+    // to attachment 0 and the screen-space motion since the previous draw (UV units, from the
+    // unjittered projection) to attachment 1. jitteredProjection only moves the rasterised samples.
+    void draw(const glm::mat4 &model, const glm::mat4 &view, const glm::mat4 &projection);
+    void draw(const glm::mat4 &model, const glm::mat4 &view, const glm::mat4 &projection,
+              const glm::mat4 &jitteredProjection);
+    // The next draw reports no motion (first frame, camera cut, switching targets)
+    void resetMotion();
+
+    unsigned int vao = 0, vbo = 0, texture = 0;
+
+private:
+    Shader shader;
+    glm::mat4 previousMvp = glm::mat4(1.0f);
+    bool hasPreviousMvp = false;
+};
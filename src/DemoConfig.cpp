@@ -0,0 +1,164 @@
+#include "DemoConfig.h"
+#include "Upscaler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+const char *DEMO_MODE_NAMES[DEMO_MODE_COUNT] = {
+    "nearest", "bilinear", "sharpen", "easu", "native", "temporal", "checkerboard", "foveated",
+};
+
+bool parseFloat(const std::string &text, float &value) {
+    char *end = nullptr;
+    value = std::strtof(text.c_str(), &end);
+    return !text.empty() && *end == '\0' && std::isfinite(value);
+}
+
+bool parseSize(const std::string &text, int &width, int &height) {
+    char tail = 0;
+    return std::sscanf(text.c_str(), "%dx%d%c", &width, &height, &tail) == 2 && width > 0 && height > 0;
+}
+
+std::string trim(const std::string &text) {
+    size_t begin = text.find_first_not_of(" \t\r");
+    if (begin == std::string::npos)
+        return "";
+    return text.substr(begin, text.find_last_not_of(" \t\r") - begin + 1);
+}
+
+}
+
+void DemoConfig::resolveRenderSize() {
+    if (renderWidth > 0 && renderHeight > 0)
+        return;
+    renderWidth = std::max(1, (int) std::lround(displayWidth / scale));
+    renderHeight = std::max(1, (int) std::lround(displayHeight / scale));
+}
+
+const char *demoModeName(int mode) {
+    if (mode >= 0 && mode < DEMO_MODE_COUNT)
+        return DEMO_MODE_NAMES[mode];
+    // Registered upscalers after the first four; the names outlive the call
+    static const std::vector<std::string> names = upscalerNames(UpscalerBackend::Cpu);
+    size_t extra = 4 + (size_t) (mode - DEMO_MODE_COUNT);
+    return mode > 0 && extra < names.size() ? names[extra].c_str() : "?";
+}
+
+bool applyDemoSetting(DemoConfig &config, const std::string &key, const std::string &value) {
+    bool ok = true;
+    if (key == "display") {
+        ok = parseSize(value, config.displayWidth, config.displayHeight);
+    } else if (key == "render") {
+        ok = parseSize(value, config.renderWidth, config.renderHeight);
+    } else if (key == "scale") {
+        // A scale replaces an earlier explicit render size
+        ok = parseFloat(value, config.scale) && config.scale >= 1.0f;
+        config.renderWidth = config.renderHeight = 0;
+    } else if (key == "preset") {
+        auto preset = std::find_if(std::begin(SCALE_PRESETS), std::end(SCALE_PRESETS),
+                                   [&](const ScalePreset &p) { return value == p.name; });
+        ok = preset != std::end(SCALE_PRESETS);
+        if (ok)
+            config.scale = preset->scale;
+        config.renderWidth = config.renderHeight = 0;
+    } else if (key == "mode") {
+        // By name or by index
+        auto name = std::find(std::begin(DEMO_MODE_NAMES), std::end(DEMO_MODE_NAMES), value);
+        if (name != std::end(DEMO_MODE_NAMES))
+            config.mode = (int) (name - std::begin(DEMO_MODE_NAMES));
+        else if (value.size() == 1 && value[0] >= '0' && value[0] < '0' + DEMO_MODE_COUNT)
+            config.mode = value[0] - '0';
+        else {
+            // Registered upscalers beyond nearest..easu follow the fixed modes
+            std::vector<std::string> names = upscalerNames(UpscalerBackend::Cpu);
+            auto extra = std::find(names.begin() + std::min<size_t>(4, names.size()), names.end(), value);
+            ok = extra != names.end();
+            if (ok)
+                config.mode = DEMO_MODE_COUNT + (int) (extra - names.begin() - 4);
+        }
+    } else if (key == "sharpen-sharpness") {
+        ok = parseFloat(value, config.sharpenSharpness);
+    } else if (key == "easu-sharpness") {
+        ok = parseFloat(value, config.easuSharpness);
+    } else if (key == "data-dir") {
+        config.dataDir = value;
+    } else if (key == "image") {
+        config.image = value;
+    } else if (key == "benchmark") {
+        ok = parseFloat(value, config.benchmarkSeconds) && config.benchmarkSeconds >= 0.0f;
+    } else if (key == "stats") {
+        ok = !value.empty();
+        config.statsPath = value;
+    } else {
+        std::cout << "ERROR::CONFIG:: Unknown setting " << key << std::endl;
+        return false;
+    }
+    if (!ok)
+        std::cout << "ERROR::CONFIG:: Bad value for " << key << ": " << value << std::endl;
+    return ok;
+}
+
+bool loadDemoConfig(DemoConfig &config, const std::string &path) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cout << "ERROR::CONFIG:: Could not open " << path << std::endl;
+        return false;
+    }
+    std::string line;
+    for (int number = 1; std::getline(file, line); number++) {
+        line = trim(line.substr(0, line.find('#')));
+        if (line.empty())
+            continue;
+        size_t equals = line.find('=');
+        if (equals == std::string::npos) {
+            std::cout << "ERROR::CONFIG:: " << path << ":" << number << ": expected key = value" << std::endl;
+            return false;
+        }
+        if (!applyDemoSetting(config, trim(line.substr(0, equals)), trim(line.substr(equals + 1)))) {
+            std::cout << "ERROR::CONFIG:: in " << path << ":" << number << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool parseDemoArgs(DemoConfig &config, int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h")
+            return false;
+        if (arg.rfind("--", 0) != 0) {
+            config.image = arg;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cout << "ERROR::CONFIG:: Missing value for " << arg << std::endl;
+            return false;
+        }
+        std::string value = argv[++i];
+        if (!(arg == "--config" ? loadDemoConfig(config, value) : applyDemoSetting(config, arg.substr(2), value)))
+            return false;
+    }
+    return true;
+}
+
+void printDemoUsage() {
+    std::cerr << "Usage: upscaler [--config FILE] [--display WxH] [--render WxH | --scale F | --preset NAME]\n"
+                 "                [--mode NAME|0-7] [--sharpen-sharpness F] [--easu-sharpness F]\n"
+                 "                [--data-dir DIR] [--benchmark SECONDS] [--stats FILE.csv] [image.tiles]\n"
+                 "Presets:";
+    for (const ScalePreset &preset : SCALE_PRESETS)
+        std::cerr << " " << preset.name << " (" << preset.scale << "x)";
+    std::cerr << "\nModes:";
+    for (int i = 0; i < DEMO_MODE_COUNT; i++)
+        std::cerr << " " << i << "=" << DEMO_MODE_NAMES[i];
+    for (int mode = DEMO_MODE_COUNT; std::string(demoModeName(mode)) != "?"; mode++)
+        std::cerr << " " << demoModeName(mode);
+    std::cerr << "\nA config file holds the same settings as `key = value` lines, e.g. `preset = quality`;\n"
+                 "flags after --config override it." << std::endl;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <string>
+
+// Demo settings, so a single binary can be profiled across resolutions, scale factors
+// and modes. They come from the command line; --config FILE reads `key = value` lines
+// (# comments) with the same keys as the long flags, at its place among the flags, so
+// later flags override the file.
+struct DemoConfig {
+    // Window size, and the size the scene renders at before upscaling. A render size of
+    // 0x0 is derived from the display size and scale.
+    int displayWidth = 800, displayHeight = 600;
+    int renderWidth = 0, renderHeight = 0;
+    float scale = 2.0f;
+
+    // Demo mode, 0-7, then one per registered upscaler after nearest..easu (see demoModeName)
+    int mode = 0;
+    float sharpenSharpness = 0.5f, easuSharpness = 0.2f;
+
+    // Holds assets/ and shaders/; empty = the working directory
+    std::string dataDir;
+    // Tiled image (see tiletool pack) shown instead of the cube
+    std::string image;
+
+    // Seconds to run before writing statsPath and exiting; 0 = until the window is closed
+    float benchmarkSeconds = 0.0f;
+    std::string statsPath = "frame_stats.csv";
+
+    // Fills in the render size if it was left at 0x0
+    void resolveRenderSize();
+};
+
+// FSR-style quality presets: display size over render size, per axis
+struct ScalePreset {
+    const char *name;
+    float scale;
+};
+inline constexpr ScalePreset SCALE_PRESETS[] = {
+    {"ultra-quality", 1.3f}, {"quality", 1.5f}, {"balanced", 1.7f}, {"performance", 2.0f}, {"ultra-performance", 3.0f},
+};
+
+inline constexpr int DEMO_MODE_COUNT = 8;
+const char *demoModeName(int mode);
+
+// One setting by key (the long flag without the dashes); false with a message if the
+// key is unknown or the value doesn't parse.
+bool applyDemoSetting(DemoConfig &config, const std::string &key, const std::string &value);
+bool loadDemoConfig(DemoConfig &config, const std::string &path);
+// Flags in order; a bare argument is the image. False on a bad argument or --help.
+bool parseDemoArgs(DemoConfig &config, int argc, char **argv);
+void printDemoUsage();
@@ -0,0 +1,111 @@
+#include "DirtyTiles.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+void mergeTileRows(const std::vector<unsigned char> &mask, int cols, int rows, int cellSize, int width, int height,
+                   std::vector<PixelRect> &rects) {
+    rects.clear();
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < cols; c++) {
+            if (!mask[(size_t) r * cols + c])
+                continue;
+            int start = c;
+            while (c + 1 < cols && mask[(size_t) r * cols + c + 1])
+                c++;
+            rects.push_back({start * cellSize, r * cellSize, std::min(width, (c + 1) * cellSize),
+                             std::min(height, (r + 1) * cellSize)});
+        }
+    }
+}
+
+PixelRect outputFootprint(const PixelRect &r, int srcWidth, int srcHeight, int dstWidth, int dstHeight) {
+    // An output pixel at u = (x + 0.5) * s - 0.5 in source space reads source pixels
+    // floor(u) - 1 .. floor(u) + 3 at most (see upscaleFootprint), so a source span
+    // [a, b) reaches the outputs with a - 3 <= u < b + 1; widened here to whole
+    // output pixels on both sides.
+    double sx = (double) srcWidth / dstWidth, sy = (double) srcHeight / dstHeight;
+    return {std::max(0, (int) std::floor((r.x0 - 3) / sx) - 1), std::max(0, (int) std::floor((r.y0 - 3) / sy) - 1),
+            std::min(dstWidth, (int) std::ceil((r.x1 + 2) / sx) + 1), std::min(dstHeight, (int) std::ceil((r.y1 + 2) / sy) + 1)};
+}
+
+DirtyTileTracker::DirtyTileTracker(int tileSize, int outputTileSize)
+    : tileSize(std::max(1, tileSize)), outputTileSize(std::max(1, outputTileSize)) {}
+
+void DirtyTileTracker::reset() {
+    width = height = channels = 0;
+    previous.clear();
+}
+
+void DirtyTileTracker::update(const ImageView &frame, int dw, int dh) {
+    int cols = (frame.width + tileSize - 1) / tileSize, rows = (frame.height + tileSize - 1) / tileSize;
+    size_t rowBytes = (size_t) frame.width * frame.channels;
+    bool full = frame.width != width || frame.height != height || frame.channels != channels || dw != dstWidth ||
+                dh != dstHeight;
+    width = frame.width;
+    height = frame.height;
+    channels = frame.channels;
+    dstWidth = dw;
+    dstHeight = dh;
+    totalTiles = cols * rows;
+    dirty.assign((size_t) totalTiles, full ? 1 : 0);
+
+    if (full) {
+        previous.resize(rowBytes * height);
+        for (int y = 0; y < height; y++)
+            std::memcpy(previous.data() + rowBytes * y, frame.pixel(0, y), rowBytes);
+    } else {
+        size_t tileBytes = (size_t) tileSize * channels;
+        for (int y = 0; y < height; y++) {
+            const unsigned char *row = frame.pixel(0, y), *old = previous.data() + rowBytes * y;
+            unsigned char *rowDirty = dirty.data() + (size_t) (y / tileSize) * cols;
+            for (int c = 0; c < cols; c++) {
+                size_t offset = c * tileBytes, bytes = std::min(tileBytes, rowBytes - offset);
+                if (!rowDirty[c] && std::memcmp(row + offset, old + offset, bytes) != 0)
+                    rowDirty[c] = 1;
+            }
+        }
+        // Refresh the reference only where something changed
+        for (int r = 0; r < rows; r++) {
+            for (int c = 0; c < cols; c++) {
+                if (!dirty[(size_t) r * cols + c])
+                    continue;
+                size_t offset = (size_t) c * tileSize * channels;
+                size_t bytes = (size_t) (std::min(width, (c + 1) * tileSize) - c * tileSize) * channels;
+                for (int y = r * tileSize; y < std::min(height, (r + 1) * tileSize); y++)
+                    std::memcpy(previous.data() + rowBytes * y + offset, frame.pixel(c * tileSize, y), bytes);
+            }
+        }
+    }
+    dirtyTiles = (int) std::count(dirty.begin(), dirty.end(), 1);
+    mergeTileRows(dirty, cols, rows, tileSize, width, height, sourceRects);
+
+    int outCols = (dw + outputTileSize - 1) / outputTileSize, outRows = (dh + outputTileSize - 1) / outputTileSize;
+    outputDirty.assign((size_t) outCols * outRows, 0);
+    for (const PixelRect &r : sourceRects) {
+        PixelRect out = outputFootprint(r, width, height, dw, dh);
+        for (int ty = out.y0 / outputTileSize; ty <= (out.y1 - 1) / outputTileSize; ty++)
+            for (int tx = out.x0 / outputTileSize; tx <= (out.x1 - 1) / outputTileSize; tx++)
+                outputDirty[(size_t) ty * outCols + tx] = 1;
+    }
+    mergeTileRows(outputDirty, outCols, outRows, outputTileSize, dw, dh, outputRects);
+
+    double pixels = 0.0;
+    for (const PixelRect &r : outputRects)
+        pixels += (double) (r.x1 - r.x0) * (r.y1 - r.y0);
+    outputFraction = dw > 0 && dh > 0 ? pixels / ((double) dw * dh) : 0.0;
+}
+
+void upscaleRects(const ImageView &src, const MutableImageView &dst, const std::vector<PixelRect> &rects,
+                  UpscaleMode mode, float sharpness, ThreadPool *pool) {
+    if (!pool) {
+        for (const PixelRect &r : rects)
+            upscaleRect(src, dst, r.x0, r.y0, r.x1, r.y1, mode, sharpness);
+        return;
+    }
+    pool->parallelFor((int) rects.size(), [&](int begin, int end) {
+        for (int i = begin; i < end; i++)
+            upscaleRect(src, dst, rects[i].x0, rects[i].y0, rects[i].x1, rects[i].y1, mode, sharpness);
+    });
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <vector>
+#include "CpuUpscaler.h"
+
+class ThreadPool;
+
+// Half-open pixel rectangle [x0, x1) x [y0, y1).
+struct PixelRect {
+    int x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+};
+
+// Finds which tiles of a low-res stream changed since the previous frame and which
+// parts of the upscaled output they affect, so mostly static feeds (UI captures,
+// fixed cameras) only re-upscale what moved. Tiles are compared row by row with
+// memcmp, which is vectorised by the C library and stops at the first difference;
+// only dirty tiles are copied into the reference frame.
+class DirtyTileTracker {
+public:
+    explicit DirtyTileTracker(int tileSize = 32, int outputTileSize = 64);
+
+    // Compares frame against the previous one and fills sourceRects (dirty tiles, merged
+    // along tile rows) and outputRects (output tiles of a dstWidth x dstHeight upscale
+    // whose footprint reaches a dirty tile, also merged along rows). The first frame and
+    // any size change mark everything dirty.
+    void update(const ImageView &frame, int dstWidth, int dstHeight);
+    // Forgets the reference frame so the next update redraws everything.
+    void reset();
+
+    std::vector<PixelRect> sourceRects, outputRects;
+    int dirtyTiles = 0, totalTiles = 0;
+    // Share of output pixels covered by outputRects
+    double outputFraction = 0.0;
+
+private:
+    int tileSize, outputTileSize;
+    int width = 0, height = 0, channels = 0, dstWidth = 0, dstHeight = 0;
+    std::vector<unsigned char> previous;
+    std::vector<unsigned char> dirty, outputDirty;
+};
+
+// Merges runs of set cells in each row of a cols x rows mask into rectangles of
+// cellSize pixels, clipped to width x height.
+void mergeTileRows(const std::vector<unsigned char> &mask, int cols, int rows, int cellSize, int width, int height,
+                   std::vector<PixelRect> &rects);
+
+// Output pixels of a srcWidth x srcHeight -> dstWidth x dstHeight upscale whose kernels
+// read any source pixel of r (conservative, clipped to the output).
+PixelRect outputFootprint(const PixelRect &r, int srcWidth, int srcHeight, int dstWidth, int dstHeight);
+
+// Redraws only rects of dst, which must still hold the previous output; rects are
+// spread across the pool when given.
+void upscaleRects(const ImageView &src, const MutableImageView &dst, const std::vector<PixelRect> &rects,
+                  UpscaleMode mode, float sharpness, ThreadPool *pool = nullptr);
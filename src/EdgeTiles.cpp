@@ -0,0 +1,71 @@
+#include "EdgeTiles.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cstdint>
+
+namespace {
+
+// Variance of the BT.601 luma (or the single plane) over [x0, x1) x [y0, y1)
+float lumaVariance(const ImageView &src, int x0, int y0, int x1, int y1) {
+    uint64_t sum = 0, sumSquares = 0;
+    for (int y = y0; y < y1; y++) {
+        const unsigned char *p = src.pixel(x0, y);
+        for (int x = x0; x < x1; x++, p += src.channels) {
+            uint32_t luma = src.channels >= 3 ? (77u * p[0] + 150u * p[1] + 29u * p[2]) >> 8 : p[0];
+            sum += luma;
+            sumSquares += luma * luma;
+        }
+    }
+    double count = (double) (x1 - x0) * (y1 - y0), mean = sum / count;
+    return (float) (sumSquares / count - mean * mean);
+}
+
+}
+
+EdgeTileClassifier::EdgeTileClassifier(int tileSize, int outputTileSize)
+    : tileSize(std::max(1, tileSize)), outputTileSize(std::max(1, outputTileSize)) {}
+
+void EdgeTileClassifier::classify(const ImageView &src, int dw, int dh, float threshold, ThreadPool *pool) {
+    int cols = (src.width + tileSize - 1) / tileSize, rows = (src.height + tileSize - 1) / tileSize;
+    totalTiles = cols * rows;
+    edge.assign((size_t) totalTiles, 0);
+    auto classifyRows = [&](int begin, int end) {
+        for (int r = begin; r < end; r++) {
+            for (int c = 0; c < cols; c++) {
+                int x0 = c * tileSize, y0 = r * tileSize;
+                int x1 = std::min(src.width, x0 + tileSize), y1 = std::min(src.height, y0 + tileSize);
+                edge[(size_t) r * cols + c] = lumaVariance(src, x0, y0, x1, y1) > threshold;
+            }
+        }
+    };
+    if (pool)
+        pool->parallelFor(rows, classifyRows);
+    else
+        classifyRows(0, rows);
+    edgeTiles = (int) std::count(edge.begin(), edge.end(), 1);
+    mergeTileRows(edge, cols, rows, tileSize, src.width, src.height, sourceEdgeRects);
+
+    int outCols = (dw + outputTileSize - 1) / outputTileSize, outRows = (dh + outputTileSize - 1) / outputTileSize;
+    outputEdge.assign((size_t) outCols * outRows, 0);
+    for (const PixelRect &r : sourceEdgeRects) {
+        PixelRect out = outputFootprint(r, src.width, src.height, dw, dh);
+        for (int ty = out.y0 / outputTileSize; ty <= (out.y1 - 1) / outputTileSize; ty++)
+            for (int tx = out.x0 / outputTileSize; tx <= (out.x1 - 1) / outputTileSize; tx++)
+                outputEdge[(size_t) ty * outCols + tx] = 1;
+    }
+    mergeTileRows(outputEdge, outCols, outRows, outputTileSize, dw, dh, edgeRects);
+    for (unsigned char &e : outputEdge)
+        e = !e;
+    mergeTileRows(outputEdge, outCols, outRows, outputTileSize, dw, dh, flatRects);
+
+    double pixels = 0.0;
+    for (const PixelRect &r : edgeRects)
+        pixels += (double) (r.x1 - r.x0) * (r.y1 - r.y0);
+    edgeFraction = dw > 0 && dh > 0 ? pixels / ((double) dw * dh) : 0.0;
+}
+
+void upscaleEdgeMasked(const ImageView &src, const MutableImageView &dst, const EdgeTileClassifier &tiles,
+                       UpscaleMode mode, float sharpness, ThreadPool *pool) {
+    upscaleRects(src, dst, tiles.flatRects, UpscaleMode::Bilinear, 0.0f, pool);
+    upscaleRects(src, dst, tiles.edgeRects, mode, sharpness, pool);
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <vector>
+#include "CpuUpscaler.h"
+#include "DirtyTiles.h"
+
+class ThreadPool;
+
+// Splits an upscale into flat regions, where bilinear is indistinguishable from the
+// sharpening kernels, and edge regions that need the full kernel. Source tiles whose
+// luma variance is at most threshold are flat; an output tile runs the full kernel if
+// its footprint reaches any source tile that is not.
+class EdgeTileClassifier {
+public:
+    explicit EdgeTileClassifier(int tileSize = 16, int outputTileSize = 32);
+
+    // Fills flatRects and edgeRects (output rects of a dstWidth x dstHeight upscale of src,
+    // merged along tile rows). threshold is a luma variance in 8-bit units squared.
+    void classify(const ImageView &src, int dstWidth, int dstHeight, float threshold, ThreadPool *pool = nullptr);
+
+    std::vector<PixelRect> flatRects, edgeRects;
+    int edgeTiles = 0, totalTiles = 0;
+    // Share of output pixels covered by edgeRects
+    double edgeFraction = 0.0;
+
+private:
+    int tileSize, outputTileSize;
+    std::vector<unsigned char> edge, outputEdge;
+    std::vector<PixelRect> sourceEdgeRects;
+};
+
+// Bilinear on the classifier's flat rects, mode on its edge rects; dst is fully written.
+void upscaleEdgeMasked(const ImageView &src, const MutableImageView &dst, const EdgeTileClassifier &tiles,
+                       UpscaleMode mode, float sharpness, ThreadPool *pool = nullptr);
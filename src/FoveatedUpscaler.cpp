@@ -0,0 +1,65 @@
+#include "FoveatedUpscaler.h"
+#include <algorithm>
+
+FoveatedUpscaler::FoveatedUpscaler(int tileSize)
+    : tileSize(tileSize),
+      peripheryShader("shaders/vertex.txt", "shaders/fragment_upscale.txt"),
+      foveaShader("shaders/vertex.txt", "shaders/fragment_foveated.txt") {
+    peripheryShader.use();
+    peripheryShader.setInt("uTexture", 0);
+    foveaShader.use();
+    foveaShader.setInt("uTexture", 0);
+}
+
+void FoveatedUpscaler::classify(int dstWidth, int dstHeight, const Fovea &fovea) {
+    fullRects.clear();
+    peripheryRects.clear();
+    float reach = fovea.radius + fovea.band;
+    long long fullArea = 0;
+    for (int y0 = 0; y0 < dstHeight; y0 += tileSize) {
+        int y1 = std::min(y0 + tileSize, dstHeight);
+        float dy = std::clamp(fovea.y, (float) y0, (float) y1) - fovea.y;
+        for (int x0 = 0; x0 < dstWidth; x0 += tileSize) {
+            int x1 = std::min(x0 + tileSize, dstWidth);
+            // Closest point of the tile to the centre decides whether any of it needs the full kernel
+            float dx = std::clamp(fovea.x, (float) x0, (float) x1) - fovea.x;
+            bool full = dx * dx + dy * dy < reach * reach;
+            std::vector<PixelRect> &rects = full ? fullRects : peripheryRects;
+            if (!rects.empty() && rects.back().y0 == y0 && rects.back().x1 == x0)
+                rects.back().x1 = x1;
+            else
+                rects.push_back({x0, y0, x1, y1});
+            if (full)
+                fullArea += (long long) (x1 - x0) * (y1 - y0);
+        }
+    }
+    fullFraction = dstWidth > 0 && dstHeight > 0 ? (double) fullArea / ((double) dstWidth * dstHeight) : 0.0;
+}
+
+void FoveatedUpscaler::draw(unsigned int srcTexture, int srcWidth, int srcHeight, int dstWidth, int dstHeight,
+                            const Fovea &fovea, UpscaleMode periphery, float sharpness) {
+    classify(dstWidth, dstHeight, fovea);
+
+    glViewport(0, 0, dstWidth, dstHeight);
+    glDisable(GL_DEPTH_TEST);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, srcTexture);
+    GLint filter = periphery == UpscaleMode::Nearest ? GL_NEAREST : GL_LINEAR;
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+
+    peripheryShader.use();
+    batch.draw(peripheryRects, dstWidth, dstHeight);
+
+    if (!fullRects.empty()) {
+        // The fovea pass filters bilinearly; the nearest periphery is reproduced with texelFetch
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        foveaShader.use();
+        foveaShader.setVec2("uTexSize", glm::vec2((float) srcWidth, (float) srcHeight));
+        foveaShader.setFloat("uSharpness", sharpness);
+        foveaShader.setVec4("uFovea", glm::vec4(fovea.x, fovea.y, fovea.radius, fovea.band));
+        foveaShader.setFloat("uPeripheryNearest", periphery == UpscaleMode::Nearest ? 1.0f : 0.0f);
+        batch.draw(fullRects, dstWidth, dstHeight);
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <vector>
+#include "config.h"
+#include "DirtyTiles.h"
+#include "RectBatch.h"
+#include "Shader.h"
+#include "UpscaleMode.h"
+
+// Circle of full quality in output pixels (bottom-left origin, like gl_FragCoord),
+// fading into the periphery over band pixels.
+struct Fovea {
+    float x = 0.0f, y = 0.0f, radius = 0.0f, band = 0.0f;
+};
+
+// Region-of-interest upscaling: output tiles that touch the fovea or its blend band run
+// the EASU+RCAS kernel, every other tile only the cheap periphery filter (bilinear or
+// nearest). Tiles are merged along rows and each class is drawn as one batch of quads, so
+// the expensive pass costs in proportion to the fovea's area without a draw call per tile.
+// Needs a current GL 3.3 context and the shaders/ directory in the working directory.
+class FoveatedUpscaler {
+public:
+    explicit FoveatedUpscaler(int tileSize = 32);
+
+    // Splits a dstWidth x dstHeight output into fullRects and peripheryRects.
+    void classify(int dstWidth, int dstHeight, const Fovea &fovea);
+    // Classifies, then draws srcTexture (srcWidth x srcHeight) into the bound framebuffer.
+    // periphery must be Nearest or Bilinear.
+    void draw(unsigned int srcTexture, int srcWidth, int srcHeight, int dstWidth, int dstHeight,
+              const Fovea &fovea, UpscaleMode periphery, float sharpness);
+
+    std::vector<PixelRect> fullRects, peripheryRects;
+    // Share of the output that ran the full kernel on the last classify()
+    double fullFraction = 0.0;
+    int tileSize;
+
+private:
+    RectBatch batch;
+    Shader peripheryShader, foveaShader;
+};
@@ -0,0 +1,180 @@
+#include "FrameCapture.h"
+#include "GpuMemory.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stb_image/stb_image_write.h>
+
+FrameCapture::FrameCapture(int ringSize, unsigned int encoderThreads)
+    : ring(ringSize), encoders(encoderThreads) {
+    for (Slot &slot : ring)
+        glGenBuffers(1, &slot.pbo);
+
+    // Enough staging buffers to keep every encoder busy plus one being filled
+    freeBuffers.resize(encoderThreads * 2 + 1);
+}
+
+FrameCapture::~FrameCapture() {
+    stop();
+    for (Slot &slot : ring)
+        gpuDeleteBuffers(1, &slot.pbo);
+}
+
+void FrameCapture::start(const std::string &dir, Format fmt) {
+    std::filesystem::create_directories(dir);
+    directory = dir;
+    format = fmt;
+    frameIndex = 0;
+    framesDropped = 0;
+    {
+        std::lock_guard lock(bufferMutex);
+        written = 0;
+    }
+    recording = true;
+}
+
+void FrameCapture::stop() {
+    if (!recording && pending == 0)
+        return;
+    recording = false;
+
+    while (pending > 0) {
+        Slot &slot = ring[tail];
+        glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        // Block for a staging buffer too: shutting down must not lose frames
+        encoders.wait();
+        retire(slot);
+    }
+    encoders.wait();
+    std::cout << "Capture stopped: " << framesWritten() << " frames written, "
+              << framesDropped << " dropped" << std::endl;
+}
+
+void FrameCapture::capture(unsigned int framebuffer, GLenum attachment, int width, int height) {
+    if (!recording)
+        return;
+
+    poll();
+    if (pending == (int) ring.size()) {
+        // GPU is more than a ring behind; skip rather than wait on it
+        framesDropped++;
+        frameIndex++;
+        return;
+    }
+
+    Slot &slot = ring[head];
+    size_t bytes = (size_t) width * height * 4;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    if (slot.capacity < bytes) {
+        gpuBufferData(slot.pbo, GL_PIXEL_PACK_BUFFER, "capture PBOs", (GLsizeiptr) bytes, nullptr, GL_STREAM_READ);
+        slot.capacity = bytes;
+    }
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glReadBuffer(framebuffer ? attachment : GL_BACK);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+    slot.width = width;
+    slot.height = height;
+    slot.frame = frameIndex++;
+    head = (head + 1) % (int) ring.size();
+    pending++;
+}
+
+void FrameCapture::poll() {
+    while (pending > 0) {
+        Slot &slot = ring[tail];
+        GLenum status = glClientWaitSync(slot.fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            break;
+        retire(slot);
+    }
+}
+
+int FrameCapture::framesWritten() const {
+    std::lock_guard lock(bufferMutex);
+    return written;
+}
+
+void FrameCapture::retire(Slot &slot) {
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+    tail = (tail + 1) % (int) ring.size();
+    pending--;
+
+    std::vector<unsigned char> pixels;
+    if (!acquireBuffer(pixels)) {
+        // Encoders are saturated; this frame is lost but the render loop keeps its pace
+        framesDropped++;
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    size_t rowBytes = (size_t) slot.width * 4;
+    pixels.resize(rowBytes * slot.height);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    auto mapped = (const unsigned char *) glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+                                                            (GLsizeiptr) pixels.size(), GL_MAP_READ_BIT);
+    if (mapped) {
+        // glReadPixels rows are bottom-up; flip while copying out
+        for (int y = 0; y < slot.height; y++)
+            std::memcpy(pixels.data() + (size_t) y * rowBytes, mapped + (size_t) (slot.height - 1 - y) * rowBytes, rowBytes);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    lastMapMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    if (!mapped) {
+        releaseBuffer(std::move(pixels));
+        framesDropped++;
+        return;
+    }
+
+    char name[64];
+    std::snprintf(name, sizeof(name), format == Format::PNG ? "frame_%06d.png" : "frame_%06d_%dx%d.rgba",
+                  slot.frame, slot.width, slot.height);
+    std::string path = (std::filesystem::path(directory) / name).string();
+    int width = slot.width, height = slot.height;
+    Format fmt = format;
+
+    encoders.enqueue([this, path, width, height, fmt, pixels = std::move(pixels)]() mutable {
+        bool ok;
+        if (fmt == Format::PNG) {
+            ok = stbi_write_png(path.c_str(), width, height, 4, pixels.data(), width * 4) != 0;
+        } else {
+            std::ofstream file(path, std::ios::binary);
+            file.write((const char *) pixels.data(), (std::streamsize) pixels.size());
+            ok = (bool) file;
+        }
+        if (!ok)
+            std::cout << "Failed to write capture: " << path << std::endl;
+
+        releaseBuffer(std::move(pixels));
+        if (ok) {
+            std::lock_guard lock(bufferMutex);
+            written++;
+        }
+    });
+}
+
+bool FrameCapture::acquireBuffer(std::vector<unsigned char> &buffer) {
+    std::lock_guard lock(bufferMutex);
+    if (freeBuffers.empty())
+        return false;
+    buffer = std::move(freeBuffers.back());
+    freeBuffers.pop_back();
+    return true;
+}
+
+void FrameCapture::releaseBuffer(std::vector<unsigned char> &&buffer) {
+    std::lock_guard lock(bufferMutex);
+    freeBuffers.push_back(std::move(buffer));
+}
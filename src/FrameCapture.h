@@ -0,0 +1,59 @@
+#pragma once
+#include <glad/glad.h>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "ThreadPool.h"
+
+// Asynchronous frame dumps. Each capture() issues glReadPixels into the next PBO
+// of a small ring and fences it; poll() maps only readbacks whose fence has
+// already signaled (normally 2-3 frames later), so the CPU never waits on the GPU.
+// Pixels are copied into pooled buffers and encoded on background threads.
+// When the ring or the encoder backlog is full the frame is dropped, not stalled.
+class FrameCapture {
+public:
+    enum class Format { PNG, Raw };
+
+    explicit FrameCapture(int ringSize = 3, unsigned int encoderThreads = 2);
+    // Does not touch GL: call stop() while the context is still current.
+    ~FrameCapture();
+
+    void start(const std::string &directory, Format format);
+    // Drains outstanding readbacks and waits for the encoders.
+    void stop();
+    bool active() const { return recording; }
+
+    // Reads back the given color attachment of a framebuffer (0 = back buffer).
+    void capture(unsigned int framebuffer, GLenum attachment, int width, int height);
+    void poll();
+
+    int framesWritten() const;
+    int framesDropped = 0;
+    double lastMapMs = 0.0;
+
+private:
+    struct Slot {
+        unsigned int pbo = 0;
+        GLsync fence = nullptr;
+        int width = 0, height = 0;
+        size_t capacity = 0;
+        int frame = 0;
+    };
+
+    void retire(Slot &slot);
+    bool acquireBuffer(std::vector<unsigned char> &buffer);
+    void releaseBuffer(std::vector<unsigned char> &&buffer);
+
+    std::vector<Slot> ring;
+    int head = 0, tail = 0, pending = 0;
+
+    ThreadPool encoders;
+    mutable std::mutex bufferMutex;
+    std::vector<std::vector<unsigned char>> freeBuffers;
+    int written = 0;
+
+    bool recording = false;
+    std::string directory;
+    Format format = Format::PNG;
+    int frameIndex = 0;
+};
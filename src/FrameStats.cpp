@@ -0,0 +1,104 @@
+#include "FrameStats.h"
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+
+namespace {
+
+int bucketOf(float ms) {
+    return std::clamp((int) (ms / FrameStats::BUCKET_MS), 0, FrameStats::BUCKETS - 1);
+}
+
+// Nearest-rank percentile of a sorted array
+float percentile(const float *sorted, int count, float p) {
+    int rank = std::clamp((int) (p * count + 0.999f) - 1, 0, count - 1);
+    return sorted[rank];
+}
+
+// Upper edge of the bucket holding the p-th frame
+float histogramPercentile(const uint32_t *histogram, uint64_t frames, float p) {
+    uint64_t rank = std::max<uint64_t>(1, (uint64_t) (p * frames + 0.999));
+    uint64_t seen = 0;
+    for (int i = 0; i < FrameStats::BUCKETS; i++) {
+        seen += histogram[i];
+        if (seen >= rank)
+            return (i + 1) * FrameStats::BUCKET_MS;
+    }
+    return FrameStats::BUCKETS * FrameStats::BUCKET_MS;
+}
+
+}
+
+void FrameStats::record(float cpuMs, float gpuMs) {
+    cpuRing[next] = cpuMs;
+    gpuRing[next] = gpuMs;
+    next = (next + 1) % WINDOW;
+    count = std::min(count + 1, WINDOW);
+
+    cpuHistogram[bucketOf(cpuMs)]++;
+    gpuHistogram[bucketOf(gpuMs)]++;
+    frames++;
+    cpuTotal += cpuMs;
+    gpuTotal += gpuMs;
+    cpuMax = std::max(cpuMax, cpuMs);
+    gpuMax = std::max(gpuMax, gpuMs);
+}
+
+void FrameStats::summarize(Summary &cpu, Summary &gpu) {
+    auto summarizeRing = [&](const float *ring, Summary &summary) {
+        summary = Summary();
+        if (count == 0)
+            return;
+        std::copy(ring, ring + count, scratch);
+        std::sort(scratch, scratch + count);
+        double total = 0.0;
+        for (int i = 0; i < count; i++)
+            total += scratch[i];
+        summary.p50 = percentile(scratch, count, 0.50f);
+        summary.p95 = percentile(scratch, count, 0.95f);
+        summary.p99 = percentile(scratch, count, 0.99f);
+        summary.max = scratch[count - 1];
+        summary.mean = (float) (total / count);
+    };
+    summarizeRing(cpuRing, cpu);
+    summarizeRing(gpuRing, gpu);
+}
+
+FrameStats::Summary FrameStats::runSummary(bool gpu) const {
+    Summary summary;
+    if (frames == 0)
+        return summary;
+    const uint32_t *histogram = gpu ? gpuHistogram : cpuHistogram;
+    summary.max = gpu ? gpuMax : cpuMax;
+    // A bucket's upper edge can overshoot the slowest frame
+    summary.p50 = std::min(summary.max, histogramPercentile(histogram, frames, 0.50f));
+    summary.p95 = std::min(summary.max, histogramPercentile(histogram, frames, 0.95f));
+    summary.p99 = std::min(summary.max, histogramPercentile(histogram, frames, 0.99f));
+    summary.mean = (float) ((gpu ? gpuTotal : cpuTotal) / frames);
+    return summary;
+}
+
+bool FrameStats::writeCsv(const std::string &path) const {
+    FILE *file = std::fopen(path.c_str(), "w");
+    if (!file) {
+        std::cout << "ERROR::FRAME_STATS:: Could not open " << path << std::endl;
+        return false;
+    }
+    Summary cpu = runSummary(false), gpu = runSummary(true);
+    std::fprintf(file, "kind,key,cpu,gpu\n");
+    std::fprintf(file, "stat,frames,%llu,%llu\n", (unsigned long long) frames, (unsigned long long) frames);
+    std::fprintf(file, "stat,p50_ms,%.3f,%.3f\n", cpu.p50, gpu.p50);
+    std::fprintf(file, "stat,p95_ms,%.3f,%.3f\n", cpu.p95, gpu.p95);
+    std::fprintf(file, "stat,p99_ms,%.3f,%.3f\n", cpu.p99, gpu.p99);
+    std::fprintf(file, "stat,max_ms,%.3f,%.3f\n", cpu.max, gpu.max);
+    std::fprintf(file, "stat,mean_ms,%.3f,%.3f\n", cpu.mean, gpu.mean);
+    // Buckets by lower edge; empty ones are left out
+    for (int i = 0; i < BUCKETS; i++) {
+        if (cpuHistogram[i] || gpuHistogram[i])
+            std::fprintf(file, "histogram,%.2f,%u,%u\n", i * BUCKET_MS, cpuHistogram[i], gpuHistogram[i]);
+    }
+    bool ok = std::fclose(file) == 0;
+    if (!ok)
+        std::cout << "ERROR::FRAME_STATS:: Failed writing " << path << std::endl;
+    return ok;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// Per-frame CPU (frame-to-frame) and GPU times. The last WINDOW frames are kept in a
+// ring for the graph and the rolling percentiles; every frame of the run also goes
+// into a fixed histogram, which gives the whole-run percentiles written at exit. Nothing
+// allocates after construction, so record() and summarize() are safe in the frame loop.
+class FrameStats {
+public:
+    static constexpr int WINDOW = 512;
+    // 0.25 ms buckets up to 100 ms; the last bucket also takes anything slower
+    static constexpr int BUCKETS = 400;
+    static constexpr float BUCKET_MS = 0.25f;
+
+    struct Summary {
+        float p50 = 0.0f, p95 = 0.0f, p99 = 0.0f, max = 0.0f, mean = 0.0f;
+    };
+
+    void record(float cpuMs, float gpuMs);
+
+    // Over the ring (sorts a copy of it, so once per frame at most)
+    void summarize(Summary &cpu, Summary &gpu);
+    // Over the whole run, to the histogram's resolution (max and mean are exact)
+    Summary runSummary(bool gpu) const;
+
+    // Whole-run percentiles, then the histogram: rows of kind,key,cpu_ms|frames,gpu_ms|frames
+    bool writeCsv(const std::string &path) const;
+
+    // Oldest frame at ringStart(); pass both to ImGui::PlotLines as values and offset
+    float cpuRing[WINDOW] = {}, gpuRing[WINDOW] = {};
+    int count = 0, next = 0;
+    int ringStart() const { return count < WINDOW ? 0 : next; }
+
+    uint32_t cpuHistogram[BUCKETS] = {}, gpuHistogram[BUCKETS] = {};
+    uint64_t frames = 0;
+
+private:
+    float scratch[WINDOW] = {};
+    double cpuTotal = 0.0, gpuTotal = 0.0;
+    float cpuMax = 0.0f, gpuMax = 0.0f;
+};
@@ -0,0 +1,214 @@
+#include "GlUpscaler.h"
+#include "GpuMemory.h"
+#include <iostream>
+
+GlUpscaler::GlUpscaler()
+    : upscaleShader("shaders/vertex.txt", "shaders/fragment_upscale.txt"),
+      sharpenShader("shaders/vertex.txt", "shaders/fragment_sharpen.txt"),
+      easuShader("shaders/vertex.txt", "shaders/fragment_easu.txt") {
+    quad.initQuad();
+    for (Shader *shader : {&upscaleShader, &sharpenShader, &easuShader}) {
+        shader->use();
+        shader->setInt("uTexture", 0);
+    }
+    glGenFramebuffers(1, &fbo);
+    glGenTextures(1, &outputTexture);
+    glGenTextures(1, &inputTexture);
+    glGenFramebuffers(3, planeFbo);
+    glGenTextures(3, planeInput);
+    glGenTextures(3, planeOutput);
+}
+
+GlUpscaler::~GlUpscaler() {
+    glDeleteFramebuffers(1, &fbo);
+    gpuDeleteTextures(1, &outputTexture);
+    gpuDeleteTextures(1, &inputTexture);
+    glDeleteFramebuffers(3, planeFbo);
+    gpuDeleteTextures(3, planeInput);
+    gpuDeleteTextures(3, planeOutput);
+    quad.releaseQuad();
+}
+
+void GlUpscaler::resize(int sw, int sh, int dw, int dh) {
+    if (sw != srcWidth || sh != srcHeight) {
+        srcWidth = sw;
+        srcHeight = sh;
+        glBindTexture(GL_TEXTURE_2D, inputTexture);
+        gpuTexImage2D(inputTexture, GpuMemoryCategory::Texture, "upscaler input", 0, GL_RGBA8, sw, sh, GL_RGBA,
+                      GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+    if (dw != dstWidth || dh != dstHeight) {
+        dstWidth = dw;
+        dstHeight = dh;
+        glBindTexture(GL_TEXTURE_2D, outputTexture);
+        gpuTexImage2D(outputTexture, GpuMemoryCategory::RenderTarget, "upscaler output", 0, GL_RGBA8, dw, dh, GL_RGBA,
+                      GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, outputTexture, 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+}
+
+void GlUpscaler::render(unsigned int srcTexture, UpscaleMode mode, float sharpness) {
+    drawPass(fbo, dstWidth, dstHeight, srcTexture, srcWidth, srcHeight, mode, sharpness);
+}
+
+void GlUpscaler::drawPass(unsigned int target, int width, int height, unsigned int srcTexture, int sw, int sh,
+                          UpscaleMode mode, float sharpness, const std::vector<PixelRect> *rects) {
+    glBindFramebuffer(GL_FRAMEBUFFER, target);
+    glViewport(0, 0, width, height);
+    glDisable(GL_DEPTH_TEST);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, srcTexture);
+    GLint filter = mode == UpscaleMode::Nearest ? GL_NEAREST : GL_LINEAR;
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+
+    switch (mode) {
+        case UpscaleMode::Nearest:
+        case UpscaleMode::Bilinear:
+            upscaleShader.use();
+            break;
+        case UpscaleMode::Sharpen:
+            sharpenShader.use();
+            sharpenShader.setFloat("uSharpness", sharpness);
+            break;
+        case UpscaleMode::Easu:
+            easuShader.use();
+            easuShader.setVec2("uTexSize", glm::vec2(sw, sh));
+            easuShader.setVec2("uScreenSize", glm::vec2(width, height));
+            easuShader.setFloat("uSharpness", sharpness);
+            break;
+    }
+    if (rects)
+        batch.draw(*rects, width, height);
+    else
+        quad.renderQuad();
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void GlUpscaler::process(const Image &src, Image &dst, UpscaleMode mode, float sharpness) {
+    glBindTexture(GL_TEXTURE_2D, inputTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, src.width, src.height, GL_RGBA, GL_UNSIGNED_BYTE, src.pixels.data());
+
+    render(inputTexture, mode, sharpness);
+
+    // Image rows are top-down and were uploaded as-is, so the readback order matches
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, dstWidth, dstHeight, GL_RGBA, GL_UNSIGNED_BYTE, dst.pixels.data());
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+}
+
+void GlUpscaler::processRects(const Image &src, Image &dst, const std::vector<PixelRect> &sourceRects,
+                              const std::vector<PixelRect> &outputRects, UpscaleMode mode, float sharpness) {
+    glBindTexture(GL_TEXTURE_2D, inputTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, src.width);
+    for (const PixelRect &r : sourceRects)
+        glTexSubImage2D(GL_TEXTURE_2D, 0, r.x0, r.y0, r.x1 - r.x0, r.y1 - r.y0, GL_RGBA, GL_UNSIGNED_BYTE,
+                        src.row(r.y0) + r.x0 * 4);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+    glEnable(GL_SCISSOR_TEST);
+    for (const PixelRect &r : outputRects) {
+        glScissor(r.x0, r.y0, r.x1 - r.x0, r.y1 - r.y0);
+        render(inputTexture, mode, sharpness);
+    }
+    glDisable(GL_SCISSOR_TEST);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glPixelStorei(GL_PACK_ROW_LENGTH, dst.width);
+    for (const PixelRect &r : outputRects)
+        glReadPixels(r.x0, r.y0, r.x1 - r.x0, r.y1 - r.y0, GL_RGBA, GL_UNSIGNED_BYTE, dst.row(r.y0) + r.x0 * 4);
+    glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+}
+
+void GlUpscaler::processEdgeMasked(const Image &src, Image &dst, const std::vector<PixelRect> &flatRects,
+                                   const std::vector<PixelRect> &edgeRects, UpscaleMode mode, float sharpness) {
+    glBindTexture(GL_TEXTURE_2D, inputTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, src.width, src.height, GL_RGBA, GL_UNSIGNED_BYTE, src.pixels.data());
+
+    drawPass(fbo, dstWidth, dstHeight, inputTexture, srcWidth, srcHeight, UpscaleMode::Bilinear, 0.0f, &flatRects);
+    drawPass(fbo, dstWidth, dstHeight, inputTexture, srcWidth, srcHeight, mode, sharpness, &edgeRects);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, dstWidth, dstHeight, GL_RGBA, GL_UNSIGNED_BYTE, dst.pixels.data());
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+}
+
+void GlUpscaler::ensurePlane(unsigned int texture, int width, int height, int &currentWidth, int &currentHeight) {
+    glBindTexture(GL_TEXTURE_2D, texture);
+    if (width == currentWidth && height == currentHeight)
+        return;
+    currentWidth = width;
+    currentHeight = height;
+    gpuTexImage2D(texture, GpuMemoryCategory::RenderTarget, "upscaler yuv planes", 0, GL_R8, width, height, GL_RED,
+                  GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
+
+void GlUpscaler::processYuv(const YuvFrame &src, YuvFrame &dst, UpscaleMode mode, float sharpness) {
+    const std::vector<unsigned char> *srcPlanes[3] = {&src.y, &src.u, &src.v};
+    std::vector<unsigned char> *dstPlanes[3] = {&dst.y, &dst.u, &dst.v};
+    int srcSizes[3][2] = {{src.width, src.height}, {src.chromaWidth(), src.chromaHeight()}, {src.chromaWidth(), src.chromaHeight()}};
+    int dstSizes[3][2] = {{dst.width, dst.height}, {dst.chromaWidth(), dst.chromaHeight()}, {dst.chromaWidth(), dst.chromaHeight()}};
+    UpscaleMode chromaMode = mode == UpscaleMode::Nearest ? UpscaleMode::Nearest : UpscaleMode::Bilinear;
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+    // Submit all three passes before reading anything back
+    for (int p = 0; p < 3; p++) {
+        ensurePlane(planeInput[p], srcSizes[p][0], srcSizes[p][1], planeInputSize[p][0], planeInputSize[p][1]);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, srcSizes[p][0], srcSizes[p][1], GL_RED, GL_UNSIGNED_BYTE, srcPlanes[p]->data());
+
+        int ow = planeOutputSize[p][0], oh = planeOutputSize[p][1];
+        ensurePlane(planeOutput[p], dstSizes[p][0], dstSizes[p][1], planeOutputSize[p][0], planeOutputSize[p][1]);
+        if (ow != dstSizes[p][0] || oh != dstSizes[p][1]) {
+            glBindFramebuffer(GL_FRAMEBUFFER, planeFbo[p]);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, planeOutput[p], 0);
+        }
+
+        drawPass(planeFbo[p], dstSizes[p][0], dstSizes[p][1], planeInput[p], srcSizes[p][0], srcSizes[p][1],
+                 p == 0 ? mode : chromaMode, sharpness);
+    }
+
+    for (int p = 0; p < 3; p++) {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, planeFbo[p]);
+        glReadPixels(0, 0, dstSizes[p][0], dstSizes[p][1], GL_RED, GL_UNSIGNED_BYTE, dstPlanes[p]->data());
+    }
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+}
+
+GLFWwindow *createHeadlessContext() {
+    if (!glfwInit())
+        return nullptr;
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    GLFWwindow *window = glfwCreateWindow(1, 1, "upscaler (headless)", nullptr, nullptr);
+    if (!window)
+        return nullptr;
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader((GLADloadproc) glfwGetProcAddress)) {
+        std::cout << "Failed to initialize GLAD\n";
+        return nullptr;
+    }
+    return window;
+}
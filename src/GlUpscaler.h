@@ -0,0 +1,57 @@
+#pragma once
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include "DirtyTiles.h"
+#include "Image.h"
+#include "RectBatch.h"
+#include "Renderer.h"
+#include "Shader.h"
+#include "UpscaleMode.h"
+#include "Yuv.h"
+
+// Offscreen version of the demo's upscale pass, for tools that have no window.
+// Needs a current GL 3.3 context and the shaders/ directory in the working directory.
+class GlUpscaler {
+public:
+    GlUpscaler();
+    ~GlUpscaler();
+
+    void resize(int srcWidth, int srcHeight, int dstWidth, int dstHeight);
+
+    // Draws srcTexture into the output FBO with the mode's shader.
+    void render(unsigned int srcTexture, UpscaleMode mode, float sharpness);
+    // Uploads src, renders, and reads the result back into dst (RGBA8, sized by resize()).
+    void process(const Image &src, Image &dst, UpscaleMode mode, float sharpness);
+    // Incremental process() driven by a DirtyTileTracker: uploads only sourceRects, redraws
+    // only outputRects (scissored, the rest of the output texture is kept) and reads just
+    // those back into dst, which must still hold the previous result.
+    void processRects(const Image &src, Image &dst, const std::vector<PixelRect> &sourceRects,
+                      const std::vector<PixelRect> &outputRects, UpscaleMode mode, float sharpness);
+    // Edge-mask early-out driven by an EdgeTileClassifier: the whole output is written,
+    // flatRects with bilinear and edgeRects with mode, one batched draw each.
+    void processEdgeMasked(const Image &src, Image &dst, const std::vector<PixelRect> &flatRects,
+                           const std::vector<PixelRect> &edgeRects, UpscaleMode mode, float sharpness);
+    // Planar 4:2:0 through one R8 texture per plane: luma uses the mode's shader,
+    // chroma the bilinear (or nearest) pass. dst must already be sized.
+    void processYuv(const YuvFrame &src, YuvFrame &dst, UpscaleMode mode, float sharpness);
+
+    unsigned int fbo = 0, outputTexture = 0, inputTexture = 0;
+    int srcWidth = 0, srcHeight = 0, dstWidth = 0, dstHeight = 0;
+
+private:
+    // Full-screen quad, or only rects (one batch) when given
+    void drawPass(unsigned int target, int width, int height, unsigned int srcTexture, int srcWidth, int srcHeight,
+                  UpscaleMode mode, float sharpness, const std::vector<PixelRect> *rects = nullptr);
+    void ensurePlane(unsigned int texture, int width, int height, int &currentWidth, int &currentHeight);
+
+    unsigned int planeInput[3] = {}, planeOutput[3] = {}, planeFbo[3] = {};
+    int planeInputSize[3][2] = {}, planeOutputSize[3][2] = {};
+
+    Renderer quad;
+    RectBatch batch;
+    Shader upscaleShader, sharpenShader, easuShader;
+};
+
+// Hidden GLFW window whose 3.3 core context is made current and loaded with glad.
+// Returns nullptr on failure. Must be called from the main thread.
+GLFWwindow *createHeadlessContext();
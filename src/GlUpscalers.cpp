@@ -0,0 +1,319 @@
+#include "GlUpscalers.h"
+#include "GpuMemory.h"
+#include "PolyphaseFilter.h"
+#include "Renderer.h"
+#include "Shader.h"
+#include "UpscaleMode.h"
+#include <iostream>
+
+namespace {
+
+// A colour target and its FBO, (re)allocated when the size changes
+struct Target {
+    unsigned int fbo = 0, texture = 0;
+    int width = 0, height = 0;
+
+    void ensure(const char *label, int w, int h, GLint internalFormat = GL_RGBA8) {
+        if (!fbo) {
+            glGenFramebuffers(1, &fbo);
+            glGenTextures(1, &texture);
+        }
+        if (w == width && h == height)
+            return;
+        width = w;
+        height = h;
+        glBindTexture(GL_TEXTURE_2D, texture);
+        gpuTexImage2D(texture, GpuMemoryCategory::RenderTarget, label, 0, internalFormat, w, h, GL_RGBA,
+                      GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    void release() {
+        if (!fbo)
+            return;
+        glDeleteFramebuffers(1, &fbo);
+        gpuDeleteTextures(1, &texture);
+        fbo = texture = 0;
+        width = height = 0;
+    }
+};
+
+// Full-screen quad passes; process() uploads into an input texture, renders it into an
+// output target and reads that back
+class GlQuadUpscaler : public IUpscaler {
+public:
+    explicit GlQuadUpscaler(std::string shaderDir) : shaderDir(std::move(shaderDir)) {}
+
+    ~GlQuadUpscaler() override {
+        if (!initialized)
+            return;
+        quad.releaseQuad();
+        output.release();
+        gpuDeleteTextures(1, &inputTexture);
+    }
+
+    UpscalerBackend backend() const override { return UpscalerBackend::Gl; }
+
+    bool init(int sw, int sh, int dw, int dh) override {
+        quad.initQuad();
+        glGenTextures(1, &inputTexture);
+        initialized = true;
+        resize(sw, sh, dw, dh);
+        return true;
+    }
+
+protected:
+    std::unique_ptr<Shader> loadShader(const char *fragmentName) const {
+        std::string vertexPath = shaderDir + "/vertex.txt", fragmentPath = shaderDir + "/" + fragmentName;
+        auto shader = std::make_unique<Shader>(vertexPath.c_str(), fragmentPath.c_str());
+        shader->use();
+        shader->setInt("uTexture", 0);
+        return shader;
+    }
+
+    // Same uploads and readback as GlUpscaler::process, straight from and into the views'
+    // rows; the targets appear on first use
+    void processImage(const ImageView &src, const MutableImageView &dst) override {
+        glBindTexture(GL_TEXTURE_2D, inputTexture);
+        if (inputWidth != src.width || inputHeight != src.height) {
+            inputWidth = src.width;
+            inputHeight = src.height;
+            gpuTexImage2D(inputTexture, GpuMemoryCategory::Texture, "upscaler input", 0, GL_RGBA8, src.width,
+                          src.height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        if (src.stride % 4 == 0) {
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, (GLint) (src.stride / 4));
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, src.width, src.height, GL_RGBA, GL_UNSIGNED_BYTE, src.data);
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        } else {
+            for (int y = 0; y < src.height; y++)
+                glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y, src.width, 1, GL_RGBA, GL_UNSIGNED_BYTE, src.pixel(0, y));
+        }
+
+        output.ensure("upscaler output", dstWidth, dstHeight);
+        renderTexture(inputTexture, output.fbo);
+
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, output.fbo);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        if (dst.stride % 4 == 0) {
+            glPixelStorei(GL_PACK_ROW_LENGTH, (GLint) (dst.stride / 4));
+            glReadPixels(0, 0, dstWidth, dstHeight, GL_RGBA, GL_UNSIGNED_BYTE, dst.data);
+            glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+        } else {
+            for (int y = 0; y < dstHeight; y++)
+                glReadPixels(0, y, dstWidth, 1, GL_RGBA, GL_UNSIGNED_BYTE, dst.pixel(0, y));
+        }
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    }
+
+    std::string shaderDir;
+    bool initialized = false;
+    Renderer quad;
+    unsigned int inputTexture = 0;
+    int inputWidth = 0, inputHeight = 0;
+    Target output;
+};
+
+// One of the demo's upscale shaders over a full-screen quad; with rcas, a bilinear
+// pass into an output-size target followed by fragment_rcas
+class GlShaderUpscaler : public GlQuadUpscaler {
+public:
+    GlShaderUpscaler(UpscaleMode mode, bool rcas, std::string shaderDir)
+        : GlQuadUpscaler(std::move(shaderDir)), mode(mode), rcas(rcas) {
+        sharpness = mode == UpscaleMode::Easu || rcas ? 0.2f : 0.5f;
+    }
+
+    ~GlShaderUpscaler() override {
+        if (!shader)
+            return;
+        glDeleteProgram(shader->ID);
+        if (rcasShader)
+            glDeleteProgram(rcasShader->ID);
+        upscaled.release();
+    }
+
+    const char *name() const override { return rcas ? "rcas" : upscaleModeName(mode); }
+
+    bool init(int sw, int sh, int dw, int dh) override {
+        static const char *fragmentNames[] = {"fragment_upscale.txt", "fragment_upscale.txt", "fragment_sharpen.txt",
+                                              "fragment_easu.txt"};
+        shader = loadShader(fragmentNames[(int) mode]);
+        if (rcas)
+            rcasShader = loadShader("fragment_rcas.txt");
+        return GlQuadUpscaler::init(sw, sh, dw, dh);
+    }
+
+    void resize(int sw, int sh, int dw, int dh) override {
+        IUpscaler::resize(sw, sh, dw, dh);
+        if (rcas)
+            upscaled.ensure("rcas upscaled", dw, dh);
+    }
+
+protected:
+    bool renderTexture(unsigned int srcTexture, unsigned int targetFbo) override {
+        if (!rcas) {
+            drawPass(*shader, targetFbo, srcTexture, srcWidth, srcHeight, mode);
+            return true;
+        }
+        drawPass(*shader, upscaled.fbo, srcTexture, srcWidth, srcHeight, UpscaleMode::Bilinear);
+        drawPass(*rcasShader, targetFbo, upscaled.texture, dstWidth, dstHeight, UpscaleMode::Sharpen);
+        return true;
+    }
+
+private:
+    // Output-size pass over the whole target; passMode picks the filter and uniforms
+    void drawPass(Shader &pass, unsigned int target, unsigned int srcTexture, int sw, int sh, UpscaleMode passMode) {
+        glBindFramebuffer(GL_FRAMEBUFFER, target);
+        glViewport(0, 0, dstWidth, dstHeight);
+        glDisable(GL_DEPTH_TEST);
+
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, srcTexture);
+        GLint filter = passMode == UpscaleMode::Nearest ? GL_NEAREST : GL_LINEAR;
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+
+        pass.use();
+        if (passMode == UpscaleMode::Sharpen || passMode == UpscaleMode::Easu)
+            pass.setFloat("uSharpness", sharpness);
+        if (passMode == UpscaleMode::Easu) {
+            pass.setVec2("uTexSize", glm::vec2(sw, sh));
+            pass.setVec2("uScreenSize", glm::vec2(dstWidth, dstHeight));
+        }
+        quad.renderQuad();
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    UpscaleMode mode;
+    bool rcas;
+    std::unique_ptr<Shader> shader, rcasShader;
+    Target upscaled;
+};
+
+// fragment_separable twice: horizontally into a half-float dst width x src height target,
+// which keeps the kernel's overshoot, then vertically. The weights are PolyphaseTable's,
+// uploaded as a taps x phases texture per axis, so they match the CPU backend's.
+class GlSeparableUpscaler : public GlQuadUpscaler {
+public:
+    GlSeparableUpscaler(FilterKernel kernel, std::string shaderDir)
+        : GlQuadUpscaler(std::move(shaderDir)), kernel(kernel) {}
+
+    ~GlSeparableUpscaler() override {
+        if (!shader)
+            return;
+        glDeleteProgram(shader->ID);
+        gpuDeleteTextures(1, &x.texture);
+        gpuDeleteTextures(1, &y.texture);
+        intermediate.release();
+    }
+
+    const char *name() const override { return filterKernelName(kernel); }
+
+    bool init(int sw, int sh, int dw, int dh) override {
+        shader = loadShader("fragment_separable.txt");
+        shader->setInt("uWeights", 1);
+        return GlQuadUpscaler::init(sw, sh, dw, dh);
+    }
+
+    void resize(int sw, int sh, int dw, int dh) override {
+        if (sw != srcWidth || dw != dstWidth)
+            x.build(kernel, sw, dw, "separable weights x");
+        if (sh != srcHeight || dh != dstHeight)
+            y.build(kernel, sh, dh, "separable weights y");
+        IUpscaler::resize(sw, sh, dw, dh);
+        intermediate.ensure("separable intermediate", dw, sh, GL_RGBA16F);
+    }
+
+protected:
+    bool renderTexture(unsigned int srcTexture, unsigned int targetFbo) override {
+        drawPass(intermediate.fbo, dstWidth, srcHeight, srcTexture, x, false);
+        drawPass(targetFbo, dstWidth, dstHeight, intermediate.texture, y, true);
+        return true;
+    }
+
+private:
+    struct Weights {
+        PolyphaseTable table;
+        unsigned int texture = 0;
+
+        void build(FilterKernel kernel, int srcSize, int dstSize, const char *label) {
+            table = buildPolyphaseTable(kernel, srcSize, dstSize);
+            std::vector<float> values(table.weights.size());
+            for (size_t i = 0; i < values.size(); i++)
+                values[i] = table.weights[i] / (float) (1 << PolyphaseTable::WEIGHT_BITS);
+            if (!texture)
+                glGenTextures(1, &texture);
+            glBindTexture(GL_TEXTURE_2D, texture);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            gpuTexImage2D(texture, GpuMemoryCategory::Texture, label, 0, GL_R32F, table.taps, table.phases, GL_RED,
+                          GL_FLOAT, values.data());
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        }
+    };
+
+    // Taps are texelFetch'd and clamped in the shader; the source only has to be complete
+    // without mipmaps, hence GL_NEAREST
+    void drawPass(unsigned int target, int width, int height, unsigned int srcTexture, const Weights &weights,
+                  bool vertical) {
+        glBindFramebuffer(GL_FRAMEBUFFER, target);
+        glViewport(0, 0, width, height);
+        glDisable(GL_DEPTH_TEST);
+
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, weights.texture);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, srcTexture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        shader->use();
+        shader->setInt("uVertical", vertical ? 1 : 0);
+        shader->setInt("uPhases", weights.table.phases);
+        shader->setInt("uStep", weights.table.step);
+        shader->setInt("uTaps", weights.table.taps);
+        quad.renderQuad();
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    FilterKernel kernel;
+    std::unique_ptr<Shader> shader;
+    Weights x, y;
+    Target intermediate;
+};
+
+}
+
+std::unique_ptr<IUpscaler> createGlUpscaler(const std::string &name, const std::string &shaderDir) {
+    if (name == "rcas")
+        return std::make_unique<GlShaderUpscaler>(UpscaleMode::Bilinear, true, shaderDir);
+    FilterKernel kernel;
+    if (parseFilterKernel(name, kernel))
+        return std::make_unique<GlSeparableUpscaler>(kernel, shaderDir);
+    UpscaleMode mode;
+    if (!parseUpscaleMode(name, mode)) {
+        std::cout << "ERROR::UPSCALER:: No built-in gl upscaler named " << name << std::endl;
+        return nullptr;
+    }
+    return std::make_unique<GlShaderUpscaler>(mode, false, shaderDir);
+}
+
+void registerGlUpscalers() {
+    for (const char *name : {"nearest", "bilinear", "sharpen", "easu", "rcas"})
+        registerUpscaler(name, UpscalerBackend::Gl, [name] { return createGlUpscaler(name); });
+    for (FilterKernel kernel : ALL_FILTER_KERNELS) {
+        const char *name = filterKernelName(kernel);
+        registerUpscaler(name, UpscalerBackend::Gl, [name] { return createGlUpscaler(name); });
+    }
+}
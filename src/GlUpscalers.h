@@ -0,0 +1,13 @@
+#pragma once
+#include "Upscaler.h"
+
+// Adds the GL backends of nearest, bilinear, sharpen, easu (the demo's shaders, drawn
+// like GlUpscaler does), rcas (bilinear, then fragment_rcas at the output size) and the
+// separable filters (two fragment_separable passes) to the upscaler registry, in the CPU
+// backends' order. Safe to call more than once. The upscalers it creates
+// need a current GL 3.3 context from init() on, and shaders/ in the working directory.
+void registerGlUpscalers();
+
+// One of those directly, loading its shaders from shaderDir instead; nullptr, with a
+// message, for any other name. For embedders that can't rely on the working directory.
+std::unique_ptr<IUpscaler> createGlUpscaler(const std::string &name, const std::string &shaderDir = "shaders");
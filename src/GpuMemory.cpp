@@ -0,0 +1,188 @@
+#include "GpuMemory.h"
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+constexpr int MAX_LEVELS = 16;
+
+struct Allocation {
+    GpuMemoryCategory category;
+    const char *label;
+    size_t bytes;
+};
+
+// One entry per texture level or buffer
+uint64_t textureKey(unsigned int texture, int level) {
+    return (uint64_t) texture << 5 | (uint64_t) level;
+}
+
+uint64_t bufferKey(unsigned int buffer) {
+    return 1ull << 63 | (uint64_t) buffer << 5;
+}
+
+class Registry {
+public:
+    // Only if gpuMemoryPrintReport never ran: by static destruction the context is usually gone
+    ~Registry() {
+        if (!reported)
+            printLeaks();
+    }
+
+    void printLeaks() const {
+        if (allocations.empty())
+            return;
+        std::cout << "ERROR::GPU_MEMORY:: " << allocations.size() << " allocations (" << stats.totalBytes / 1024
+                  << " KB) were never freed:" << std::endl;
+        for (const auto &[key, allocation] : allocations) {
+            bool buffer = key >> 63;
+            std::cout << "  " << allocation.label << ": " << (buffer ? "buffer " : "texture ")
+                      << (unsigned int) (key >> 5) << (buffer ? "" : " level " + std::to_string(key & 31)) << ", "
+                      << allocation.bytes / 1024 << " KB" << std::endl;
+        }
+    }
+
+    void set(uint64_t key, GpuMemoryCategory category, const char *label, size_t bytes) {
+        remove(key);
+        allocations[key] = {category, label, bytes};
+        int c = (int) category;
+        stats.bytes[c] += bytes;
+        stats.totalBytes += bytes;
+        stats.allocations++;
+        stats.highWater[c] = std::max(stats.highWater[c], stats.bytes[c]);
+        stats.totalHighWater = std::max(stats.totalHighWater, stats.totalBytes);
+    }
+
+    void remove(uint64_t key) {
+        auto it = allocations.find(key);
+        if (it == allocations.end())
+            return;
+        stats.bytes[(int) it->second.category] -= it->second.bytes;
+        stats.totalBytes -= it->second.bytes;
+        stats.allocations--;
+        allocations.erase(it);
+    }
+
+    const Allocation *find(uint64_t key) const {
+        auto it = allocations.find(key);
+        return it == allocations.end() ? nullptr : &it->second;
+    }
+
+    std::unordered_map<uint64_t, Allocation> allocations;
+    GpuMemoryStats stats;
+    bool reported = false;
+};
+
+// Constructed on first use, so it outlives (and can audit) everything created after it
+Registry &registry() {
+    static Registry instance;
+    return instance;
+}
+
+size_t bytesPerPixel(GLint internalFormat) {
+    switch (internalFormat) {
+        case GL_R8: case GL_RED: return 1;
+        case GL_RG8: case GL_R16F: return 2;
+        case GL_RG16F: case GL_R32F: case GL_DEPTH24_STENCIL8: case GL_DEPTH_COMPONENT24: return 4;
+        case GL_RGBA16F: case GL_RG32F: return 8;
+        case GL_RGBA32F: return 16;
+        // RGB8 is stored as RGBA8 by every driver we run on
+        default: return 4;
+    }
+}
+
+}
+
+const char *gpuMemoryCategoryName(GpuMemoryCategory category) {
+    switch (category) {
+        case GpuMemoryCategory::RenderTarget: return "render targets";
+        case GpuMemoryCategory::Texture: return "textures";
+        case GpuMemoryCategory::Buffer: return "buffers";
+        default: return "?";
+    }
+}
+
+void gpuTexImage2D(unsigned int texture, GpuMemoryCategory category, const char *label, int level,
+                   GLint internalFormat, int width, int height, GLenum format, GLenum type, const void *data) {
+    glTexImage2D(GL_TEXTURE_2D, level, internalFormat, width, height, 0, format, type, data);
+    registry().set(textureKey(texture, level), category, label, (size_t) width * height * bytesPerPixel(internalFormat));
+}
+
+void gpuCompressedTexImage2D(unsigned int texture, GpuMemoryCategory category, const char *label, int level,
+                             GLenum internalFormat, int width, int height, int imageSize, const void *data) {
+    glCompressedTexImage2D(GL_TEXTURE_2D, level, internalFormat, width, height, 0, imageSize, data);
+    registry().set(textureKey(texture, level), category, label, (size_t) imageSize);
+}
+
+void gpuGenerateMipmap(unsigned int texture) {
+    glGenerateMipmap(GL_TEXTURE_2D);
+    const Allocation *base = registry().find(textureKey(texture, 0));
+    if (!base)
+        return;
+    // Each level is a quarter of the one above; the whole chain is a third of level 0
+    Allocation level0 = *base;
+    registry().set(textureKey(texture, 1), level0.category, level0.label, level0.bytes / 3);
+}
+
+void gpuDeleteTextures(int count, const unsigned int *textures) {
+    glDeleteTextures(count, textures);
+    for (int i = 0; i < count; i++)
+        for (int level = 0; level < MAX_LEVELS; level++)
+            registry().remove(textureKey(textures[i], level));
+}
+
+void gpuBufferData(unsigned int buffer, GLenum target, const char *label, GLsizeiptr size, const void *data,
+                   GLenum usage) {
+    glBufferData(target, size, data, usage);
+    registry().set(bufferKey(buffer), GpuMemoryCategory::Buffer, label, (size_t) size);
+}
+
+void gpuDeleteBuffers(int count, const unsigned int *buffers) {
+    glDeleteBuffers(count, buffers);
+    for (int i = 0; i < count; i++)
+        registry().remove(bufferKey(buffers[i]));
+}
+
+const GpuMemoryStats &gpuMemoryStats() {
+    return registry().stats;
+}
+
+void gpuMemoryForEachLabel(const std::function<void(const char *, GpuMemoryCategory, size_t, int)> &fn) {
+    struct Total {
+        const char *label;
+        GpuMemoryCategory category;
+        size_t bytes;
+        int allocations;
+    };
+    std::vector<Total> totals;
+    for (const auto &[key, allocation] : registry().allocations) {
+        auto it = std::find_if(totals.begin(), totals.end(), [&](const Total &t) {
+            return t.category == allocation.category && std::string_view(t.label) == allocation.label;
+        });
+        if (it == totals.end())
+            totals.push_back({allocation.label, allocation.category, allocation.bytes, 1});
+        else {
+            it->bytes += allocation.bytes;
+            it->allocations++;
+        }
+    }
+    std::sort(totals.begin(), totals.end(), [](const Total &a, const Total &b) { return a.bytes > b.bytes; });
+    for (const Total &t : totals)
+        fn(t.label, t.category, t.bytes, t.allocations);
+}
+
+void gpuMemoryPrintReport() {
+    const GpuMemoryStats &stats = registry().stats;
+    std::cout << "GPU memory: " << stats.totalBytes / (1024.0 * 1024.0) << " MB in use, high-water "
+              << stats.totalHighWater / (1024.0 * 1024.0) << " MB" << std::endl;
+    for (int c = 0; c < (int) GpuMemoryCategory::Count; c++)
+        std::cout << "  " << gpuMemoryCategoryName((GpuMemoryCategory) c) << ": " << stats.bytes[c] / (1024.0 * 1024.0)
+                  << " MB, high-water " << stats.highWater[c] / (1024.0 * 1024.0) << " MB" << std::endl;
+    registry().printLeaks();
+    registry().reported = true;
+}
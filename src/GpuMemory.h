@@ -0,0 +1,44 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstddef>
+#include <functional>
+
+// Accounting of the GPU memory the engine allocates. Texture and buffer storage goes
+// through the wrappers below instead of the raw GL calls; each records the bytes it
+// asked for under the object, a category and a label (a string literal). Drivers pad
+// and compress behind our back, so these are the sizes we requested, with RGB counted
+// as RGBA. Objects still registered at gpuMemoryPrintReport (or, without one, when the
+// process exits) are reported as leaks.
+// GL thread only.
+enum class GpuMemoryCategory { RenderTarget, Texture, Buffer, Count };
+
+const char *gpuMemoryCategoryName(GpuMemoryCategory category);
+
+// glTexImage2D / glCompressedTexImage2D into GL_TEXTURE_2D, which must have texture bound
+void gpuTexImage2D(unsigned int texture, GpuMemoryCategory category, const char *label, int level,
+                   GLint internalFormat, int width, int height, GLenum format, GLenum type, const void *data);
+void gpuCompressedTexImage2D(unsigned int texture, GpuMemoryCategory category, const char *label, int level,
+                             GLenum internalFormat, int width, int height, int imageSize, const void *data);
+// glGenerateMipmap on the bound texture; levels 1 and up are recorded together
+void gpuGenerateMipmap(unsigned int texture);
+void gpuDeleteTextures(int count, const unsigned int *textures);
+
+// glBufferData on target, which must have buffer bound
+void gpuBufferData(unsigned int buffer, GLenum target, const char *label, GLsizeiptr size, const void *data,
+                   GLenum usage);
+void gpuDeleteBuffers(int count, const unsigned int *buffers);
+
+struct GpuMemoryStats {
+    size_t bytes[(int) GpuMemoryCategory::Count] = {}, highWater[(int) GpuMemoryCategory::Count] = {};
+    size_t totalBytes = 0, totalHighWater = 0;
+    int allocations = 0;
+};
+const GpuMemoryStats &gpuMemoryStats();
+
+// Current use summed per label, largest first
+void gpuMemoryForEachLabel(const std::function<void(const char *label, GpuMemoryCategory category, size_t bytes,
+                                                    int allocations)> &fn);
+
+// Current and high-water totals per category, and every allocation still registered as a
+// leak. Call at shutdown once all GL objects are released, before the context is destroyed.
+void gpuMemoryPrintReport();
@@ -0,0 +1,26 @@
+#include "GpuTimer.h"
+
+GpuTimer::GpuTimer() {
+    glGenQueries(RING, queries);
+}
+
+GpuTimer::~GpuTimer() {
+    glDeleteQueries(RING, queries);
+}
+
+void GpuTimer::begin() {
+    // The query about to be reused is RING frames old, so this rarely waits
+    if (pending[slot]) {
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(queries[slot], GL_QUERY_RESULT, &ns);
+        lastMs = ns / 1e6;
+        pending[slot] = false;
+    }
+    glBeginQuery(GL_TIME_ELAPSED, queries[slot]);
+}
+
+void GpuTimer::end() {
+    glEndQuery(GL_TIME_ELAPSED);
+    pending[slot] = true;
+    slot = (slot + 1) % RING;
+}
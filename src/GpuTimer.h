@@ -0,0 +1,23 @@
+#pragma once
+#include <glad/glad.h>
+
+// GPU time of a span of GL commands without stalling: GL_TIME_ELAPSED queries go
+// round a small ring and each one is read back a few frames after it was issued.
+// Spans must not nest (GL allows one elapsed-time query at a time).
+class GpuTimer {
+public:
+    GpuTimer();
+    ~GpuTimer();
+
+    void begin();
+    void end();
+
+    // Most recent completed measurement
+    double lastMs = 0.0;
+
+private:
+    static constexpr int RING = 4;
+    unsigned int queries[RING] = {};
+    bool pending[RING] = {};
+    int slot = 0;
+};
@@ -0,0 +1,67 @@
+#include "GpuTrace.h"
+#include "Tracing.h"
+
+GpuTrace::GpuTrace() {
+    for (Span &span : spans)
+        glGenQueries(2, span.queries);
+    track = traceNewTrack("GPU");
+    calibrate();
+}
+
+GpuTrace::~GpuTrace() {
+    for (Span &span : spans)
+        glDeleteQueries(2, span.queries);
+}
+
+void GpuTrace::calibrate() {
+    // Reading GL_TIMESTAMP directly doesn't wait for queued work
+    GLint64 gpuNs = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpuNs);
+    gpuToCpuNs = traceNowNs() - gpuNs;
+}
+
+void GpuTrace::begin(const char *name) {
+    // A span is only kept if it was opened while tracing and there is room for it
+    int index = -1;
+    if (traceActive() && (head + 1) % CAPACITY != tail && depth < MAX_DEPTH) {
+        index = head;
+        head = (head + 1) % CAPACITY;
+        spans[index].name = name;
+        spans[index].ended = false;
+        glQueryCounter(spans[index].queries[0], GL_TIMESTAMP);
+    }
+    if (depth < MAX_DEPTH)
+        open[depth] = index;
+    depth++;
+}
+
+void GpuTrace::end() {
+    if (depth == 0)
+        return;
+    depth--;
+    if (depth < MAX_DEPTH && open[depth] >= 0) {
+        glQueryCounter(spans[open[depth]].queries[1], GL_TIMESTAMP);
+        spans[open[depth]].ended = true;
+    }
+}
+
+void GpuTrace::collect() {
+    if (tail == head)
+        return;
+    calibrate();
+    while (tail != head) {
+        Span &span = spans[tail];
+        // Results arrive in submission order; an outer span that is still open holds back the rest
+        if (!span.ended)
+            break;
+        GLint available = 0;
+        glGetQueryObjectiv(span.queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            break;
+        GLuint64 start = 0, stop = 0;
+        glGetQueryObjectui64v(span.queries[0], GL_QUERY_RESULT, &start);
+        glGetQueryObjectui64v(span.queries[1], GL_QUERY_RESULT, &stop);
+        traceRecord(track, span.name, (int64_t) start + gpuToCpuNs, (int64_t) (stop - start));
+        tail = (tail + 1) % CAPACITY;
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstdint>
+
+struct TraceTrack;
+
+// GPU spans for the tracer: begin/end put GL_TIMESTAMP queries around a pass, and
+// collect() (once per frame) turns the ones the GPU has finished into spans on a
+// "GPU" track, shifted onto the CPU trace clock. Spans may nest. Needs a current GL
+// 3.3 context; does nothing while tracing is off.
+class GpuTrace {
+public:
+    GpuTrace();
+    ~GpuTrace();
+
+    void begin(const char *name);
+    void end();
+    void collect();
+
+private:
+    // Enough for several frames of passes still in flight
+    static constexpr int CAPACITY = 256;
+    static constexpr int MAX_DEPTH = 8;
+
+    struct Span {
+        const char *name = nullptr;
+        unsigned int queries[2] = {};
+        bool ended = false;
+    };
+
+    void calibrate();
+
+    Span spans[CAPACITY];
+    int head = 0, tail = 0; // spans [tail, head) are waiting for their results
+    int open[MAX_DEPTH] = {};
+    int depth = 0;
+
+    TraceTrack *track = nullptr;
+    int64_t gpuToCpuNs = 0;
+};
@@ -0,0 +1,76 @@
+#include "Image.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <stb_image/std_image.h>
+#include <stb_image/stb_image_write.h>
+
+bool loadImage(const std::string &path, Image &image, int channels) {
+    int width, height, fileChannels;
+    unsigned char *data = stbi_load(path.c_str(), &width, &height, &fileChannels, channels);
+    if (!data) {
+        std::cout << "Failed to load image: " << path << std::endl;
+        return false;
+    }
+
+    image = Image(width, height, channels);
+    std::memcpy(image.pixels.data(), data, image.pixels.size());
+    stbi_image_free(data);
+    return true;
+}
+
+bool decodeImage(const unsigned char *data, size_t size, Image &image, int channels, const std::string &name) {
+    int width, height, fileChannels;
+    unsigned char *decoded = stbi_load_from_memory(data, (int) size, &width, &height, &fileChannels, channels);
+    if (!decoded) {
+        std::cout << "Failed to decode image: " << name << std::endl;
+        return false;
+    }
+
+    image = Image(width, height, channels);
+    std::memcpy(image.pixels.data(), decoded, image.pixels.size());
+    stbi_image_free(decoded);
+    return true;
+}
+
+bool saveImagePng(const std::string &path, const Image &image) {
+    if (!stbi_write_png(path.c_str(), image.width, image.height, image.channels, image.pixels.data(),
+                        image.width * image.channels)) {
+        std::cout << "Failed to write image: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool encodeImagePng(const Image &image, std::vector<unsigned char> &out) {
+    out.clear();
+    auto append = [](void *context, void *data, int size) {
+        auto *buffer = (std::vector<unsigned char> *) context;
+        auto *bytes = (unsigned char *) data;
+        buffer->insert(buffer->end(), bytes, bytes + size);
+    };
+    if (!stbi_write_png_to_func(append, &out, image.width, image.height, image.channels, image.pixels.data(),
+                                image.width * image.channels)) {
+        std::cout << "Failed to encode PNG" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+Image downsampleImage(const Image &image) {
+    Image half(std::max(1, image.width / 2), std::max(1, image.height / 2), image.channels);
+    int c = image.channels;
+
+    for (int y = 0; y < half.height; y++) {
+        const unsigned char *row0 = image.row(std::min(2 * y, image.height - 1));
+        const unsigned char *row1 = image.row(std::min(2 * y + 1, image.height - 1));
+        unsigned char *out = half.row(y);
+        for (int x = 0; x < half.width; x++) {
+            int x0 = std::min(2 * x, image.width - 1) * c;
+            int x1 = std::min(2 * x + 1, image.width - 1) * c;
+            for (int k = 0; k < c; k++)
+                out[x * c + k] = (unsigned char) ((row0[x0 + k] + row0[x1 + k] + row1[x0 + k] + row1[x1 + k] + 2) >> 2);
+        }
+    }
+    return half;
+}
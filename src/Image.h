@@ -0,0 +1,31 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// CPU-side 8-bit image, tightly packed rows.
+struct Image {
+    int width = 0, height = 0, channels = 4;
+    std::vector<unsigned char> pixels;
+
+    Image() = default;
+    Image(int width, int height, int channels) : width(width), height(height), channels(channels),
+                                                 pixels((size_t) width * height * channels) {}
+
+    bool empty() const { return pixels.empty(); }
+    unsigned char *row(int y) { return pixels.data() + (size_t) y * width * channels; }
+    const unsigned char *row(int y) const { return pixels.data() + (size_t) y * width * channels; }
+};
+
+// Loads any stb-supported file, converted to the requested channel count.
+bool loadImage(const std::string &path, Image &image, int channels = 4);
+
+// Same as loadImage for a file that is already in memory; name is only used in messages.
+bool decodeImage(const unsigned char *data, size_t size, Image &image, int channels = 4, const std::string &name = "");
+
+// Writes a PNG; the image's channel count is kept.
+bool saveImagePng(const std::string &path, const Image &image);
+// PNG-encodes into out (replacing its contents).
+bool encodeImagePng(const Image &image, std::vector<unsigned char> &out);
+
+// 2x2 box-filtered half-size copy, used for mip chains.
+Image downsampleImage(const Image &image);
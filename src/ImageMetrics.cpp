@@ -0,0 +1,275 @@
+#include "ImageMetrics.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define UPSCALER_SSE2 1
+#endif
+
+namespace {
+
+constexpr int WINDOW = 11;
+constexpr double C1 = (0.01 * 255) * (0.01 * 255), C2 = (0.03 * 255) * (0.03 * 255);
+constexpr double MS_SSIM_WEIGHTS[] = {0.0448, 0.2856, 0.3001, 0.2363, 0.1333};
+
+struct Plane {
+    int width = 0, height = 0;
+    std::vector<float> pixels;
+
+    Plane(int width, int height) : width(width), height(height), pixels((size_t) width * height) {}
+    float *row(int y) { return pixels.data() + (size_t) y * width; }
+    const float *row(int y) const { return pixels.data() + (size_t) y * width; }
+};
+
+void forRows(int rows, ThreadPool *pool, const std::function<void(int begin, int end)> &fn) {
+    if (pool)
+        pool->parallelFor(rows, fn);
+    else
+        fn(0, rows);
+}
+
+Plane lumaPlane(const ImageView &image, ThreadPool *pool) {
+    Plane plane(image.width, image.height);
+    forRows(image.height, pool, [&](int begin, int end) {
+        for (int y = begin; y < end; y++) {
+            const unsigned char *p = image.pixel(0, y);
+            float *out = plane.row(y);
+            if (image.channels == 1) {
+                for (int x = 0; x < image.width; x++)
+                    out[x] = p[x];
+            } else {
+                for (int x = 0; x < image.width; x++, p += image.channels)
+                    out[x] = 0.299f * p[0] + 0.587f * p[1] + 0.114f * p[2];
+            }
+        }
+    });
+    return plane;
+}
+
+// 2x2 box filter, as between MS-SSIM scales
+Plane halve(const Plane &plane) {
+    Plane half(plane.width / 2, plane.height / 2);
+    for (int y = 0; y < half.height; y++) {
+        const float *r0 = plane.row(2 * y), *r1 = plane.row(2 * y + 1);
+        float *out = half.row(y);
+        for (int x = 0; x < half.width; x++)
+            out[x] = (r0[2 * x] + r0[2 * x + 1] + r1[2 * x] + r1[2 * x + 1]) * 0.25f;
+    }
+    return half;
+}
+
+struct SsimMeans {
+    double ssim = 0.0, cs = 0.0;
+};
+
+// Mean SSIM and mean contrast-structure term over every full window (no padding).
+// Each output row is filtered vertically into five row buffers (mu_a, mu_b, E[a^2],
+// E[b^2], E[ab]) and then horizontally; both passes run four columns at a time.
+SsimMeans ssimPlanes(const Plane &a, const Plane &b, ThreadPool *pool) {
+    int w = a.width, h = a.height;
+    if (w < WINDOW || h < WINDOW) {
+        // Too small for the window: one window over the whole image
+        double ma = 0, mb = 0, saa = 0, sbb = 0, sab = 0, n = (double) w * h;
+        for (size_t i = 0; i < a.pixels.size(); i++) {
+            double va = a.pixels[i], vb = b.pixels[i];
+            ma += va; mb += vb; saa += va * va; sbb += vb * vb; sab += va * vb;
+        }
+        ma /= n; mb /= n;
+        double va = saa / n - ma * ma, vb = sbb / n - mb * mb, cov = sab / n - ma * mb;
+        double cs = (2 * cov + C2) / (va + vb + C2);
+        return {(2 * ma * mb + C1) / (ma * ma + mb * mb + C1) * cs, cs};
+    }
+
+    float weights[WINDOW];
+    float total = 0.0f;
+    for (int k = 0; k < WINDOW; k++) {
+        int d = k - WINDOW / 2;
+        weights[k] = std::exp(-(d * d) / (2.0f * 1.5f * 1.5f));
+        total += weights[k];
+    }
+    for (float &weight : weights)
+        weight /= total;
+
+    int outWidth = w - WINDOW + 1, outHeight = h - WINDOW + 1;
+    double ssimSum = 0.0, csSum = 0.0;
+    std::mutex sumMutex;
+    forRows(outHeight, pool, [&](int begin, int end) {
+        std::vector<float> buffers((size_t) w * 5);
+        float *ma = buffers.data(), *mb = ma + w, *saa = mb + w, *sbb = saa + w, *sab = sbb + w;
+        double chunkSsim = 0.0, chunkCs = 0.0;
+        for (int y = begin; y < end; y++) {
+            std::fill(buffers.begin(), buffers.end(), 0.0f);
+            for (int k = 0; k < WINDOW; k++) {
+                const float *ra = a.row(y + k), *rb = b.row(y + k);
+                float wk = weights[k];
+                int x = 0;
+#ifdef UPSCALER_SSE2
+                __m128 vw = _mm_set1_ps(wk);
+                for (; x + 4 <= w; x += 4) {
+                    __m128 va = _mm_loadu_ps(ra + x), vb = _mm_loadu_ps(rb + x);
+                    __m128 wa = _mm_mul_ps(vw, va), wb = _mm_mul_ps(vw, vb);
+                    _mm_storeu_ps(ma + x, _mm_add_ps(_mm_loadu_ps(ma + x), wa));
+                    _mm_storeu_ps(mb + x, _mm_add_ps(_mm_loadu_ps(mb + x), wb));
+                    _mm_storeu_ps(saa + x, _mm_add_ps(_mm_loadu_ps(saa + x), _mm_mul_ps(wa, va)));
+                    _mm_storeu_ps(sbb + x, _mm_add_ps(_mm_loadu_ps(sbb + x), _mm_mul_ps(wb, vb)));
+                    _mm_storeu_ps(sab + x, _mm_add_ps(_mm_loadu_ps(sab + x), _mm_mul_ps(wa, vb)));
+                }
+#endif
+                for (; x < w; x++) {
+                    float wa = wk * ra[x], wb = wk * rb[x];
+                    ma[x] += wa;
+                    mb[x] += wb;
+                    saa[x] += wa * ra[x];
+                    sbb[x] += wb * rb[x];
+                    sab[x] += wa * rb[x];
+                }
+            }
+
+            int x = 0;
+            float rowSsim = 0.0f, rowCs = 0.0f;
+#ifdef UPSCALER_SSE2
+            const __m128 c1 = _mm_set1_ps((float) C1), c2 = _mm_set1_ps((float) C2), two = _mm_set1_ps(2.0f);
+            __m128 ssimAcc = _mm_setzero_ps(), csAcc = _mm_setzero_ps();
+            for (; x + 4 <= outWidth; x += 4) {
+                __m128 ha = _mm_setzero_ps(), hb = _mm_setzero_ps(), haa = _mm_setzero_ps(), hbb = _mm_setzero_ps(),
+                       hab = _mm_setzero_ps();
+                for (int k = 0; k < WINDOW; k++) {
+                    __m128 vw = _mm_set1_ps(weights[k]);
+                    ha = _mm_add_ps(ha, _mm_mul_ps(vw, _mm_loadu_ps(ma + x + k)));
+                    hb = _mm_add_ps(hb, _mm_mul_ps(vw, _mm_loadu_ps(mb + x + k)));
+                    haa = _mm_add_ps(haa, _mm_mul_ps(vw, _mm_loadu_ps(saa + x + k)));
+                    hbb = _mm_add_ps(hbb, _mm_mul_ps(vw, _mm_loadu_ps(sbb + x + k)));
+                    hab = _mm_add_ps(hab, _mm_mul_ps(vw, _mm_loadu_ps(sab + x + k)));
+                }
+                __m128 muAB = _mm_mul_ps(ha, hb), muAA = _mm_mul_ps(ha, ha), muBB = _mm_mul_ps(hb, hb);
+                __m128 varA = _mm_sub_ps(haa, muAA), varB = _mm_sub_ps(hbb, muBB), cov = _mm_sub_ps(hab, muAB);
+                __m128 cs = _mm_div_ps(_mm_add_ps(_mm_mul_ps(two, cov), c2), _mm_add_ps(_mm_add_ps(varA, varB), c2));
+                __m128 l = _mm_div_ps(_mm_add_ps(_mm_mul_ps(two, muAB), c1), _mm_add_ps(_mm_add_ps(muAA, muBB), c1));
+                ssimAcc = _mm_add_ps(ssimAcc, _mm_mul_ps(l, cs));
+                csAcc = _mm_add_ps(csAcc, cs);
+            }
+            float lanes[4];
+            _mm_storeu_ps(lanes, ssimAcc);
+            rowSsim = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+            _mm_storeu_ps(lanes, csAcc);
+            rowCs = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+            for (; x < outWidth; x++) {
+                float ha = 0, hb = 0, haa = 0, hbb = 0, hab = 0;
+                for (int k = 0; k < WINDOW; k++) {
+                    ha += weights[k] * ma[x + k];
+                    hb += weights[k] * mb[x + k];
+                    haa += weights[k] * saa[x + k];
+                    hbb += weights[k] * sbb[x + k];
+                    hab += weights[k] * sab[x + k];
+                }
+                float varA = haa - ha * ha, varB = hbb - hb * hb, cov = hab - ha * hb;
+                float cs = (2 * cov + (float) C2) / (varA + varB + (float) C2);
+                rowSsim += (2 * ha * hb + (float) C1) / (ha * ha + hb * hb + (float) C1) * cs;
+                rowCs += cs;
+            }
+            chunkSsim += rowSsim;
+            chunkCs += rowCs;
+        }
+        std::lock_guard lock(sumMutex);
+        ssimSum += chunkSsim;
+        csSum += chunkCs;
+    });
+
+    double windows = (double) outWidth * outHeight;
+    return {ssimSum / windows, csSum / windows};
+}
+
+// fullScaleSsim, when given, receives plain SSIM (the first scale's), which comes for free
+double msSsimPlanes(const Plane &a, const Plane &b, ThreadPool *pool, double *fullScaleSsim = nullptr) {
+    int scales = 1;
+    while (scales < 5 && std::min(a.width, a.height) >> scales >= WINDOW)
+        scales++;
+    double weightSum = 0.0;
+    for (int i = 0; i < scales; i++)
+        weightSum += MS_SSIM_WEIGHTS[i];
+
+    // Contrast-structure at every scale, luminance only at the coarsest one. Negative
+    // terms (anti-correlated content) are clamped so the weighted product stays defined.
+    double result = 1.0;
+    Plane ca = a, cb = b;
+    for (int i = 0; i < scales; i++) {
+        SsimMeans m = ssimPlanes(ca, cb, pool);
+        if (i == 0 && fullScaleSsim)
+            *fullScaleSsim = m.ssim;
+        double term = i == scales - 1 ? m.ssim : m.cs;
+        result *= std::pow(std::max(term, 0.0), MS_SSIM_WEIGHTS[i] / weightSum);
+        if (i + 1 < scales) {
+            ca = halve(ca);
+            cb = halve(cb);
+        }
+    }
+    return result;
+}
+
+}
+
+double imagePsnr(const ImageView &a, const ImageView &b, ThreadPool *pool) {
+    int colorChannels = a.channels == 4 ? 3 : a.channels;
+    size_t rowBytes = (size_t) a.width * a.channels;
+    uint64_t total = 0;
+    std::mutex totalMutex;
+    forRows(a.height, pool, [&](int begin, int end) {
+        uint64_t sum = 0;
+        for (int y = begin; y < end; y++) {
+            const unsigned char *pa = a.pixel(0, y), *pb = b.pixel(0, y);
+            size_t i = 0;
+#ifdef UPSCALER_SSE2
+            // |a - b| per byte, alpha bytes masked off for RGBA, squared and pair-summed by madd.
+            // 32-bit lanes take at most 2 * 2 * 255^2 per step, flushed every 4096 steps.
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i mask = a.channels == 4 ? _mm_set1_epi32(0x00FFFFFF) : _mm_set1_epi32(-1);
+            while (i + 16 <= rowBytes) {
+                __m128i acc = zero;
+                for (int steps = 0; steps < 4096 && i + 16 <= rowBytes; steps++, i += 16) {
+                    __m128i va = _mm_loadu_si128((const __m128i *) (pa + i));
+                    __m128i vb = _mm_loadu_si128((const __m128i *) (pb + i));
+                    __m128i d = _mm_and_si128(_mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va)), mask);
+                    __m128i lo = _mm_unpacklo_epi8(d, zero), hi = _mm_unpackhi_epi8(d, zero);
+                    acc = _mm_add_epi32(acc, _mm_add_epi32(_mm_madd_epi16(lo, lo), _mm_madd_epi16(hi, hi)));
+                }
+                uint32_t lanes[4];
+                _mm_storeu_si128((__m128i *) lanes, acc);
+                sum += (uint64_t) lanes[0] + lanes[1] + lanes[2] + lanes[3];
+            }
+#endif
+            for (; i < rowBytes; i++) {
+                if (a.channels == 4 && i % 4 == 3)
+                    continue;
+                int d = (int) pa[i] - pb[i];
+                sum += (uint64_t) (d * d);
+            }
+        }
+        std::lock_guard lock(totalMutex);
+        total += sum;
+    });
+    double mse = (double) total / ((double) a.width * a.height * colorChannels);
+    return mse > 0.0 ? std::min(99.0, 10.0 * std::log10(255.0 * 255.0 / mse)) : 99.0;
+}
+
+double imageSsim(const ImageView &a, const ImageView &b, ThreadPool *pool) {
+    return ssimPlanes(lumaPlane(a, pool), lumaPlane(b, pool), pool).ssim;
+}
+
+double imageMsSsim(const ImageView &a, const ImageView &b, ThreadPool *pool) {
+    return msSsimPlanes(lumaPlane(a, pool), lumaPlane(b, pool), pool);
+}
+
+QualityMetrics compareImages(const ImageView &a, const ImageView &b, ThreadPool *pool) {
+    QualityMetrics metrics;
+    metrics.psnr = imagePsnr(a, b, pool);
+    Plane la = lumaPlane(a, pool), lb = lumaPlane(b, pool);
+    metrics.msSsim = msSsimPlanes(la, lb, pool, &metrics.ssim);
+    return metrics;
+}
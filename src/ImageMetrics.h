@@ -0,0 +1,23 @@
+#pragma once
+#include "CpuUpscaler.h"
+
+class ThreadPool;
+
+// Full-reference quality of an upscaled frame against a native render or reference
+// image. Both views must have the same size and channel count (RGBA or one plane).
+//
+// PSNR is over the colour channels (alpha is ignored) and capped at 99 dB for identical
+// images. SSIM and MS-SSIM are computed on BT.601 luma with the usual 11x11 Gaussian
+// window (sigma 1.5, K1 = 0.01, K2 = 0.03); MS-SSIM uses the five-scale weights of
+// Wang et al., dropping (and renormalising) scales too small for the window.
+// Rows are split across the pool when given, and the inner loops use SSE2 where available.
+struct QualityMetrics {
+    double psnr = 0.0, ssim = 0.0, msSsim = 0.0;
+};
+
+double imagePsnr(const ImageView &a, const ImageView &b, ThreadPool *pool = nullptr);
+double imageSsim(const ImageView &a, const ImageView &b, ThreadPool *pool = nullptr);
+double imageMsSsim(const ImageView &a, const ImageView &b, ThreadPool *pool = nullptr);
+
+// All three, converting to luma once
+QualityMetrics compareImages(const ImageView &a, const ImageView &b, ThreadPool *pool = nullptr);
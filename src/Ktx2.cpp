@@ -0,0 +1,184 @@
+#include "Ktx2.h"
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+const unsigned char ktx2Identifier[12] = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+constexpr size_t headerSize = 80;
+constexpr size_t levelIndexEntrySize = 24;
+
+uint32_t readU32(const unsigned char *p) {
+    uint32_t v;
+    std::memcpy(&v, p, 4);
+    return v;
+}
+
+uint64_t readU64(const unsigned char *p) {
+    uint64_t v;
+    std::memcpy(&v, p, 8);
+    return v;
+}
+
+void putU32(std::vector<unsigned char> &out, size_t offset, uint32_t v) {
+    std::memcpy(out.data() + offset, &v, 4);
+}
+
+void putU64(std::vector<unsigned char> &out, size_t offset, uint64_t v) {
+    std::memcpy(out.data() + offset, &v, 8);
+}
+
+// Basic data format descriptor (KDFD 1.3) for a block-compressed format
+std::vector<unsigned char> buildDescriptor(BlockFormat format) {
+    struct Sample { uint32_t bitOffset, bitLength, channel; };
+    std::vector<Sample> samples;
+    uint32_t colorModel;
+    switch (format) {
+        case BlockFormat::BC1: colorModel = 128; samples = {{0, 64, 0}}; break;
+        case BlockFormat::BC3: colorModel = 130; samples = {{0, 64, 15}, {64, 64, 0}}; break;
+        case BlockFormat::BC7: default: colorModel = 133; samples = {{0, 128, 0}}; break;
+    }
+
+    uint32_t blockSize = 24 + 16 * (uint32_t) samples.size();
+    std::vector<unsigned char> dfd(4 + blockSize, 0);
+    putU32(dfd, 0, (uint32_t) dfd.size());
+    putU32(dfd, 4, 0);                                       // vendor 0, descriptor type 0
+    putU32(dfd, 8, 2 | blockSize << 16);                     // version 1.3
+    putU32(dfd, 12, colorModel | 1 << 8 | 1 << 16);          // BT.709 primaries, linear transfer
+    putU32(dfd, 16, 3 | 3 << 8);                             // 4x4x1x1 texel block
+    putU32(dfd, 20, (uint32_t) blockBytes(format));          // bytes in plane 0
+    for (size_t i = 0; i < samples.size(); i++) {
+        size_t o = 28 + 16 * i;
+        putU32(dfd, o, samples[i].bitOffset | (samples[i].bitLength - 1) << 16 | samples[i].channel << 24);
+        putU32(dfd, o + 12, 0xFFFFFFFFu);
+    }
+    return dfd;
+}
+
+}
+
+bool blockFormatFromVk(uint32_t vkFormat, BlockFormat &format) {
+    switch (vkFormat) {
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGBA_UNORM_BLOCK: format = BlockFormat::BC1; return true;
+        case VK_FORMAT_BC3_UNORM_BLOCK: format = BlockFormat::BC3; return true;
+        case VK_FORMAT_BC7_UNORM_BLOCK: format = BlockFormat::BC7; return true;
+        default: return false;
+    }
+}
+
+uint32_t vkFormatFromBlock(BlockFormat format) {
+    switch (format) {
+        case BlockFormat::BC1: return VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+        case BlockFormat::BC3: return VK_FORMAT_BC3_UNORM_BLOCK;
+        case BlockFormat::BC7: return VK_FORMAT_BC7_UNORM_BLOCK;
+    }
+    return 0;
+}
+
+bool loadKtx2(const std::string &path, Ktx2Texture &texture) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+    std::vector<unsigned char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    if (data.size() < headerSize || std::memcmp(data.data(), ktx2Identifier, 12) != 0) {
+        std::cout << "ERROR::KTX2:: Not a KTX2 file: " << path << std::endl;
+        return false;
+    }
+
+    const unsigned char *h = data.data();
+    texture.vkFormat = readU32(h + 12);
+    texture.width = (int) readU32(h + 20);
+    texture.height = (int) readU32(h + 24);
+    uint32_t depth = readU32(h + 28), layers = readU32(h + 32), faces = readU32(h + 36);
+    uint32_t levelCount = std::max(1u, readU32(h + 40));
+    uint32_t supercompression = readU32(h + 44);
+
+    if (depth > 1 || layers > 1 || faces != 1 || supercompression != 0) {
+        std::cout << "ERROR::KTX2:: Only uncompressed single 2D images are supported: " << path << std::endl;
+        return false;
+    }
+    BlockFormat format;
+    if (!blockFormatFromVk(texture.vkFormat, format)) {
+        std::cout << "ERROR::KTX2:: Unsupported format " << texture.vkFormat << " in " << path << std::endl;
+        return false;
+    }
+    // Width and height come from the file as uint32; anything past int or the mip chain is corrupt
+    uint32_t rawWidth = readU32(h + 20), rawHeight = readU32(h + 24);
+    uint32_t maxLevels = (uint32_t) std::bit_width(std::max(rawWidth, rawHeight));
+    if (rawWidth == 0 || rawHeight == 0 || rawWidth > INT32_MAX || rawHeight > INT32_MAX || levelCount > maxLevels) {
+        std::cout << "ERROR::KTX2:: Invalid size " << rawWidth << "x" << rawHeight << " with " << levelCount
+                  << " levels in " << path << std::endl;
+        return false;
+    }
+    if (data.size() < headerSize + (uint64_t) levelCount * levelIndexEntrySize)
+        return false;
+
+    texture.levels.assign(levelCount, {});
+    for (uint32_t level = 0; level < levelCount; level++) {
+        const unsigned char *entry = h + headerSize + level * levelIndexEntrySize;
+        uint64_t offset = readU64(entry), length = readU64(entry + 8);
+        if (offset > data.size() || length > data.size() - offset) {
+            std::cout << "ERROR::KTX2:: Truncated level " << level << " in " << path << std::endl;
+            return false;
+        }
+        // The loaders decode w x h blocks straight from the level, so it must hold exactly that many
+        uint64_t blocksX = (std::max(1u, rawWidth >> level) + 3) / 4, blocksY = (std::max(1u, rawHeight >> level) + 3) / 4;
+        if (length != blocksX * blocksY * (uint64_t) blockBytes(format)) {
+            std::cout << "ERROR::KTX2:: Level " << level << " has " << length << " bytes, expected "
+                      << blocksX * blocksY * blockBytes(format) << " in " << path << std::endl;
+            return false;
+        }
+        texture.levels[level].assign(data.begin() + (long) offset, data.begin() + (long) (offset + length));
+    }
+    return true;
+}
+
+bool saveKtx2(const std::string &path, const Ktx2Texture &texture) {
+    BlockFormat format;
+    if (!blockFormatFromVk(texture.vkFormat, format))
+        return false;
+
+    std::vector<unsigned char> dfd = buildDescriptor(format);
+    size_t levelCount = texture.levels.size();
+    size_t dfdOffset = headerSize + levelCount * levelIndexEntrySize;
+    size_t alignment = (size_t) blockBytes(format);
+
+    // Mip data follows the descriptor, smallest level first, aligned to the block size
+    size_t offset = dfdOffset + dfd.size();
+    std::vector<size_t> levelOffsets(levelCount);
+    for (size_t level = levelCount; level-- > 0;) {
+        offset = (offset + alignment - 1) / alignment * alignment;
+        levelOffsets[level] = offset;
+        offset += texture.levels[level].size();
+    }
+
+    std::vector<unsigned char> out(offset, 0);
+    std::memcpy(out.data(), ktx2Identifier, 12);
+    putU32(out, 12, texture.vkFormat);
+    putU32(out, 16, 1);
+    putU32(out, 20, (uint32_t) texture.width);
+    putU32(out, 24, (uint32_t) texture.height);
+    putU32(out, 36, 1);
+    putU32(out, 40, (uint32_t) levelCount);
+    putU32(out, 48, (uint32_t) dfdOffset);
+    putU32(out, 52, (uint32_t) dfd.size());
+
+    for (size_t level = 0; level < levelCount; level++) {
+        size_t entry = headerSize + level * levelIndexEntrySize;
+        putU64(out, entry, levelOffsets[level]);
+        putU64(out, entry + 8, texture.levels[level].size());
+        putU64(out, entry + 16, texture.levels[level].size());
+        std::memcpy(out.data() + levelOffsets[level], texture.levels[level].data(), texture.levels[level].size());
+    }
+    std::memcpy(out.data() + dfdOffset, dfd.data(), dfd.size());
+
+    std::ofstream file(path, std::ios::binary);
+    file.write((const char *) out.data(), (std::streamsize) out.size());
+    return (bool) file;
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include "BlockCompression.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Vulkan format ids used by KTX2 for the block formats we handle
+constexpr uint32_t VK_FORMAT_BC1_RGB_UNORM_BLOCK = 131;
+constexpr uint32_t VK_FORMAT_BC1_RGBA_UNORM_BLOCK = 133;
+constexpr uint32_t VK_FORMAT_BC3_UNORM_BLOCK = 137;
+constexpr uint32_t VK_FORMAT_BC7_UNORM_BLOCK = 145;
+
+// Single-layer, single-face 2D texture without supercompression.
+// Levels are stored largest first; rows are top-down as in the source image.
+struct Ktx2Texture {
+    uint32_t vkFormat = 0;
+    int width = 0, height = 0;
+    std::vector<std::vector<unsigned char>> levels;
+};
+
+bool loadKtx2(const std::string &path, Ktx2Texture &texture);
+bool saveKtx2(const std::string &path, const Ktx2Texture &texture);
+
+bool blockFormatFromVk(uint32_t vkFormat, BlockFormat &format);
+uint32_t vkFormatFromBlock(BlockFormat format);
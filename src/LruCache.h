@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Least-recently-used map from 64-bit keys, bounded by entry count. Not thread-safe.
+// Evicted values are handed back so callers can recycle them (textures, buffers).
+template<typename Value>
+class LruCache {
+public:
+    explicit LruCache(size_t capacity) : capacity(capacity) {}
+
+    // Marks the entry as most recently used.
+    Value *find(uint64_t key) {
+        auto it = index.find(key);
+        if (it == index.end())
+            return nullptr;
+        order.splice(order.begin(), order, it->second);
+        return &it->second->second;
+    }
+
+    bool contains(uint64_t key) const { return index.count(key) != 0; }
+
+    void insert(uint64_t key, Value value, std::vector<Value> &evicted) {
+        if (Value *existing = find(key)) {
+            evicted.push_back(std::move(*existing));
+            *existing = std::move(value);
+            return;
+        }
+        order.emplace_front(key, std::move(value));
+        index[key] = order.begin();
+        trim(evicted);
+    }
+
+    // Drops least recently used entries until the cache fits its capacity.
+    void trim(std::vector<Value> &evicted) {
+        while (order.size() > capacity) {
+            evicted.push_back(std::move(order.back().second));
+            index.erase(order.back().first);
+            order.pop_back();
+        }
+    }
+
+    void clear(std::vector<Value> &evicted) {
+        for (auto &entry : order)
+            evicted.push_back(std::move(entry.second));
+        order.clear();
+        index.clear();
+    }
+
+    size_t size() const { return order.size(); }
+
+    size_t capacity;
+
+private:
+    std::list<std::pair<uint64_t, Value>> order;
+    std::unordered_map<uint64_t, typename std::list<std::pair<uint64_t, Value>>::iterator> index;
+};
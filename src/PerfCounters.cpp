@@ -0,0 +1,130 @@
+#include "PerfCounters.h"
+#include "ThreadPool.h"
+#include <mutex>
+
+#ifdef __linux__
+#include <latch>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define UPSCALER_PERF_EVENTS 1
+#endif
+
+namespace {
+
+#ifdef UPSCALER_PERF_EVENTS
+
+struct EventConfig {
+    uint32_t type;
+    uint64_t config;
+};
+
+constexpr uint64_t cacheConfig(uint64_t cache, uint64_t op, uint64_t result) {
+    return cache | op << 8 | result << 16;
+}
+
+const EventConfig EVENT_CONFIGS[PerfSample::EventCount] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HW_CACHE, cacheConfig(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS)},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+};
+
+// Counts the calling thread only, on any CPU; -1 if the event can't be opened here
+int openEvent(const EventConfig &event) {
+    perf_event_attr attr = {};
+    attr.size = sizeof(attr);
+    attr.type = event.type;
+    attr.config = event.config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+#endif
+
+}
+
+PerfCounters::PerfCounters(ThreadPool *pool) {
+#ifdef UPSCALER_PERF_EVENTS
+    std::mutex mutex;
+    auto openHere = [&] {
+        for (int e = 0; e < PerfSample::EventCount; e++) {
+            int fd = openEvent(EVENT_CONFIGS[e]);
+            if (fd >= 0) {
+                std::lock_guard lock(mutex);
+                fds[e].push_back(fd);
+            }
+        }
+    };
+    openHere();
+    if (pool && pool->size() > 0) {
+        // Every task waits for all the others, so each worker runs exactly one
+        std::latch allStarted((std::ptrdiff_t) pool->size());
+        for (unsigned int i = 0; i < pool->size(); i++) {
+            pool->enqueue([&] {
+                allStarted.arrive_and_wait();
+                openHere();
+            });
+        }
+        pool->wait();
+    }
+#else
+    (void) pool;
+#endif
+}
+
+PerfCounters::~PerfCounters() {
+#ifdef UPSCALER_PERF_EVENTS
+    for (auto &eventFds : fds)
+        for (int fd : eventFds)
+            close(fd);
+#endif
+}
+
+bool PerfCounters::available() const {
+    return !fds[PerfSample::Cycles].empty();
+}
+
+const char *PerfCounters::eventName(PerfSample::Event event) {
+    switch (event) {
+        case PerfSample::Cycles: return "cycles";
+        case PerfSample::Instructions: return "instructions";
+        case PerfSample::L1dMisses: return "L1D read misses";
+        case PerfSample::LlcMisses: return "LLC misses";
+        case PerfSample::BranchMisses: return "branch misses";
+        default: return "?";
+    }
+}
+
+void PerfCounters::start() {
+#ifdef UPSCALER_PERF_EVENTS
+    for (auto &eventFds : fds) {
+        for (int fd : eventFds) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#endif
+}
+
+PerfSample PerfCounters::stop() {
+    PerfSample sample;
+#ifdef UPSCALER_PERF_EVENTS
+    for (int e = 0; e < PerfSample::EventCount; e++) {
+        for (int fd : fds[e]) {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            uint64_t values[3] = {}; // value, time enabled, time running
+            if (read(fd, values, sizeof(values)) != (ssize_t) sizeof(values) || values[2] == 0)
+                continue;
+            sample.counts[e] += values[1] > values[2] ? (double) values[0] * values[1] / values[2] : (double) values[0];
+            sample.valid[e] = true;
+        }
+    }
+#endif
+    return sample;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+// Hardware counters (perf_event_open) over a span of work on the calling thread and,
+// when given, every worker of a pool. User-space only, so perf_event_paranoid <= 2 is
+// enough. Each event is opened on its own and scaled by its running time if the PMU
+// had to multiplex; events the CPU or kernel don't offer read as missing. On other
+// platforms, or where no PMU is exposed (most VMs and containers), nothing is available.
+struct PerfSample {
+    enum Event { Cycles, Instructions, L1dMisses, LlcMisses, BranchMisses, EventCount };
+
+    double counts[EventCount] = {};
+    bool valid[EventCount] = {};
+
+    double ipc() const {
+        return valid[Cycles] && valid[Instructions] && counts[Cycles] > 0 ? counts[Instructions] / counts[Cycles] : 0.0;
+    }
+};
+
+class PerfCounters {
+public:
+    // Opening on the pool runs one task per worker, so the pool must be idle
+    explicit PerfCounters(ThreadPool *pool = nullptr);
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters &) = delete;
+    PerfCounters &operator=(const PerfCounters &) = delete;
+
+    bool available() const;
+    static const char *eventName(PerfSample::Event event);
+
+    // Resets and enables every counter / disables them and sums all threads
+    void start();
+    PerfSample stop();
+
+private:
+    // fds[event] holds that event's descriptor on each thread
+    std::vector<int> fds[PerfSample::EventCount];
+};
@@ -0,0 +1,312 @@
+#include "PolyphaseFilter.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <array>
+#include <numeric>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define UPSCALER_SSE2 1
+#endif
+
+namespace {
+
+constexpr double PI = 3.14159265358979323846;
+
+// std::sin only becomes constexpr in C++26; a Taylor series after reducing to [-pi, pi]
+constexpr double constexprSin(double x) {
+    double turns = x / (2.0 * PI);
+    x -= (double) (long long) (turns >= 0.0 ? turns + 0.5 : turns - 0.5) * 2.0 * PI;
+    double term = x, sum = x;
+    for (int n = 1; n < 12; n++) {
+        term *= -x * x / ((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+// Mitchell-Netravali family: B = 0, C = 0.5 is Catmull-Rom
+constexpr double cubicWeight(double b, double c, double x) {
+    if (x < 1.0)
+        return ((12.0 - 9.0 * b - 6.0 * c) * x * x * x + (-18.0 + 12.0 * b + 6.0 * c) * x * x + (6.0 - 2.0 * b)) / 6.0;
+    if (x < 2.0)
+        return ((-b - 6.0 * c) * x * x * x + (6.0 * b + 30.0 * c) * x * x + (-12.0 * b - 48.0 * c) * x +
+                (8.0 * b + 24.0 * c)) / 6.0;
+    return 0.0;
+}
+
+constexpr double lanczosWeight(int a, double x) {
+    if (x < 1e-9)
+        return 1.0;
+    if (x >= a)
+        return 0.0;
+    return a * constexprSin(PI * x) * constexprSin(PI * x / a) / (PI * PI * x * x);
+}
+
+constexpr int kernelRadius(FilterKernel kernel) {
+    return kernel == FilterKernel::Lanczos3 ? 3 : 2;
+}
+
+constexpr double kernelWeight(FilterKernel kernel, double x) {
+    x = x < 0.0 ? -x : x;
+    switch (kernel) {
+        case FilterKernel::CatmullRom: return cubicWeight(0.0, 0.5, x);
+        case FilterKernel::Mitchell: return cubicWeight(1.0 / 3.0, 1.0 / 3.0, x);
+        case FilterKernel::Lanczos2: return lanczosWeight(2, x);
+        case FilterKernel::Lanczos3: return lanczosWeight(3, x);
+    }
+    return 0.0;
+}
+
+// Always even: the SIMD passes take the taps in pairs
+constexpr int tapCount(FilterKernel kernel, int phases, int step) {
+    int radius = kernelRadius(kernel);
+    return step > phases ? 2 * ((radius * step + phases - 1) / phases) : 2 * radius;
+}
+
+constexpr long long floorDiv(long long a, long long b) {
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+// First tap and fixed-point weights of one phase; shared by the compile-time presets and
+// buildPolyphaseTable, so both produce the same bits
+constexpr void computePhase(FilterKernel kernel, int phases, int step, int taps, int phase, int &offset,
+                            int16_t *weights) {
+    // Source position of output pixel `phase`, in units of 1 / (2 * phases) source pixels
+    long long position = (2LL * phase + 1) * step - phases;
+    long long base = floorDiv(position, 2LL * phases);
+    double frac = (double) (position - base * 2 * phases) / (2.0 * phases);
+    // Downscaling stretches the kernel over the source pixels each output pixel covers
+    double stretch = step > phases ? (double) step / phases : 1.0;
+    offset = (int) base - taps / 2 + 1;
+
+    double sum = 0.0;
+    for (int t = 0; t < taps; t++)
+        sum += kernelWeight(kernel, (frac + taps / 2 - 1 - t) / stretch);
+    int total = 0, largest = 0;
+    for (int t = 0; t < taps; t++) {
+        double w = kernelWeight(kernel, (frac + taps / 2 - 1 - t) / stretch) / sum * (1 << PolyphaseTable::WEIGHT_BITS);
+        weights[t] = (int16_t) (w >= 0.0 ? (int) (w + 0.5) : -(int) (-w + 0.5));
+        total += weights[t];
+        if ((weights[t] < 0 ? -weights[t] : weights[t]) > (weights[largest] < 0 ? -weights[largest] : weights[largest]))
+            largest = t;
+    }
+    // Rounding residue goes on the centre tap, so flat areas stay exactly flat
+    weights[largest] = (int16_t) (weights[largest] + (1 << PolyphaseTable::WEIGHT_BITS) - total);
+}
+
+template<FilterKernel K, int P, int Q>
+struct PresetTable {
+    static constexpr int TAPS = tapCount(K, P, Q);
+    std::array<int, P> offsets{};
+    std::array<int16_t, P * TAPS> weights{};
+
+    constexpr PresetTable() {
+        for (int phase = 0; phase < P; phase++)
+            computePhase(K, P, Q, TAPS, phase, offsets[phase], weights.data() + phase * TAPS);
+    }
+};
+
+template<FilterKernel K, int P, int Q>
+constexpr PresetTable<K, P, Q> PRESET_TABLE{};
+
+// Catmull-Rom at 2x: phase 0 samples 0.75 of the way between two source pixels
+static_assert(PRESET_TABLE<FilterKernel::CatmullRom, 2, 1>.weights[0] == -384 &&
+              PRESET_TABLE<FilterKernel::CatmullRom, 2, 1>.weights[1] == 3712 &&
+              PRESET_TABLE<FilterKernel::CatmullRom, 2, 1>.weights[2] == 14208 &&
+              PRESET_TABLE<FilterKernel::CatmullRom, 2, 1>.weights[3] == -1152);
+
+struct PresetEntry {
+    FilterKernel kernel;
+    int phases, step, taps;
+    const int *offsets;
+    const int16_t *weights;
+};
+
+template<FilterKernel K, int P, int Q>
+constexpr PresetEntry presetEntry() {
+    return {K, P, Q, PresetTable<K, P, Q>::TAPS, PRESET_TABLE<K, P, Q>.offsets.data(),
+            PRESET_TABLE<K, P, Q>.weights.data()};
+}
+
+// The SCALE_PRESETS ratios (1.3, 1.5, 1.7, 2, 3) for every kernel
+template<FilterKernel... Ks>
+constexpr auto presetEntries() {
+    return std::array{presetEntry<Ks, 13, 10>()..., presetEntry<Ks, 3, 2>()..., presetEntry<Ks, 17, 10>()...,
+                      presetEntry<Ks, 2, 1>()..., presetEntry<Ks, 3, 1>()...};
+}
+
+constexpr auto PRESET_ENTRIES = presetEntries<FilterKernel::CatmullRom, FilterKernel::Mitchell,
+                                              FilterKernel::Lanczos2, FilterKernel::Lanczos3>();
+
+// The intermediate holds 8.6 fixed point, so ringing below 0 and above 255 survives until
+// the vertical pass clamps
+constexpr int INTERMEDIATE_BITS = 6;
+constexpr int HORIZONTAL_SHIFT = PolyphaseTable::WEIGHT_BITS - INTERMEDIATE_BITS;
+constexpr int VERTICAL_SHIFT = PolyphaseTable::WEIGHT_BITS + INTERMEDIATE_BITS;
+
+// Taps t and t + 1 as the (lo, hi) 16-bit pair _mm_madd_epi16 wants
+int32_t weightPair(const int16_t *weights) {
+    return (int32_t) ((uint32_t) (uint16_t) weights[0] | ((uint32_t) (uint16_t) weights[1] << 16));
+}
+
+void horizontalRows(const ImageView &src, const PolyphaseTable &table, int dstWidth, int y0, int y1, int16_t *out) {
+    // Columns [inside0, inside1) read no clamped taps, so they take the unclamped path
+    thread_local std::vector<int> first;
+    first.resize(dstWidth);
+    int inside0 = dstWidth, inside1 = 0;
+    for (int x = 0; x < dstWidth; x++) {
+        first[x] = table.firstTap(x);
+        if (first[x] >= 0 && first[x] + table.taps <= src.width) {
+            inside0 = std::min(inside0, x);
+            inside1 = x + 1;
+        }
+    }
+
+    auto clampedPixel = [&](const unsigned char *row, int x, int16_t *o) {
+        const int16_t *w = table.phaseWeights(x);
+        int sum[4] = {};
+        for (int t = 0; t < table.taps; t++) {
+            const unsigned char *p = row + std::clamp(first[x] + t, 0, src.width - 1) * 4;
+            for (int c = 0; c < 4; c++)
+                sum[c] += w[t] * p[c];
+        }
+        for (int c = 0; c < 4; c++)
+            o[c] = (int16_t) std::clamp((sum[c] + (1 << (HORIZONTAL_SHIFT - 1))) >> HORIZONTAL_SHIFT, -32768, 32767);
+    };
+
+    for (int y = y0; y < y1; y++) {
+        const unsigned char *row = src.pixel(0, y);
+        int16_t *o = out + (size_t) (y - y0) * dstWidth * 4;
+        for (int x = 0; x < std::min(inside0, dstWidth); x++)
+            clampedPixel(row, x, o + x * 4);
+        for (int x = inside0; x < inside1; x++) {
+            const int16_t *w = table.phaseWeights(x);
+            const unsigned char *p = row + first[x] * 4;
+#ifdef UPSCALER_SSE2
+            // Two neighbouring pixels per step: interleave them channel by channel, then one
+            // multiply-add with the two taps' weights gives four 32-bit channel sums
+            const __m128i zero = _mm_setzero_si128();
+            __m128i acc = _mm_set1_epi32(1 << (HORIZONTAL_SHIFT - 1));
+            for (int t = 0; t < table.taps; t += 2) {
+                __m128i pair = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *) (p + t * 4)), zero);
+                pair = _mm_unpacklo_epi16(pair, _mm_srli_si128(pair, 8));
+                acc = _mm_add_epi32(acc, _mm_madd_epi16(pair, _mm_set1_epi32(weightPair(w + t))));
+            }
+            acc = _mm_srai_epi32(acc, HORIZONTAL_SHIFT);
+            _mm_storel_epi64((__m128i *) (o + x * 4), _mm_packs_epi32(acc, acc));
+#else
+            int sum[4] = {};
+            for (int t = 0; t < table.taps; t++)
+                for (int c = 0; c < 4; c++)
+                    sum[c] += w[t] * p[t * 4 + c];
+            for (int c = 0; c < 4; c++)
+                o[x * 4 + c] = (int16_t) std::clamp((sum[c] + (1 << (HORIZONTAL_SHIFT - 1))) >> HORIZONTAL_SHIFT,
+                                                    -32768, 32767);
+#endif
+        }
+        for (int x = std::max(inside1, inside0); x < dstWidth; x++)
+            clampedPixel(row, x, o + x * 4);
+    }
+}
+
+void verticalRows(const int16_t *intermediate, int srcHeight, const PolyphaseTable &table,
+                  const MutableImageView &dst, int y0, int y1) {
+    size_t values = (size_t) dst.width * 4;
+    thread_local std::vector<const int16_t *> rows;
+    rows.resize(table.taps);
+    for (int y = y0; y < y1; y++) {
+        int first = table.firstTap(y);
+        const int16_t *w = table.phaseWeights(y);
+        for (int t = 0; t < table.taps; t++)
+            rows[t] = intermediate + (size_t) std::clamp(first + t, 0, srcHeight - 1) * values;
+        unsigned char *o = dst.pixel(0, y);
+
+        size_t i = 0;
+#ifdef UPSCALER_SSE2
+        // Eight values (two pixels) per step; rows t and t + 1 interleaved into one multiply-add
+        const __m128i round = _mm_set1_epi32(1 << (VERTICAL_SHIFT - 1));
+        for (; i + 8 <= values; i += 8) {
+            __m128i lo = round, hi = round;
+            for (int t = 0; t < table.taps; t += 2) {
+                __m128i a = _mm_loadu_si128((const __m128i *) (rows[t] + i));
+                __m128i b = _mm_loadu_si128((const __m128i *) (rows[t + 1] + i));
+                __m128i pair = _mm_set1_epi32(weightPair(w + t));
+                lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), pair));
+                hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(a, b), pair));
+            }
+            __m128i packed = _mm_packs_epi32(_mm_srai_epi32(lo, VERTICAL_SHIFT), _mm_srai_epi32(hi, VERTICAL_SHIFT));
+            _mm_storel_epi64((__m128i *) (o + i), _mm_packus_epi16(packed, packed));
+        }
+#endif
+        for (; i < values; i++) {
+            int sum = 1 << (VERTICAL_SHIFT - 1);
+            for (int t = 0; t < table.taps; t++)
+                sum += w[t] * rows[t][i];
+            o[i] = (unsigned char) std::clamp(sum >> VERTICAL_SHIFT, 0, 255);
+        }
+    }
+}
+
+}
+
+const char *filterKernelName(FilterKernel kernel) {
+    switch (kernel) {
+        case FilterKernel::CatmullRom: return "catmull-rom";
+        case FilterKernel::Mitchell: return "mitchell";
+        case FilterKernel::Lanczos2: return "lanczos2";
+        case FilterKernel::Lanczos3: return "lanczos3";
+    }
+    return "?";
+}
+
+bool parseFilterKernel(const std::string &name, FilterKernel &kernel) {
+    for (FilterKernel k : ALL_FILTER_KERNELS) {
+        if (name == filterKernelName(k)) {
+            kernel = k;
+            return true;
+        }
+    }
+    return false;
+}
+
+PolyphaseTable buildPolyphaseTable(FilterKernel kernel, int srcSize, int dstSize) {
+    int divisor = std::gcd(srcSize, dstSize);
+    PolyphaseTable table;
+    table.phases = dstSize / divisor;
+    table.step = srcSize / divisor;
+    table.taps = tapCount(kernel, table.phases, table.step);
+    table.offsets.resize(table.phases);
+    table.weights.resize((size_t) table.phases * table.taps);
+
+    for (const PresetEntry &preset : PRESET_ENTRIES) {
+        if (preset.kernel == kernel && preset.phases == table.phases && preset.step == table.step) {
+            std::copy(preset.offsets, preset.offsets + table.phases, table.offsets.begin());
+            std::copy(preset.weights, preset.weights + table.weights.size(), table.weights.begin());
+            return table;
+        }
+    }
+    for (int phase = 0; phase < table.phases; phase++)
+        computePhase(kernel, table.phases, table.step, table.taps, phase, table.offsets[phase],
+                     table.weights.data() + (size_t) phase * table.taps);
+    return table;
+}
+
+void upscaleSeparable(const ImageView &src, const MutableImageView &dst, const PolyphaseTable &x,
+                      const PolyphaseTable &y, std::vector<int16_t> &intermediate, ThreadPool *pool) {
+    size_t rowValues = (size_t) dst.width * 4;
+    intermediate.resize(rowValues * src.height);
+    auto horizontal = [&](int begin, int end) {
+        horizontalRows(src, x, dst.width, begin, end, intermediate.data() + (size_t) begin * rowValues);
+    };
+    auto vertical = [&](int begin, int end) {
+        verticalRows(intermediate.data(), src.height, y, dst, begin, end);
+    };
+    if (!pool) {
+        horizontal(0, src.height);
+        vertical(0, dst.height);
+        return;
+    }
+    pool->parallelFor(src.height, horizontal);
+    pool->parallelFor(dst.height, vertical);
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "CpuUpscaler.h"
+
+class ThreadPool;
+
+// Separable resampling kernels, as baselines for the demo's shaders
+enum class FilterKernel { CatmullRom, Mitchell, Lanczos2, Lanczos3 };
+
+inline constexpr FilterKernel ALL_FILTER_KERNELS[] = {FilterKernel::CatmullRom, FilterKernel::Mitchell,
+                                                      FilterKernel::Lanczos2, FilterKernel::Lanczos3};
+
+// "catmull-rom", "mitchell", "lanczos2", "lanczos3"
+const char *filterKernelName(FilterKernel kernel);
+bool parseFilterKernel(const std::string &name, FilterKernel &kernel);
+
+// Weights for one axis. With dstSize / srcSize = phases / step in lowest terms, output
+// pixels i and i + phases see the same fractional source position, step source pixels
+// apart, so one row of taps per phase covers the whole axis. Same mapping as the other
+// modes (texel centers); taps beyond the edge are clamped to it.
+struct PolyphaseTable {
+    static constexpr int WEIGHT_BITS = 14;
+
+    int phases = 0, step = 0, taps = 0;
+    // Per phase: first source tap, relative to the start of its period
+    std::vector<int> offsets;
+    // phases x taps, fixed point; every phase sums to exactly 1 << WEIGHT_BITS
+    std::vector<int16_t> weights;
+
+    int firstTap(int i) const { return (i / phases) * step + offsets[i % phases]; }
+    const int16_t *phaseWeights(int i) const { return weights.data() + (size_t) (i % phases) * taps; }
+};
+
+// Built once per kernel and ratio. The FSR preset ratios (13:10, 3:2, 17:10, 2:1, 3:1)
+// come from tables computed at compile time; downscaling widens the kernel.
+PolyphaseTable buildPolyphaseTable(FilterKernel kernel, int srcSize, int dstSize);
+
+// RGBA8 only: a horizontal pass into a 16-bit intermediate (dst.width x src.height,
+// kept in `intermediate` between calls), then a vertical pass into dst. Both passes
+// are split by rows across the pool when given, and use SSE2 where available.
+void upscaleSeparable(const ImageView &src, const MutableImageView &dst, const PolyphaseTable &x,
+                      const PolyphaseTable &y, std::vector<int16_t> &intermediate, ThreadPool *pool = nullptr);
@@ -0,0 +1,38 @@
+#include "RectBatch.h"
+#include "GpuMemory.h"
+#include <glad/glad.h>
+
+RectBatch::RectBatch() {
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void *) 0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void *) (3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    glBindVertexArray(0);
+}
+
+RectBatch::~RectBatch() {
+    glDeleteVertexArrays(1, &vao);
+    gpuDeleteBuffers(1, &vbo);
+}
+
+void RectBatch::draw(const std::vector<PixelRect> &rects, int width, int height) {
+    if (rects.empty())
+        return;
+    vertices.clear();
+    for (const PixelRect &r : rects) {
+        float u0 = (float) r.x0 / width, u1 = (float) r.x1 / width;
+        float v0 = (float) r.y0 / height, v1 = (float) r.y1 / height;
+        float corners[6][2] = {{u0, v1}, {u0, v0}, {u1, v0}, {u0, v1}, {u1, v0}, {u1, v1}};
+        for (auto &c : corners)
+            vertices.insert(vertices.end(), {c[0] * 2.0f - 1.0f, c[1] * 2.0f - 1.0f, 0.0f, c[0], c[1]});
+    }
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    gpuBufferData(vbo, GL_ARRAY_BUFFER, "rect batch", vertices.size() * sizeof(float), vertices.data(), GL_STREAM_DRAW);
+    glDrawArrays(GL_TRIANGLES, 0, (int) rects.size() * 6);
+    glBindVertexArray(0);
+}
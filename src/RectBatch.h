@@ -0,0 +1,19 @@
+#pragma once
+#include <vector>
+#include "DirtyTiles.h"
+
+// Draws a list of pixel rects of a width x height target in a single call, as quads in
+// the vertex.txt layout (NDC position, texcoord spanning the whole target), so tile
+// lists cost one draw instead of one scissored full-screen quad each.
+// Needs a current GL 3.3 context.
+class RectBatch {
+public:
+    RectBatch();
+    ~RectBatch();
+
+    void draw(const std::vector<PixelRect> &rects, int width, int height);
+
+private:
+    std::vector<float> vertices;
+    unsigned int vao = 0, vbo = 0;
+};
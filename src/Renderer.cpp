@@ -1,4 +1,5 @@
 #include "Renderer.h"
+#include "GpuMemory.h"
 #include <iostream>
 
 void Renderer::initQuad() {
@@ -17,7 +18,7 @@ void Renderer::initQuad() {
     glGenBuffers(1, &VBO);
     glBindVertexArray(VAO);
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
+    gpuBufferData(VBO, GL_ARRAY_BUFFER, "quad", sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
 
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
@@ -32,7 +33,8 @@ void Renderer::initFBO(int width, int height) {
     // 1️⃣ Create a color texture (linear)
     glGenTextures(1, &fboTextureLinear);
     glBindTexture(GL_TEXTURE_2D, fboTextureLinear);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+    gpuTexImage2D(fboTextureLinear, GpuMemoryCategory::RenderTarget, "scene color", 0, GL_RGB, width, height, GL_RGB,
+                  GL_UNSIGNED_BYTE, nullptr);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, fboTextureLinear, 0);
@@ -40,16 +42,35 @@ void Renderer::initFBO(int width, int height) {
     // 2️⃣ Create a color texture (nearest) for testing
     glGenTextures(1, &fboTextureNearest);
     glBindTexture(GL_TEXTURE_2D, fboTextureNearest);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+    gpuTexImage2D(fboTextureNearest, GpuMemoryCategory::RenderTarget, "scene color (nearest)", 0, GL_RGB, width, height,
+                  GL_RGB, GL_UNSIGNED_BYTE, nullptr);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
-    // 3️⃣ Create depth renderbuffer
-    unsigned int rbo;
-    glGenRenderbuffers(1, &rbo);
-    glBindRenderbuffer(GL_RENDERBUFFER, rbo);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rbo);
+    // 3️⃣ Create the velocity texture (second colour attachment)
+    glGenTextures(1, &fboVelocityTexture);
+    glBindTexture(GL_TEXTURE_2D, fboVelocityTexture);
+    gpuTexImage2D(fboVelocityTexture, GpuMemoryCategory::RenderTarget, "scene velocity", 0, GL_RG16F, width, height,
+                  GL_RG, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, fboVelocityTexture, 0);
+
+    unsigned int attachments[] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+    glDrawBuffers(2, attachments);
+
+    // 4️⃣ Create a depth-stencil texture (sampleable, unlike a renderbuffer)
+    glGenTextures(1, &fboDepthTexture);
+    glBindTexture(GL_TEXTURE_2D, fboDepthTexture);
+    gpuTexImage2D(fboDepthTexture, GpuMemoryCategory::RenderTarget, "scene depth", 0, GL_DEPTH24_STENCIL8, width, height,
+                  GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, fboDepthTexture, 0);
 
     if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
         std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << std::endl;
@@ -57,10 +78,25 @@ void Renderer::initFBO(int width, int height) {
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
+void Renderer::releaseQuad() {
+    glDeleteVertexArrays(1, &VAO);
+    gpuDeleteBuffers(1, &VBO);
+}
 
-
+void Renderer::releaseFBO() {
+    unsigned int textures[] = {fboTextureLinear, fboTextureNearest, fboVelocityTexture, fboDepthTexture};
+    gpuDeleteTextures(4, textures);
+    glDeleteFramebuffers(1, &fbo);
+}
 
 void Renderer::renderQuad() {
     glBindVertexArray(VAO);
     glDrawArrays(GL_TRIANGLES, 0, 6);
 }
+
+void Renderer::clearFBO(float r, float g, float b) {
+    float color[] = {r, g, b, 1.0f}, noMotion[] = {0.0f, 0.0f, 0.0f, 0.0f};
+    glClearBufferfv(GL_COLOR, 0, color);
+    glClearBufferfv(GL_COLOR, 1, noMotion);
+    glClearBufferfi(GL_DEPTH_STENCIL, 0, 1.0f, 0);
+}
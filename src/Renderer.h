@@ -6,9 +6,16 @@
 class Renderer {
 public:
     unsigned int VAO, VBO;
-    unsigned int fbo, fboTextureLinear, fboTextureNearest, fboDepthTexture;
+    // Scene target: colour (attachment 0), screen-space motion in UV units (attachment 1,
+    // RG16F) and a sampleable depth-stencil texture
+    unsigned int fbo, fboTextureLinear, fboTextureNearest, fboVelocityTexture, fboDepthTexture;
 
     void initQuad();
     void initFBO(int width, int height);
+    // Frees what initQuad / initFBO created (Renderer has no destructor: copies share the objects)
+    void releaseQuad();
+    void releaseFBO();
     void renderQuad();
+    // Clears the bound scene target: colour to the background, motion to zero, depth and stencil
+    void clearFBO(float r, float g, float b);
 };
@@ -9,5 +9,6 @@ public:
     void setInt(const std::string &name, int value) const;
     void setMat4(const std::string &name, const glm::mat4 &mat) const;
     void setVec2(const std::string &name, const glm::vec2 &value) const;
+    void setVec4(const std::string &name, const glm::vec4 &value) const;
     void setFloat(const std::string &name, float value) const;
 };
@@ -0,0 +1,232 @@
+#include "SharedFrameRing.h"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <iostream>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// head and tail are free-running frame counters; head - tail frames are readable.
+// Each counter has a flag its waiter raises before sleeping, so the other side
+// only pays for FUTEX_WAKE when somebody is actually asleep.
+struct SharedFrameRing::Header {
+    uint32_t magic;
+    uint32_t slotCount;
+    int32_t width, height;
+    uint64_t frameBytes, slotBytes, dataOffset;
+
+    alignas(64) std::atomic<uint32_t> head;
+    std::atomic<uint32_t> consumerWaiting;
+    alignas(64) std::atomic<uint32_t> tail;
+    std::atomic<uint32_t> producerWaiting;
+    alignas(64) std::atomic<uint32_t> closed;
+
+    SharedFrameInfo slots[SHARED_RING_MAX_SLOTS];
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "futex words must be plain 32-bit integers");
+
+namespace {
+
+constexpr size_t PAGE = 4096;
+constexpr int SPIN_ITERATIONS = 2000;
+
+size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// Shared (not FUTEX_PRIVATE) operations: the word lives in memory mapped by two processes
+void futexWait(std::atomic<uint32_t> &word, uint32_t expected, int timeoutMs) {
+    timespec timeout = {timeoutMs / 1000, (long) (timeoutMs % 1000) * 1000000};
+    syscall(SYS_futex, (uint32_t *) &word, FUTEX_WAIT, expected, timeoutMs < 0 ? nullptr : &timeout, nullptr, 0);
+}
+
+void futexWake(std::atomic<uint32_t> &word) {
+    syscall(SYS_futex, (uint32_t *) &word, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+// Waits until ready() holds, spinning briefly before sleeping on `word`.
+// Returns false on timeout or when the ring is closed first.
+template<typename Ready>
+bool waitFor(std::atomic<uint32_t> &word, std::atomic<uint32_t> &waiting, std::atomic<uint32_t> &closed,
+             int timeoutMs, Ready ready) {
+    for (int i = 0; i < SPIN_ITERATIONS; i++) {
+        if (ready())
+            return true;
+        if (closed.load(std::memory_order_relaxed))
+            return ready();
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    }
+
+    uint64_t deadline = timeoutMs < 0 ? 0 : SharedFrameRing::nowNs() + (uint64_t) timeoutMs * 1000000;
+    while (true) {
+        uint32_t seen = word.load();
+        waiting.store(1);
+        // Re-check after publishing the flag: a commit in between either sees it or is seen here
+        if (ready() || closed.load()) {
+            waiting.store(0);
+            return ready();
+        }
+        // Capped so a close() racing with the sleep, or a peer that died, is noticed
+        int remainingMs = 100;
+        if (timeoutMs >= 0) {
+            uint64_t now = SharedFrameRing::nowNs();
+            if (now >= deadline) {
+                waiting.store(0);
+                return false;
+            }
+            remainingMs = std::min(remainingMs, (int) ((deadline - now + 999999) / 1000000));
+        }
+        futexWait(word, seen, remainingMs);
+        waiting.store(0);
+    }
+}
+
+}
+
+SharedFrameRing::~SharedFrameRing() {
+    if (base)
+        munmap(base, mappedBytes);
+    if (memFd >= 0)
+        ::close(memFd);
+}
+
+uint64_t SharedFrameRing::nowNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
+bool SharedFrameRing::create(const char *name, int slotCount, int width, int height) {
+    if (slotCount < 1 || slotCount > SHARED_RING_MAX_SLOTS || width <= 0 || height <= 0) {
+        std::cout << "ERROR::SHARED_RING:: Invalid ring geometry" << std::endl;
+        return false;
+    }
+    size_t frameBytes = (size_t) width * height * 4;
+    size_t slotBytes = alignUp(frameBytes, PAGE);
+    size_t dataOffset = alignUp(sizeof(Header), PAGE);
+    size_t total = dataOffset + slotBytes * slotCount;
+
+    int fd = memfd_create(name, MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0 || ftruncate(fd, (off_t) total) != 0) {
+        std::cout << "ERROR::SHARED_RING:: Failed to create memfd: " << std::strerror(errno) << std::endl;
+        if (fd >= 0)
+            ::close(fd);
+        return false;
+    }
+    // A peer that could shrink the file would turn our reads into SIGBUS
+    fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL);
+
+    if (!map(fd, total)) {
+        ::close(fd);
+        return false;
+    }
+    header->slotCount = (uint32_t) slotCount;
+    header->width = width;
+    header->height = height;
+    header->frameBytes = frameBytes;
+    header->slotBytes = slotBytes;
+    header->dataOffset = dataOffset;
+    header->magic = SHARED_RING_MAGIC; // memfd pages start zeroed, so the counters already are
+    loadGeometry();
+    return true;
+}
+
+bool SharedFrameRing::attach(int fd) {
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t) info.st_size < sizeof(Header) || !map(fd, (size_t) info.st_size)) {
+        std::cout << "ERROR::SHARED_RING:: Failed to map ring" << std::endl;
+        ::close(fd);
+        return false;
+    }
+    if (header->magic != SHARED_RING_MAGIC || header->slotCount < 1 || header->slotCount > SHARED_RING_MAX_SLOTS ||
+        header->frameBytes != (uint64_t) header->width * header->height * 4 || header->slotBytes < header->frameBytes ||
+        header->dataOffset + header->slotBytes * header->slotCount > mappedBytes) {
+        std::cout << "ERROR::SHARED_RING:: Not a frame ring" << std::endl;
+        munmap(base, mappedBytes);
+        base = nullptr;
+        header = nullptr;
+        ::close(fd);
+        memFd = -1;
+        return false;
+    }
+    loadGeometry();
+    return true;
+}
+
+void SharedFrameRing::loadGeometry() {
+    slotCount = header->slotCount;
+    slotBytes = (size_t) header->slotBytes;
+    dataOffset = (size_t) header->dataOffset;
+    frameSize = (size_t) header->frameBytes;
+    frameWidth = header->width;
+    frameHeight = header->height;
+}
+
+bool SharedFrameRing::map(int fd, size_t size) {
+    void *memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (memory == MAP_FAILED) {
+        std::cout << "ERROR::SHARED_RING:: mmap failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    base = (unsigned char *) memory;
+    header = (Header *) memory;
+    mappedBytes = size;
+    memFd = fd;
+    return true;
+}
+
+unsigned char *SharedFrameRing::acquireWrite(int timeoutMs) {
+    uint32_t head = header->head.load(std::memory_order_relaxed);
+    bool ready = waitFor(header->tail, header->producerWaiting, header->closed, timeoutMs, [&] {
+        return head - header->tail.load(std::memory_order_acquire) < slotCount;
+    });
+    if (!ready || header->closed.load())
+        return nullptr;
+    return slot(head);
+}
+
+void SharedFrameRing::commitWrite(const SharedFrameInfo &info) {
+    uint32_t head = header->head.load(std::memory_order_relaxed);
+    header->slots[head % slotCount] = info;
+    header->head.store(head + 1);
+    if (header->consumerWaiting.load())
+        futexWake(header->head);
+}
+
+const unsigned char *SharedFrameRing::acquireRead(SharedFrameInfo &info, int timeoutMs) {
+    uint32_t tail = header->tail.load(std::memory_order_relaxed);
+    bool ready = waitFor(header->head, header->consumerWaiting, header->closed, timeoutMs, [&] {
+        return header->head.load(std::memory_order_acquire) != tail;
+    });
+    if (!ready)
+        return nullptr;
+    info = header->slots[tail % slotCount];
+    return slot(tail);
+}
+
+void SharedFrameRing::releaseRead() {
+    header->tail.store(header->tail.load(std::memory_order_relaxed) + 1);
+    if (header->producerWaiting.load())
+        futexWake(header->tail);
+}
+
+void SharedFrameRing::close() {
+    if (!header)
+        return;
+    header->closed.store(1);
+    futexWake(header->head);
+    futexWake(header->tail);
+}
+
+bool SharedFrameRing::isClosed() const {
+    return !header || header->closed.load();
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Single-producer/single-consumer ring of fixed-size RGBA8 frames in a memfd that
+// two processes map. The producer writes a frame in place and commits it; the
+// consumer reads it in place and releases the slot, so frames are never copied
+// and nothing is allocated per frame. Waiting uses futexes on the shared head and
+// tail counters, after a short spin; the wake syscall is skipped when nobody sleeps.
+// Linux only.
+
+constexpr uint32_t SHARED_RING_MAGIC = 0x474e5246; // "FRNG"
+constexpr int SHARED_RING_MAX_SLOTS = 64;
+
+struct SharedFrameInfo {
+    uint64_t sequence = 0;
+    uint64_t timestampNs = 0; // CLOCK_MONOTONIC, comparable across processes
+};
+
+class SharedFrameRing {
+public:
+    SharedFrameRing() = default;
+    ~SharedFrameRing();
+    SharedFrameRing(const SharedFrameRing &) = delete;
+    SharedFrameRing &operator=(const SharedFrameRing &) = delete;
+
+    // New sealed memfd sized for slotCount frames of width x height.
+    bool create(const char *name, int slotCount, int width, int height);
+    // Maps a ring created by another process; takes ownership of fd.
+    bool attach(int fd);
+
+    // Producer side. acquireWrite returns the next free slot, or nullptr on
+    // timeout (timeoutMs < 0 waits forever) or once the ring is closed.
+    unsigned char *acquireWrite(int timeoutMs = -1);
+    void commitWrite(const SharedFrameInfo &info);
+
+    // Consumer side; frames come out in commit order.
+    const unsigned char *acquireRead(SharedFrameInfo &info, int timeoutMs = -1);
+    void releaseRead();
+
+    // Either side; wakes every waiter, later acquires fail once the ring is drained.
+    void close();
+    bool isClosed() const;
+
+    int fd() const { return memFd; }
+    int width() const { return frameWidth; }
+    int height() const { return frameHeight; }
+    size_t frameBytes() const { return frameSize; }
+
+    static uint64_t nowNs();
+
+private:
+    struct Header;
+    Header *header = nullptr;
+    unsigned char *base = nullptr;
+    size_t mappedBytes = 0;
+    int memFd = -1;
+
+    // Local copies of the geometry, so a misbehaving peer cannot move our accesses
+    uint32_t slotCount = 0;
+    size_t slotBytes = 0, dataOffset = 0, frameSize = 0;
+    int frameWidth = 0, frameHeight = 0;
+
+    bool map(int fd, size_t size);
+    void loadGeometry();
+    unsigned char *slot(uint32_t index) const { return base + dataOffset + (index % slotCount) * slotBytes; }
+};
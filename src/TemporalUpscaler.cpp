@@ -0,0 +1,113 @@
+#include "TemporalUpscaler.h"
+#include "GpuMemory.h"
+
+namespace {
+
+// Jitter sequence length: enough samples to cover each output pixel of a 2x upscale several times
+constexpr int JITTER_PHASES = 16;
+
+float halton(int index, int base) {
+    float result = 0.0f, fraction = 1.0f;
+    while (index > 0) {
+        fraction /= base;
+        result += fraction * (index % base);
+        index /= base;
+    }
+    return result;
+}
+
+}
+
+TemporalUpscaler::TemporalUpscaler()
+    : resolveShader("shaders/vertex.txt", "shaders/fragment_temporal.txt") {
+    quad.initQuad();
+    resolveShader.use();
+    resolveShader.setInt("uCurrent", 0);
+    resolveShader.setInt("uVelocity", 1);
+    resolveShader.setInt("uHistory", 2);
+    resolveShader.setInt("uDepth", 3);
+    glGenTextures(2, historyTexture);
+    glGenFramebuffers(2, historyFbo);
+}
+
+TemporalUpscaler::~TemporalUpscaler() {
+    gpuDeleteTextures(2, historyTexture);
+    glDeleteFramebuffers(2, historyFbo);
+    quad.releaseQuad();
+}
+
+void TemporalUpscaler::resize(int rw, int rh, int ow, int oh) {
+    renderWidth = rw;
+    renderHeight = rh;
+    if (ow != outputWidth || oh != outputHeight) {
+        outputWidth = ow;
+        outputHeight = oh;
+        for (int i = 0; i < 2; i++) {
+            glBindTexture(GL_TEXTURE_2D, historyTexture[i]);
+            gpuTexImage2D(historyTexture[i], GpuMemoryCategory::RenderTarget, "temporal history", 0, GL_RGBA16F, ow, oh,
+                          GL_RGBA, GL_FLOAT, nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glBindFramebuffer(GL_FRAMEBUFFER, historyFbo[i]);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, historyTexture[i], 0);
+            if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+                std::cout << "ERROR::FRAMEBUFFER:: History framebuffer is not complete!" << std::endl;
+        }
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    reset();
+}
+
+void TemporalUpscaler::reset() {
+    historyValid = false;
+}
+
+void TemporalUpscaler::nextFrame() {
+    frameIndex++;
+}
+
+glm::vec2 TemporalUpscaler::jitter() const {
+    // Halton starts at index 1; index 0 would be the unjittered centre every cycle
+    int index = frameIndex % JITTER_PHASES + 1;
+    return glm::vec2(halton(index, 2) - 0.5f, halton(index, 3) - 0.5f);
+}
+
+glm::mat4 TemporalUpscaler::jitterProjection(const glm::mat4 &projection) const {
+    glm::vec2 offset = jitter();
+    float ox = offset.x * 2.0f / renderWidth, oy = offset.y * 2.0f / renderHeight;
+    // Translating NDC by (ox, oy) adds ox * w and oy * w to clip x and y
+    glm::mat4 jittered = projection;
+    for (int column = 0; column < 4; column++) {
+        jittered[column][0] += ox * projection[column][3];
+        jittered[column][1] += oy * projection[column][3];
+    }
+    return jittered;
+}
+
+void TemporalUpscaler::resolve(unsigned int colorTexture, unsigned int velocityTexture, unsigned int depthTexture) {
+    int target = 1 - current;
+    glBindFramebuffer(GL_FRAMEBUFFER, historyFbo[target]);
+    glViewport(0, 0, outputWidth, outputHeight);
+    glDisable(GL_DEPTH_TEST);
+
+    resolveShader.use();
+    resolveShader.setVec2("uRenderSize", glm::vec2((float) renderWidth, (float) renderHeight));
+    resolveShader.setVec2("uJitter", jitter());
+    resolveShader.setFloat("uHistoryValid", historyValid ? 1.0f : 0.0f);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, colorTexture);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, velocityTexture);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, historyTexture[current]);
+    glActiveTexture(GL_TEXTURE3);
+    glBindTexture(GL_TEXTURE_2D, depthTexture);
+    quad.renderQuad();
+    glActiveTexture(GL_TEXTURE0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    current = target;
+    historyValid = true;
+}
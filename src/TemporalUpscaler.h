@@ -0,0 +1,45 @@
+#pragma once
+#include "config.h"
+#include "Renderer.h"
+
+// Temporal upscaling: the scene is rendered at low resolution with a different
+// sub-pixel jitter every frame (Halton 2,3) and each frame's samples are
+// accumulated into a full-resolution history. The history is reprojected with
+// per-pixel motion vectors and clamped to the current neighbourhood's colour
+// range, so moving or disoccluded pixels fall back to the new samples instead of
+// ghosting. Needs a current GL 3.3 context.
+class TemporalUpscaler {
+public:
+    TemporalUpscaler();
+    ~TemporalUpscaler();
+
+    void resize(int renderWidth, int renderHeight, int outputWidth, int outputHeight);
+    // Drops the history (camera cut, mode switch); the next frame starts from scratch.
+    void reset();
+
+    // Moves to the next jitter offset; call once per frame before rendering.
+    void nextFrame();
+    // This frame's offset in render pixels, within [-0.5, 0.5)
+    glm::vec2 jitter() const;
+    // projection with the jitter applied as a post-projection translation
+    glm::mat4 jitterProjection(const glm::mat4 &projection) const;
+
+    // Accumulates colorTexture (rendered with jitterProjection) into the history. The scene
+    // target's other attachments supply the motion in UV units (current - previous) and the
+    // depth used to take each pixel's motion from its closest neighbour, so silhouette edges
+    // move with the foreground.
+    void resolve(unsigned int colorTexture, unsigned int velocityTexture, unsigned int depthTexture);
+    unsigned int outputTexture() const { return historyTexture[current]; }
+    unsigned int outputFbo() const { return historyFbo[current]; }
+
+    int renderWidth = 0, renderHeight = 0, outputWidth = 0, outputHeight = 0;
+    int frameIndex = 0;
+
+private:
+    unsigned int historyTexture[2] = {}, historyFbo[2] = {};
+    int current = 0;
+    bool historyValid = false;
+
+    Renderer quad;
+    Shader resolveShader;
+};
@@ -1,6 +1,46 @@
 #include "TextureLoader.h"
+#include "GpuMemory.h"
+#include "Ktx2.h"
+#include <algorithm>
+#include <cstring>
+
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#endif
+
+static bool hasExtension(const char *name) {
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++) {
+        auto extension = (const char *) glGetStringi(GL_EXTENSIONS, i);
+        if (extension && std::strcmp(extension, name) == 0)
+            return true;
+    }
+    return false;
+}
+
+// Returns the GL internal format for a block format, or 0 when the driver can't sample it
+static GLenum compressedInternalFormat(BlockFormat format) {
+    static const bool s3tc = hasExtension("GL_EXT_texture_compression_s3tc");
+    static const bool bptc = hasExtension("GL_ARB_texture_compression_bptc");
+    switch (format) {
+        case BlockFormat::BC1: return s3tc ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : 0;
+        case BlockFormat::BC3: return s3tc ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : 0;
+        case BlockFormat::BC7: return bptc ? GL_COMPRESSED_RGBA_BPTC_UNORM : 0;
+    }
+    return 0;
+}
 
 unsigned int loadTexture(const std::string &path) {
+    if (path.ends_with(".ktx2"))
+        return loadTextureKTX2(path);
+
     int width, height, nrChannels;
     stbi_set_flip_vertically_on_load(true);
     unsigned char *data = stbi_load(path.c_str(), &width, &height, &nrChannels, 0);
@@ -14,8 +54,9 @@ unsigned int loadTexture(const std::string &path) {
     glGenTextures(1, &texture);
     glBindTexture(GL_TEXTURE_2D, texture);
 
-    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
+    gpuTexImage2D(texture, GpuMemoryCategory::Texture, "loaded texture", 0, format, width, height, format,
+                  GL_UNSIGNED_BYTE, data);
+    gpuGenerateMipmap(texture);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
@@ -25,3 +66,40 @@ unsigned int loadTexture(const std::string &path) {
     stbi_image_free(data);
     return texture;
 }
+
+unsigned int loadTextureKTX2(const std::string &path) {
+    Ktx2Texture ktx;
+    BlockFormat blockFormat;
+    if (!loadKtx2(path, ktx) || !blockFormatFromVk(ktx.vkFormat, blockFormat)) {
+        std::cout << "Failed to load texture: " << path << std::endl;
+        return 0;
+    }
+
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+
+    GLenum internalFormat = compressedInternalFormat(blockFormat);
+    int levels = (int) ktx.levels.size();
+    for (int level = 0; level < levels; level++) {
+        int w = std::max(1, ktx.width >> level), h = std::max(1, ktx.height >> level);
+        const std::vector<unsigned char> &blocks = ktx.levels[level];
+        if (internalFormat) {
+            gpuCompressedTexImage2D(texture, GpuMemoryCategory::Texture, "loaded texture (ktx2)", level, internalFormat,
+                                    w, h, (int) blocks.size(), blocks.data());
+        } else {
+            // Software GL without S3TC/BPTC: decode the blocks ourselves
+            std::vector<unsigned char> rgba = decompressImage(blocks.data(), w, h, blockFormat);
+            gpuTexImage2D(texture, GpuMemoryCategory::Texture, "loaded texture (ktx2)", level, GL_RGBA8, w, h, GL_RGBA,
+                          GL_UNSIGNED_BYTE, rgba.data());
+        }
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    return texture;
+}
@@ -2,3 +2,7 @@
 #include "config.h"
 
 unsigned int loadTexture(const std::string &path);
+
+// Uploads a BC1/BC3/BC7 KTX2 file as-is when the driver exposes S3TC/BPTC,
+// otherwise decodes it on the CPU and uploads RGBA8. Returns 0 on failure.
+unsigned int loadTextureKTX2(const std::string &path);
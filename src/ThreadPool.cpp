@@ -0,0 +1,83 @@
+#include "ThreadPool.h"
+#include "Tracing.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned int threadCount) {
+    threadCount = std::max(1u, threadCount);
+    for (unsigned int i = 0; i < threadCount; i++)
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    taskReady.notify_all();
+    for (auto &worker : workers)
+        worker.join();
+}
+
+void ThreadPool::enqueue(std::function<void()> task) {
+    {
+        std::lock_guard lock(mutex);
+        tasks.push_back(std::move(task));
+    }
+    taskReady.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock lock(mutex);
+    allIdle.wait(lock, [this] { return tasks.empty() && active == 0; });
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int begin, int end)> &fn) {
+    if (count <= 0)
+        return;
+
+    int chunks = std::min(count, (int) workers.size() * 4);
+    int chunkSize = (count + chunks - 1) / chunks;
+
+    // Track only our own chunks so concurrent users of the pool don't block each other
+    std::mutex doneMutex;
+    std::condition_variable doneCv;
+    int remaining = (count + chunkSize - 1) / chunkSize;
+
+    for (int begin = 0; begin < count; begin += chunkSize) {
+        int end = std::min(count, begin + chunkSize);
+        enqueue([&, begin, end] {
+            fn(begin, end);
+            std::lock_guard lock(doneMutex);
+            if (--remaining == 0)
+                doneCv.notify_one();
+        });
+    }
+
+    std::unique_lock lock(doneMutex);
+    doneCv.wait(lock, [&] { return remaining == 0; });
+}
+
+void ThreadPool::workerLoop() {
+    traceSetThreadName("pool worker");
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock lock(mutex);
+            taskReady.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (stopping && tasks.empty())
+                return;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+            active++;
+        }
+
+        task();
+
+        {
+            std::lock_guard lock(mutex);
+            active--;
+            if (tasks.empty() && active == 0)
+                allIdle.notify_all();
+        }
+    }
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned int threadCount = std::thread::hardware_concurrency());
+    ~ThreadPool();
+
+    void enqueue(std::function<void()> task);
+    void wait();
+
+    // Splits [0, count) into chunks and blocks until every chunk has run.
+    void parallelFor(int count, const std::function<void(int begin, int end)> &fn);
+
+    unsigned int size() const { return (unsigned int) workers.size(); }
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable taskReady, allIdle;
+    int active = 0;
+    bool stopping = false;
+};
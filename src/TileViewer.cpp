@@ -0,0 +1,400 @@
+#include "TileViewer.h"
+#include "GpuMemory.h"
+#include "Tracing.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// Uploads per frame: visible and fallback tiles first, then prefetched ones
+constexpr int UPLOAD_BUDGET = 8;
+constexpr int PREFETCH_UPLOAD_BUDGET = 4;
+// How far ahead of the pan direction to prefetch, in frames of motion and at most in tiles
+constexpr double PREFETCH_FRAMES = 30.0;
+constexpr int PREFETCH_MAX_TILES = 4;
+constexpr int MAX_LEVEL = 4;
+// Source pixels around a tile's footprint that go through the upscaler with it; more than
+// any registered kernel reaches (Lanczos-3: 3), so clamping at the window edge never shows
+constexpr int WINDOW_MARGIN = 4;
+// Upscaler indices fit in the key's top 4 bits
+constexpr size_t MAX_UPSCALERS = 16;
+
+uint64_t tileKey(int level, int upscaler, int tx, int ty) {
+    return (uint64_t) (level == 1 ? 0 : upscaler) << 60 | (uint64_t) level << 56 | (uint64_t) ty << 28 |
+           (uint64_t) tx;
+}
+
+struct TileCoord {
+    int level, tx, ty;
+    int upscaler;
+};
+
+TileCoord decodeKey(uint64_t key) {
+    return {(int) (key >> 56 & 0xF), (int) (key & 0xFFFFFFF), (int) (key >> 28 & 0xFFFFFFF), (int) (key >> 60)};
+}
+
+}
+
+TileViewer::TileViewer(unsigned int workerCount, size_t cpuCacheBytes, size_t gpuCacheBytes)
+    : upscalerNames(::upscalerNames(UpscalerBackend::Cpu)), cpuCache(0), gpuCache(0), cpuCacheBytes(cpuCacheBytes),
+      gpuCacheBytes(gpuCacheBytes), tileShader("shaders/tile_vertex.txt", "shaders/fragment.txt") {
+    upscalerNames.resize(std::min(upscalerNames.size(), MAX_UPSCALERS));
+    quad.initQuad();
+    tileShader.use();
+    tileShader.setInt("uTexture", 0);
+    for (unsigned int i = 0; i < std::max(1u, workerCount); i++)
+        workers.emplace_back(&TileViewer::workerLoop, this);
+}
+
+TileViewer::~TileViewer() {
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread &worker : workers)
+        worker.join();
+    gpuCache.clear(freeTextures);
+    if (!freeTextures.empty())
+        gpuDeleteTextures((int) freeTextures.size(), freeTextures.data());
+    quad.releaseQuad();
+}
+
+bool TileViewer::open(const std::string &path) {
+    if (isOpen() || !image.open(path))
+        return false;
+    // Capacities were given in bytes; the caches count tiles
+    cpuCache.capacity = std::max<size_t>(1, cpuCacheBytes / image.tileBytes);
+    gpuCache.capacity = std::max<size_t>(1, gpuCacheBytes / image.tileBytes);
+    centerX = lastCenterX = image.width / 2.0;
+    centerY = lastCenterY = image.height / 2.0;
+    return true;
+}
+
+size_t TileViewer::cpuTiles() const {
+    std::lock_guard lock(mutex);
+    return cpuCache.size();
+}
+
+void TileViewer::pan(double dx, double dy) {
+    centerX = std::clamp(centerX - dx / zoom, 0.0, (double) image.width);
+    centerY = std::clamp(centerY - dy / zoom, 0.0, (double) image.height);
+}
+
+void TileViewer::zoomAt(double factor, double screenX, double screenY, int screenWidth, int screenHeight) {
+    // Keep the source pixel under the cursor in place
+    double px = centerX + (screenX - screenWidth / 2.0) / zoom, py = centerY + (screenY - screenHeight / 2.0) / zoom;
+    zoom = std::clamp(zoom * factor, 0.25, 16.0);
+    centerX = std::clamp(px - (screenX - screenWidth / 2.0) / zoom, 0.0, (double) image.width);
+    centerY = std::clamp(py - (screenY - screenHeight / 2.0) / zoom, 0.0, (double) image.height);
+}
+
+void TileViewer::workerLoop() {
+    traceSetThreadName("tile worker");
+    WorkerState state;
+    state.upscalers.resize(upscalerNames.size());
+    while (true) {
+        uint64_t key;
+        {
+            std::unique_lock lock(mutex);
+            wake.wait(lock, [this] { return stopping || nextWanted < wanted.size(); });
+            if (stopping)
+                return;
+            key = wanted[nextWanted++];
+            if (cpuCache.contains(key) || inFlight.count(key))
+                continue;
+            inFlight.insert(key);
+        }
+        produce(key, state);
+    }
+}
+
+// The registry's upscalers work on whole images, so the source window under the tile (plus
+// a margin) is upscaled by exactly tileLevel. That samples the same source positions as
+// upscaling the whole image would, with the same polyphase phases, so the tile matches it.
+void TileViewer::upscaleTile(WorkerState &state, int upscalerIndex, float sharpness, int tileLevel,
+                             const MutableImageView &dst, int x0, int y0, int x1, int y1) {
+    int sx0 = std::max(0, x0 / tileLevel - WINDOW_MARGIN), sy0 = std::max(0, y0 / tileLevel - WINDOW_MARGIN);
+    int sx1 = std::min(image.width, (x1 + tileLevel - 1) / tileLevel + WINDOW_MARGIN);
+    int sy1 = std::min(image.height, (y1 + tileLevel - 1) / tileLevel + WINDOW_MARGIN);
+    int width = sx1 - sx0, height = sy1 - sy0;
+    state.window.resize((size_t) width * height * 4);
+    readTileWindow(image, sx0, sy0, sx1, sy1, state.window.data());
+
+    std::unique_ptr<IUpscaler> &upscaler = state.upscalers[upscalerIndex];
+    if (!upscaler)
+        upscaler = createUpscaler(upscalerNames[upscalerIndex], UpscalerBackend::Cpu);
+    if (width != upscaler->srcWidth || height != upscaler->srcHeight)
+        upscaler->resize(width, height, width * tileLevel, height * tileLevel);
+    if (state.upscaled.width != upscaler->dstWidth || state.upscaled.height != upscaler->dstHeight)
+        state.upscaled = Image(upscaler->dstWidth, upscaler->dstHeight, 4);
+    upscaler->sharpness = sharpness;
+    upscaler->process(ImageView(state.window.data(), width, height, (size_t) width * 4, 4), state.upscaled);
+
+    MutableImageView upscaled(state.upscaled);
+    upscaled.originX = sx0 * tileLevel;
+    upscaled.originY = sy0 * tileLevel;
+    for (int y = y0; y < y1; y++)
+        std::memcpy(dst.pixel(x0, y), upscaled.pixel(x0, y), (size_t) (x1 - x0) * 4);
+}
+
+void TileViewer::produce(uint64_t key, WorkerState &state) {
+    TRACE_ZONE("produce tile");
+    TileCoord coord = decodeKey(key);
+    TileBuffer buffer;
+    float sharpness;
+    uint64_t startGeneration;
+    {
+        std::lock_guard lock(mutex);
+        sharpness = currentSharpness;
+        startGeneration = generation;
+        if (!spareBuffers.empty()) {
+            buffer = std::move(spareBuffers.back());
+            spareBuffers.pop_back();
+        }
+    }
+    if (!buffer)
+        buffer = std::make_shared<std::vector<unsigned char>>(image.tileBytes);
+
+    int tile = image.tileSize;
+    int outWidth = image.width * coord.level, outHeight = image.height * coord.level;
+    int x0 = coord.tx * tile, y0 = coord.ty * tile;
+    int w = std::min(tile, outWidth - x0), h = std::min(tile, outHeight - y0);
+    if (coord.level == 1) {
+        // Copying here rather than uploading from the mapping keeps page faults off the render thread
+        std::memcpy(buffer->data(), image.tile(coord.tx, coord.ty), image.tileBytes);
+    } else {
+        auto start = std::chrono::steady_clock::now();
+        MutableImageView view(buffer->data(), outWidth, outHeight, (size_t) tile * 4, 4);
+        view.originX = x0;
+        view.originY = y0;
+        upscaleTile(state, coord.upscaler, sharpness, coord.level, view, x0, y0, x0 + w, y0 + h);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        // Pool workers finish tiles concurrently, so this has to be one read-modify-write
+        upscaleMs.fetch_add(ms, std::memory_order_relaxed);
+        tilesUpscaled++;
+    }
+
+    // Repeat the last column and row into the padding so edge tiles filter cleanly
+    unsigned char *pixels = buffer->data();
+    if (w < tile)
+        for (int y = 0; y < h; y++)
+            std::memcpy(pixels + ((size_t) y * tile + w) * 4, pixels + ((size_t) y * tile + w - 1) * 4, 4);
+    if (h < tile)
+        std::memcpy(pixels + (size_t) h * tile * 4, pixels + (size_t) (h - 1) * tile * 4, (size_t) tile * 4);
+
+    std::lock_guard lock(mutex);
+    inFlight.erase(key);
+    if (generation != startGeneration)
+        return;
+    std::vector<TileBuffer> evicted;
+    cpuCache.insert(key, std::move(buffer), evicted);
+    for (TileBuffer &old : evicted)
+        if (old.use_count() == 1 && spareBuffers.size() < workers.size() * 2)
+            spareBuffers.push_back(std::move(old));
+}
+
+unsigned int TileViewer::uploadTile(uint64_t key, const TileBuffer &pixels) {
+    unsigned int texture;
+    if (!freeTextures.empty()) {
+        texture = freeTextures.back();
+        freeTextures.pop_back();
+        glBindTexture(GL_TEXTURE_2D, texture);
+    } else {
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        gpuTexImage2D(texture, GpuMemoryCategory::Texture, "tile cache", 0, GL_RGBA8, image.tileSize, image.tileSize,
+                      GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, image.tileSize, image.tileSize, GL_RGBA, GL_UNSIGNED_BYTE, pixels->data());
+    gpuCache.insert(key, texture, freeTextures);
+    return texture;
+}
+
+void TileViewer::drawTile(unsigned int texture, int tileLevel, int tx, int ty, int screenWidth, int screenHeight) {
+    int tile = image.tileSize;
+    int w = std::min(tile, image.width * tileLevel - tx * tile), h = std::min(tile, image.height * tileLevel - ty * tile);
+    double scale = zoom / tileLevel;
+    double left = (tx * tile - centerX * tileLevel) * scale + screenWidth / 2.0;
+    double top = (ty * tile - centerY * tileLevel) * scale + screenHeight / 2.0;
+    double right = left + w * scale, bottom = top + h * scale;
+
+    tileShader.setVec4("uRect", glm::vec4((float) (left / screenWidth * 2.0 - 1.0), (float) (1.0 - bottom / screenHeight * 2.0),
+                                          (float) (right / screenWidth * 2.0 - 1.0), (float) (1.0 - top / screenHeight * 2.0)));
+    tileShader.setVec4("uTexRect", glm::vec4(0.0f, (float) h / tile, (float) w / tile, 0.0f));
+    glBindTexture(GL_TEXTURE_2D, texture);
+    quad.renderQuad();
+}
+
+void TileViewer::draw(int screenWidth, int screenHeight, const std::string &upscaler, float sharpness, bool upscale) {
+    auto start = std::chrono::steady_clock::now();
+    visibleTiles = gpuHits = uploads = prefetchUploads = fallbackTiles = 0;
+    if (!isOpen())
+        return;
+    auto found = std::find(upscalerNames.begin(), upscalerNames.end(), upscaler);
+    if (found == upscalerNames.end())
+        found = std::find(upscalerNames.begin(), upscalerNames.end(), "easu");
+    int upscalerIndex = (int) (found - upscalerNames.begin());
+
+    if (sharpness != currentSharpness) {
+        // Upscaled tiles depend on the sharpness; source tiles could be kept but this is rare
+        std::lock_guard lock(mutex);
+        std::vector<TileBuffer> evicted;
+        cpuCache.clear(evicted);
+        gpuCache.clear(freeTextures);
+        currentSharpness = sharpness;
+        generation++;
+    }
+
+    level = upscale ? std::clamp((int) std::ceil(zoom - 1e-3), 1, MAX_LEVEL) : 1;
+    int tile = image.tileSize;
+    int levelTilesX = (image.width * level + tile - 1) / tile, levelTilesY = (image.height * level + tile - 1) / tile;
+
+    velocityX = velocityX * 0.8 + (centerX - lastCenterX) * 0.2;
+    velocityY = velocityY * 0.8 + (centerY - lastCenterY) * 0.2;
+    lastCenterX = centerX;
+    lastCenterY = centerY;
+
+    // Output tiles under the viewport at this level, nearest to the centre first
+    double halfWidth = screenWidth / 2.0 / zoom, halfHeight = screenHeight / 2.0 / zoom;
+    int tx0 = std::max(0, (int) std::floor((centerX - halfWidth) * level / tile));
+    int ty0 = std::max(0, (int) std::floor((centerY - halfHeight) * level / tile));
+    int tx1 = std::min(levelTilesX - 1, (int) std::floor((centerX + halfWidth) * level / tile));
+    int ty1 = std::min(levelTilesY - 1, (int) std::floor((centerY + halfHeight) * level / tile));
+    int currentLevel = level;
+    auto distanceTo = [tile, currentLevel](double cx, double cy) {
+        return [=](const TileCoord &a, const TileCoord &b) {
+            auto d = [&](const TileCoord &t) {
+                double dx = (t.tx + 0.5) * tile - cx * currentLevel, dy = (t.ty + 0.5) * tile - cy * currentLevel;
+                return dx * dx + dy * dy;
+            };
+            return d(a) < d(b);
+        };
+    };
+    std::vector<TileCoord> visible;
+    for (int ty = ty0; ty <= ty1; ty++)
+        for (int tx = tx0; tx <= tx1; tx++)
+            visible.push_back({level, tx, ty, upscalerIndex});
+    std::sort(visible.begin(), visible.end(), distanceTo(centerX, centerY));
+    visibleTiles = (int) visible.size();
+
+    // Prefetch ring: one tile around the viewport, stretched along the recent pan direction
+    int aheadX = std::clamp((int) std::round(velocityX * PREFETCH_FRAMES * level / tile), -PREFETCH_MAX_TILES, PREFETCH_MAX_TILES);
+    int aheadY = std::clamp((int) std::round(velocityY * PREFETCH_FRAMES * level / tile), -PREFETCH_MAX_TILES, PREFETCH_MAX_TILES);
+    std::vector<TileCoord> prefetch;
+    for (int ty = std::max(0, ty0 - 1 + std::min(0, aheadY)); ty <= std::min(levelTilesY - 1, ty1 + 1 + std::max(0, aheadY)); ty++)
+        for (int tx = std::max(0, tx0 - 1 + std::min(0, aheadX)); tx <= std::min(levelTilesX - 1, tx1 + 1 + std::max(0, aheadX)); tx++)
+            if (tx < tx0 || tx > tx1 || ty < ty0 || ty > ty1)
+                prefetch.push_back({level, tx, ty, upscalerIndex});
+    std::sort(prefetch.begin(), prefetch.end(),
+              distanceTo(centerX + velocityX * PREFETCH_FRAMES, centerY + velocityY * PREFETCH_FRAMES));
+
+    // Keep every tile drawn this frame resident while uploading
+    gpuCache.capacity = std::max(gpuCacheBytes / image.tileBytes,
+                                 visible.size() * 2 + UPLOAD_BUDGET + PREFETCH_UPLOAD_BUDGET);
+
+    struct Drawn {
+        unsigned int texture;
+        TileCoord coord;
+    };
+    std::vector<Drawn> drawn, fallback;
+    std::vector<TileCoord> missing;
+    for (const TileCoord &t : visible) {
+        if (unsigned int *texture = gpuCache.find(tileKey(t.level, upscalerIndex, t.tx, t.ty))) {
+            drawn.push_back({*texture, t});
+            gpuHits++;
+        } else {
+            missing.push_back(t);
+        }
+    }
+
+    std::vector<std::pair<uint64_t, TileBuffer>> toUpload, toPrefetch;
+    std::vector<uint64_t> queue;
+    std::vector<TileCoord> sources;
+    {
+        std::lock_guard lock(mutex);
+        std::vector<uint64_t> fallbackKeys;
+        for (const TileCoord &t : missing) {
+            uint64_t key = tileKey(t.level, upscalerIndex, t.tx, t.ty);
+            if (TileBuffer *pixels = cpuCache.find(key); pixels && (int) toUpload.size() < UPLOAD_BUDGET) {
+                toUpload.emplace_back(key, *pixels);
+                continue;
+            }
+            if (!cpuCache.contains(key))
+                queue.push_back(key);
+            fallbackTiles++;
+            if (level == 1)
+                continue;
+            // Source tiles under the missing output tile stand in for it
+            int sx0 = t.tx * tile / level / tile, sx1 = std::min(image.tilesX - 1, ((t.tx + 1) * tile - 1) / level / tile);
+            int sy0 = t.ty * tile / level / tile, sy1 = std::min(image.tilesY - 1, ((t.ty + 1) * tile - 1) / level / tile);
+            for (int sy = sy0; sy <= sy1; sy++) {
+                for (int sx = sx0; sx <= sx1; sx++) {
+                    uint64_t sourceKey = tileKey(1, upscalerIndex, sx, sy);
+                    if (std::find(fallbackKeys.begin(), fallbackKeys.end(), sourceKey) != fallbackKeys.end())
+                        continue;
+                    fallbackKeys.push_back(sourceKey);
+                    sources.push_back({1, sx, sy, upscalerIndex});
+                }
+            }
+        }
+
+        // Stand-ins go ahead of the upscaled tiles in the queue: they are only copies
+        std::vector<uint64_t> sourceWanted;
+        for (const TileCoord &s : sources) {
+            uint64_t key = tileKey(1, upscalerIndex, s.tx, s.ty);
+            if (gpuCache.contains(key))
+                continue;
+            if (TileBuffer *pixels = cpuCache.find(key); pixels && (int) toUpload.size() < UPLOAD_BUDGET)
+                toUpload.emplace_back(key, *pixels);
+            else if (!pixels)
+                sourceWanted.push_back(key);
+        }
+        queue.insert(queue.begin(), sourceWanted.begin(), sourceWanted.end());
+
+        for (const TileCoord &t : prefetch) {
+            uint64_t key = tileKey(t.level, upscalerIndex, t.tx, t.ty);
+            if (gpuCache.contains(key))
+                continue;
+            if (!cpuCache.contains(key))
+                queue.push_back(key);
+            else if ((int) toPrefetch.size() < PREFETCH_UPLOAD_BUDGET)
+                toPrefetch.emplace_back(key, *cpuCache.find(key));
+        }
+
+        wanted = std::move(queue);
+        nextWanted = 0;
+    }
+    wake.notify_all();
+
+    for (auto &[key, pixels] : toUpload) {
+        TileCoord coord = decodeKey(key);
+        unsigned int texture = uploadTile(key, pixels);
+        if (coord.level == level)
+            drawn.push_back({texture, coord});
+        uploads++;
+    }
+    for (auto &[key, pixels] : toPrefetch) {
+        uploadTile(key, pixels);
+        prefetchUploads++;
+    }
+    for (const TileCoord &s : sources)
+        if (unsigned int *texture = gpuCache.find(tileKey(1, upscalerIndex, s.tx, s.ty)))
+            fallback.push_back({*texture, s});
+
+    tileShader.use();
+    glActiveTexture(GL_TEXTURE0);
+    if (level > 1)
+        for (const Drawn &d : fallback)
+            drawTile(d.texture, 1, d.coord.tx, d.coord.ty, screenWidth, screenHeight);
+    for (const Drawn &d : drawn)
+        drawTile(d.texture, d.coord.level, d.coord.tx, d.coord.ty, screenWidth, screenHeight);
+
+    drawMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <glad/glad.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include "LruCache.h"
+#include "Renderer.h"
+#include "Shader.h"
+#include "TiledImage.h"
+#include "Upscaler.h"
+
+// Pans and zooms a huge tiled image, upscaling lazily: only the output tiles under
+// the viewport at the current zoom level are produced, by background threads, and
+// kept in two LRU tiers bounded in bytes, RGBA buffers in RAM and textures on the
+// GPU. Tiles that are not ready yet are drawn from the (cheap) source tiles
+// underneath, so the frame never waits on the upscaler. Tiles ahead of the pan
+// direction are prefetched into both tiers. Tiles are upscaled by any CPU upscaler from
+// the registry (see Upscaler.h). Needs a current GL 3.3 context.
+class TileViewer {
+public:
+    TileViewer(unsigned int workerCount, size_t cpuCacheBytes = 512u << 20, size_t gpuCacheBytes = 128u << 20);
+    ~TileViewer();
+
+    // Maps the image; once per viewer, before the first draw().
+    bool open(const std::string &path);
+    bool isOpen() const { return image.tilesX > 0; }
+
+    // dx, dy in screen pixels; zoom is screen pixels per source pixel.
+    void pan(double dx, double dy);
+    void zoomAt(double factor, double screenX, double screenY, int screenWidth, int screenHeight);
+
+    // Draws into the bound framebuffer's (0, 0, screenWidth, screenHeight) viewport, with
+    // tiles from the named CPU upscaler (easu for a name the registry doesn't have).
+    // upscale = false shows the source tiles magnified by the GPU sampler only.
+    void draw(int screenWidth, int screenHeight, const std::string &upscaler, float sharpness, bool upscale);
+
+    double centerX = 0.0, centerY = 0.0, zoom = 2.0;
+    int level = 1;
+
+    // Per-frame counters (reset by draw) and running totals
+    int visibleTiles = 0, gpuHits = 0, uploads = 0, prefetchUploads = 0, fallbackTiles = 0;
+    std::atomic<uint64_t> tilesUpscaled = 0;
+    std::atomic<double> upscaleMs = 0.0;
+    double drawMs = 0.0;
+    size_t cpuTiles() const;
+    size_t gpuTiles() const { return gpuCache.size(); }
+    size_t tileBytes() const { return image.tileBytes; }
+
+private:
+    using TileBuffer = std::shared_ptr<std::vector<unsigned char>>;
+
+    // A worker's own upscaler instances, by index into upscalerNames, and its scratch images
+    struct WorkerState {
+        std::vector<std::unique_ptr<IUpscaler>> upscalers;
+        std::vector<unsigned char> window;
+        Image upscaled;
+    };
+
+    void workerLoop();
+    void produce(uint64_t key, WorkerState &state);
+    void upscaleTile(WorkerState &state, int upscalerIndex, float sharpness, int tileLevel, const MutableImageView &dst,
+                     int x0, int y0, int x1, int y1);
+    unsigned int uploadTile(uint64_t key, const TileBuffer &pixels);
+    void drawTile(unsigned int texture, int level, int tx, int ty, int screenWidth, int screenHeight);
+
+    TiledImage image;
+    // The CPU registry at construction; tile keys hold the index
+    std::vector<std::string> upscalerNames;
+    std::vector<std::thread> workers;
+
+    // Shared with the workers: the RAM tier, the ordered wish list for this frame and
+    // the tiles being produced
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    LruCache<TileBuffer> cpuCache;
+    std::vector<uint64_t> wanted;
+    size_t nextWanted = 0;
+    std::unordered_set<uint64_t> inFlight;
+    std::vector<TileBuffer> spareBuffers;
+    float currentSharpness = -1.0f;
+    uint64_t generation = 0;
+    bool stopping = false;
+
+    // Main thread only: the GPU tier and recycled textures
+    LruCache<unsigned int> gpuCache;
+    std::vector<unsigned int> freeTextures;
+    size_t cpuCacheBytes, gpuCacheBytes;
+
+    double velocityX = 0.0, velocityY = 0.0, lastCenterX = 0.0, lastCenterY = 0.0;
+    Renderer quad;
+    Shader tileShader;
+};
@@ -0,0 +1,247 @@
+#include "TiledImage.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+TiledImage::~TiledImage() {
+    close();
+}
+
+bool TiledImage::create(const std::string &path, int w, int h, int tile) {
+    close();
+    if (w <= 0 || h <= 0 || tile <= 0 || tile % 16 != 0 || tile > (int) TILED_IMAGE_MAX_TILE) {
+        std::cout << "ERROR::TILED_IMAGE:: Invalid size for " << path << std::endl;
+        return false;
+    }
+    width = w;
+    height = h;
+    tileSize = tile;
+    tilesX = (w + tile - 1) / tile;
+    tilesY = (h + tile - 1) / tile;
+    tileBytes = (size_t) tile * tile * 4;
+    size_t total = TILED_IMAGE_HEADER_BYTES + tileBytes * tilesX * tilesY;
+
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0 || ftruncate(fd, (off_t) total) != 0) {
+        std::cout << "ERROR::TILED_IMAGE:: Failed to create " << path << ": " << std::strerror(errno) << std::endl;
+        close();
+        return false;
+    }
+    if (!map(total, true))
+        return false;
+
+    TiledImageHeader header = {};
+    std::memcpy(header.magic, TILED_IMAGE_MAGIC, sizeof(header.magic));
+    header.version = TILED_IMAGE_VERSION;
+    header.headerBytes = TILED_IMAGE_HEADER_BYTES;
+    header.width = (uint32_t) w;
+    header.height = (uint32_t) h;
+    header.tileSize = (uint32_t) tile;
+    header.channels = 4;
+    header.tilesX = (uint32_t) tilesX;
+    header.tilesY = (uint32_t) tilesY;
+    header.tileBytes = tileBytes;
+    std::memcpy(mapping, &header, sizeof(header));
+    return true;
+}
+
+bool TiledImage::open(const std::string &path, bool write) {
+    close();
+    fd = ::open(path.c_str(), (write ? O_RDWR : O_RDONLY) | O_CLOEXEC);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0 || (size_t) info.st_size < TILED_IMAGE_HEADER_BYTES) {
+        std::cout << "ERROR::TILED_IMAGE:: Failed to open " << path << std::endl;
+        close();
+        return false;
+    }
+
+    // Every field is untrusted: bound the tile size and dimensions first, so that the
+    // arithmetic below fits in 64 bits, and divide instead of multiplying against the file size
+    TiledImageHeader header;
+    if (pread(fd, &header, sizeof(header), 0) != (ssize_t) sizeof(header) ||
+        std::memcmp(header.magic, TILED_IMAGE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != TILED_IMAGE_VERSION || header.headerBytes != TILED_IMAGE_HEADER_BYTES ||
+        header.channels != 4 || header.tileSize == 0 || header.tileSize % 16 != 0 ||
+        header.tileSize > TILED_IMAGE_MAX_TILE || header.width == 0 || header.height == 0 ||
+        header.width > INT_MAX || header.height > INT_MAX ||
+        header.tilesX != ((uint64_t) header.width + header.tileSize - 1) / header.tileSize ||
+        header.tilesY != ((uint64_t) header.height + header.tileSize - 1) / header.tileSize ||
+        header.tileBytes != (uint64_t) header.tileSize * header.tileSize * 4 ||
+        (uint64_t) header.tilesX * header.tilesY > ((uint64_t) info.st_size - TILED_IMAGE_HEADER_BYTES) / header.tileBytes) {
+        std::cout << "ERROR::TILED_IMAGE:: Not a tiled image: " << path << std::endl;
+        close();
+        return false;
+    }
+    width = (int) header.width;
+    height = (int) header.height;
+    tileSize = (int) header.tileSize;
+    tilesX = (int) header.tilesX;
+    tilesY = (int) header.tilesY;
+    tileBytes = (size_t) header.tileBytes;
+
+    if (!map((size_t) info.st_size, write))
+        return false;
+    madvise(mapping, mappedBytes, MADV_RANDOM);
+    return true;
+}
+
+bool TiledImage::map(size_t size, bool write) {
+    void *memory = mmap(nullptr, size, write ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+    if (memory == MAP_FAILED) {
+        std::cout << "ERROR::TILED_IMAGE:: mmap failed: " << std::strerror(errno) << std::endl;
+        close();
+        return false;
+    }
+    mapping = (unsigned char *) memory;
+    mappedBytes = size;
+    writable = write;
+    return true;
+}
+
+bool TiledImage::flush() {
+    return !mapping || !writable || msync(mapping, mappedBytes, MS_SYNC) == 0;
+}
+
+void TiledImage::close() {
+    if (mapping) {
+        flush();
+        munmap(mapping, mappedBytes);
+    }
+    if (fd >= 0)
+        ::close(fd);
+    mapping = nullptr;
+    mappedBytes = 0;
+    fd = -1;
+    writable = false;
+}
+
+unsigned char *TiledImage::tile(int tx, int ty) const {
+    return mapping + TILED_IMAGE_HEADER_BYTES + ((size_t) ty * tilesX + tx) * tileBytes;
+}
+
+int TiledImage::tileWidth(int tx) const {
+    return std::min(tileSize, width - tx * tileSize);
+}
+
+int TiledImage::tileHeight(int ty) const {
+    return std::min(tileSize, height - ty * tileSize);
+}
+
+ImageView TiledImage::tileView(int tx, int ty) const {
+    ImageView view(tile(tx, ty), width, height, (size_t) tileSize * 4, 4);
+    view.originX = tx * tileSize;
+    view.originY = ty * tileSize;
+    return view;
+}
+
+MutableImageView TiledImage::mutableTileView(int tx, int ty) const {
+    MutableImageView view(tile(tx, ty), width, height, (size_t) tileSize * 4, 4);
+    view.originX = tx * tileSize;
+    view.originY = ty * tileSize;
+    return view;
+}
+
+bool imageToTiles(const Image &image, TiledImage &tiles) {
+    if (image.channels != 4 || image.width != tiles.width || image.height != tiles.height)
+        return false;
+    for (int ty = 0; ty < tiles.tilesY; ty++) {
+        for (int tx = 0; tx < tiles.tilesX; tx++) {
+            MutableImageView view = tiles.mutableTileView(tx, ty);
+            for (int y = 0; y < tiles.tileHeight(ty); y++)
+                std::memcpy(view.pixel(view.originX, view.originY + y), image.row(view.originY + y) + view.originX * 4,
+                            (size_t) tiles.tileWidth(tx) * 4);
+        }
+    }
+    return true;
+}
+
+Image tilesToImage(const TiledImage &tiles) {
+    Image image(tiles.width, tiles.height, 4);
+    for (int ty = 0; ty < tiles.tilesY; ty++) {
+        for (int tx = 0; tx < tiles.tilesX; tx++) {
+            ImageView view = tiles.tileView(tx, ty);
+            for (int y = 0; y < tiles.tileHeight(ty); y++)
+                std::memcpy(image.row(view.originY + y) + view.originX * 4, view.pixel(view.originX, view.originY + y),
+                            (size_t) tiles.tileWidth(tx) * 4);
+        }
+    }
+    return image;
+}
+
+void readTileWindow(const TiledImage &src, int x0, int y0, int x1, int y1, unsigned char *out) {
+    int width = x1 - x0;
+    for (int ty = y0 / src.tileSize; ty <= (y1 - 1) / src.tileSize; ty++) {
+        for (int tx = x0 / src.tileSize; tx <= (x1 - 1) / src.tileSize; tx++) {
+            ImageView t = src.tileView(tx, ty);
+            int cx0 = std::max(x0, t.originX), cx1 = std::min(x1, t.originX + src.tileWidth(tx));
+            int cy0 = std::max(y0, t.originY), cy1 = std::min(y1, t.originY + src.tileHeight(ty));
+            for (int y = cy0; y < cy1; y++)
+                std::memcpy(out + ((size_t) (y - y0) * width + (cx0 - x0)) * 4, t.pixel(cx0, y), (size_t) (cx1 - cx0) * 4);
+        }
+    }
+}
+
+void upscaleTileRect(const TiledImage &src, const MutableImageView &dst, int x0, int y0, int x1, int y1,
+                     UpscaleMode mode, float sharpness) {
+    int sx0, sy0, sx1, sy1;
+    upscaleFootprint(src.width, src.height, dst.width, dst.height, x0, y0, x1, y1, sx0, sy0, sx1, sy1);
+    int stx0 = sx0 / src.tileSize, sty0 = sy0 / src.tileSize;
+    int stx1 = (sx1 - 1) / src.tileSize, sty1 = (sy1 - 1) / src.tileSize;
+
+    ImageView window;
+    thread_local std::vector<unsigned char> gather;
+    if (stx0 == stx1 && sty0 == sty1) {
+        window = src.tileView(stx0, sty0);
+    } else {
+        // Footprint straddles tiles: copy just that window out of each tile it touches
+        int gw = sx1 - sx0, gh = sy1 - sy0;
+        gather.resize((size_t) gw * gh * 4);
+        readTileWindow(src, sx0, sy0, sx1, sy1, gather.data());
+        window = ImageView(gather.data(), src.width, src.height, (size_t) gw * 4, 4);
+        window.originX = sx0;
+        window.originY = sy0;
+    }
+    upscaleRect(window, dst, x0, y0, x1, y1, mode, sharpness);
+}
+
+void upscaleTiled(const TiledImage &src, TiledImage &dst, UpscaleMode mode, float sharpness, ThreadPool *pool,
+                  int x0, int y0, int x1, int y1) {
+    if (x1 < 0) x1 = dst.width;
+    if (y1 < 0) y1 = dst.height;
+    x0 = std::clamp(x0, 0, dst.width);
+    y0 = std::clamp(y0, 0, dst.height);
+    x1 = std::clamp(x1, x0, dst.width);
+    y1 = std::clamp(y1, y0, dst.height);
+    if (x0 == x1 || y0 == y1)
+        return;
+
+    int tx0 = x0 / dst.tileSize, ty0 = y0 / dst.tileSize;
+    int tx1 = (x1 - 1) / dst.tileSize + 1, ty1 = (y1 - 1) / dst.tileSize + 1;
+    int columns = tx1 - tx0;
+
+    auto runTile = [&](int index) {
+        int tx = tx0 + index % columns, ty = ty0 + index / columns;
+        int ox0 = std::max(x0, tx * dst.tileSize), oy0 = std::max(y0, ty * dst.tileSize);
+        int ox1 = std::min(x1, tx * dst.tileSize + dst.tileWidth(tx)), oy1 = std::min(y1, ty * dst.tileSize + dst.tileHeight(ty));
+        upscaleTileRect(src, dst.mutableTileView(tx, ty), ox0, oy0, ox1, oy1, mode, sharpness);
+    };
+
+    int count = columns * (ty1 - ty0);
+    if (!pool) {
+        for (int i = 0; i < count; i++)
+            runTile(i);
+        return;
+    }
+    pool->parallelFor(count, [&](int begin, int end) {
+        for (int i = begin; i < end; i++)
+            runTile(i);
+    });
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "CpuUpscaler.h"
+
+class ThreadPool;
+
+// Raw tiled RGBA8 container meant to be mmapped. A 4 KiB header is followed by
+// tilesX * tilesY tiles of tileSize x tileSize pixels in row-major tile order;
+// edge tiles are stored full size with the padding left unspecified. Only the
+// tiles that are touched get paged in, so regions of huge images can be read or
+// written without decoding the whole file. POSIX only.
+constexpr char TILED_IMAGE_MAGIC[8] = {'U', 'P', 'T', 'I', 'L', 'E', 'S', '\0'};
+constexpr uint32_t TILED_IMAGE_VERSION = 1;
+constexpr uint32_t TILED_IMAGE_HEADER_BYTES = 4096;
+// Tile sizes are multiples of 16 up to this
+constexpr uint32_t TILED_IMAGE_MAX_TILE = 4096;
+
+struct TiledImageHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerBytes;
+    uint32_t width, height;
+    uint32_t tileSize;
+    uint32_t channels;
+    uint32_t tilesX, tilesY;
+    uint64_t tileBytes;
+};
+
+class TiledImage {
+public:
+    TiledImage() = default;
+    ~TiledImage();
+    TiledImage(const TiledImage &) = delete;
+    TiledImage &operator=(const TiledImage &) = delete;
+
+    // New file, sized up front (sparse where the filesystem allows) and mapped read-write.
+    bool create(const std::string &path, int width, int height, int tileSize = 256);
+    // Existing file; random-access advice keeps readahead from pulling in unused tiles.
+    bool open(const std::string &path, bool writable = false);
+    void close();
+    // Writes dirty tiles back (msync); close() does this too for writable files.
+    bool flush();
+
+    unsigned char *tile(int tx, int ty) const;
+    // Window views over one tile, in full-image coordinates (see ImageView)
+    ImageView tileView(int tx, int ty) const;
+    MutableImageView mutableTileView(int tx, int ty) const;
+
+    // Clipped size of a tile, smaller than tileSize on the right and bottom edges
+    int tileWidth(int tx) const;
+    int tileHeight(int ty) const;
+
+    int width = 0, height = 0, tileSize = 0, tilesX = 0, tilesY = 0;
+    size_t tileBytes = 0;
+
+private:
+    unsigned char *mapping = nullptr;
+    size_t mappedBytes = 0;
+    int fd = -1;
+    bool writable = false;
+
+    bool map(size_t size, bool write);
+};
+
+// Copies a decoded image into / out of tiles.
+bool imageToTiles(const Image &image, TiledImage &tiles);
+Image tilesToImage(const TiledImage &tiles);
+
+// Copies the source pixels [x0, x1) x [y0, y1), which may span tiles, into out as tightly
+// packed RGBA rows.
+void readTileWindow(const TiledImage &src, int x0, int y0, int x1, int y1, unsigned char *out);
+
+// Upscales the output rectangle [x0, x1) x [y0, y1) of src into dst, a window in the
+// coordinates of the full output image (dst.width x dst.height). Each call reads only
+// the source tiles under the rectangle's footprint: straight from the mapping when it
+// fits in one tile, otherwise through a small per-thread gather buffer.
+void upscaleTileRect(const TiledImage &src, const MutableImageView &dst, int x0, int y0, int x1, int y1,
+                     UpscaleMode mode, float sharpness);
+
+// Upscales src into dst (already created at the output size) tile by tile, one
+// task per output tile through upscaleTileRect. Output is written in place. The optional
+// rectangle [x0, x1) x [y0, y1) in output pixels limits the work to the tiles it touches.
+void upscaleTiled(const TiledImage &src, TiledImage &dst, UpscaleMode mode, float sharpness,
+                  ThreadPool *pool = nullptr, int x0 = 0, int y0 = 0, int x1 = -1, int y1 = -1);
@@ -0,0 +1,155 @@
+#include "Tracing.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+struct TraceEvent {
+    const char *name;
+    int64_t startNs, durationNs;
+};
+
+// Written by one thread only; the writer publishes count with a release store and
+// traceStop reads the events below it after an acquire load.
+struct TraceTrack {
+    static constexpr uint32_t CAPACITY = 1 << 16;
+
+    std::string name;
+    int id = 0;
+    std::unique_ptr<TraceEvent[]> events; // allocated by the first span recorded
+    std::atomic<uint32_t> count = 0, session = 0, dropped = 0;
+};
+
+namespace {
+
+std::atomic<bool> active = false;
+std::atomic<uint32_t> currentSession = 0;
+
+// Tracks are never freed, so a worker's spans survive the worker
+std::mutex tracksMutex;
+std::vector<std::unique_ptr<TraceTrack>> tracks;
+
+thread_local TraceTrack *threadTrack = nullptr;
+
+TraceTrack *addTrack(std::string name) {
+    std::lock_guard lock(tracksMutex);
+    auto track = std::make_unique<TraceTrack>();
+    track->id = (int) tracks.size() + 1;
+    track->name = name.empty() ? "thread " + std::to_string(track->id) : std::move(name);
+    tracks.push_back(std::move(track));
+    return tracks.back().get();
+}
+
+TraceTrack *currentThreadTrack() {
+    if (!threadTrack)
+        threadTrack = addTrack("");
+    return threadTrack;
+}
+
+// Names are code literals, but keep the JSON valid whatever they contain
+void writeJsonString(FILE *file, const char *text) {
+    std::fputc('"', file);
+    for (const char *c = text; *c; c++) {
+        if (*c == '"' || *c == '\\') std::fprintf(file, "\\%c", *c);
+        else if ((unsigned char) *c < 0x20) std::fprintf(file, "\\u%04x", *c);
+        else std::fputc(*c, file);
+    }
+    std::fputc('"', file);
+}
+
+}
+
+void traceStart() {
+    currentSession.fetch_add(1, std::memory_order_release);
+    active.store(true, std::memory_order_release);
+}
+
+bool traceActive() {
+    return active.load(std::memory_order_relaxed);
+}
+
+bool traceStop(const std::string &path) {
+    active.store(false, std::memory_order_release);
+    uint32_t session = currentSession.load(std::memory_order_acquire);
+
+    FILE *file = std::fopen(path.c_str(), "w");
+    if (!file) {
+        std::cout << "ERROR::TRACE:: Could not open " << path << std::endl;
+        return false;
+    }
+    std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    size_t spans = 0, dropped = 0;
+    std::lock_guard lock(tracksMutex);
+    for (const auto &track : tracks) {
+        std::fprintf(file, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":",
+                     first ? "" : ",\n", track->id);
+        writeJsonString(file, track->name.c_str());
+        std::fprintf(file, "}}");
+        first = false;
+        if (track->session.load(std::memory_order_acquire) != session)
+            continue;
+        uint32_t count = track->count.load(std::memory_order_acquire);
+        for (uint32_t i = 0; i < count; i++) {
+            const TraceEvent &event = track->events[i];
+            std::fprintf(file, ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"name\":", track->id,
+                         event.startNs / 1e3, event.durationNs / 1e3);
+            writeJsonString(file, event.name);
+            std::fputc('}', file);
+        }
+        spans += count;
+        dropped += track->dropped.load(std::memory_order_relaxed);
+    }
+    std::fprintf(file, "\n]}\n");
+    bool ok = std::fclose(file) == 0;
+    if (!ok)
+        std::cout << "ERROR::TRACE:: Failed writing " << path << std::endl;
+    else
+        std::cout << "Trace: " << spans << " spans (" << dropped << " dropped) written to " << path << std::endl;
+    return ok;
+}
+
+void traceSetThreadName(const char *name) {
+    TraceTrack *track = currentThreadTrack();
+    std::lock_guard lock(tracksMutex);
+    track->name = name;
+}
+
+int64_t traceNowNs() {
+    static const auto epoch = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+TraceTrack *traceNewTrack(const char *name) {
+    return addTrack(name);
+}
+
+void traceRecord(TraceTrack *track, const char *name, int64_t startNs, int64_t durationNs) {
+    if (!active.load(std::memory_order_relaxed))
+        return;
+    // First span of a new session on this track: restart from the beginning
+    uint32_t session = currentSession.load(std::memory_order_acquire);
+    if (track->session.load(std::memory_order_relaxed) != session) {
+        track->count.store(0, std::memory_order_relaxed);
+        track->dropped.store(0, std::memory_order_relaxed);
+        track->session.store(session, std::memory_order_release);
+    }
+    if (!track->events)
+        track->events = std::make_unique<TraceEvent[]>(TraceTrack::CAPACITY);
+    uint32_t index = track->count.load(std::memory_order_relaxed);
+    if (index >= TraceTrack::CAPACITY) {
+        track->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    track->events[index] = {name, startNs, durationNs};
+    track->count.store(index + 1, std::memory_order_release);
+}
+
+void TraceZone::end() {
+    if (startNs >= 0)
+        traceRecord(currentThreadTrack(), name, startNs, traceNowNs() - startNs);
+    startNs = -1;
+}
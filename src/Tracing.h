@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// Span tracer with Chrome trace-event JSON output (chrome://tracing, ui.perfetto.dev).
+//
+// Each thread records into its own fixed-size buffer, created on its first span and
+// kept until exit, so recording is a couple of stores and a release; a full buffer
+// drops (and counts) further spans. Spans are only recorded between traceStart and
+// traceStop, and names must outlive the session (string literals).
+//
+//   TRACE_ZONE("upscale");   // records the enclosing scope on this thread's track
+
+// Recording is off until traceStart; a new session discards the previous one.
+void traceStart();
+bool traceActive();
+// Ends the session and writes every track's spans to path. Call from the thread that
+// called traceStart; spans still open on other threads are left out.
+bool traceStop(const std::string &path);
+
+// Shown as the calling thread's track name (optional; tracks default to "thread N")
+void traceSetThreadName(const char *name);
+
+// Clock the spans are measured on: steady_clock, in ns since the first call
+int64_t traceNowNs();
+
+// A track that is not a thread, e.g. the GPU timeline. Recording into one track must
+// happen from one thread at a time.
+struct TraceTrack;
+TraceTrack *traceNewTrack(const char *name);
+void traceRecord(TraceTrack *track, const char *name, int64_t startNs, int64_t durationNs);
+
+class TraceZone {
+public:
+    explicit TraceZone(const char *name) : name(name), startNs(traceActive() ? traceNowNs() : -1) {}
+    ~TraceZone() { end(); }
+
+    // Closes the span before the end of the scope
+    void end();
+
+    TraceZone(const TraceZone &) = delete;
+    TraceZone &operator=(const TraceZone &) = delete;
+
+private:
+    const char *name;
+    int64_t startNs;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_ZONE(name) TraceZone TRACE_CONCAT(traceZone, __LINE__)(name)
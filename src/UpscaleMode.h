@@ -0,0 +1,25 @@
+#pragma once
+#include <string>
+
+// Same numbering as the demo's mode switch (4 = native is not an upscaler).
+enum class UpscaleMode { Nearest = 0, Bilinear = 1, Sharpen = 2, Easu = 3 };
+
+inline const char *upscaleModeName(UpscaleMode mode) {
+    switch (mode) {
+        case UpscaleMode::Nearest: return "nearest";
+        case UpscaleMode::Bilinear: return "bilinear";
+        case UpscaleMode::Sharpen: return "sharpen";
+        case UpscaleMode::Easu: return "easu";
+    }
+    return "?";
+}
+
+inline bool parseUpscaleMode(const std::string &name, UpscaleMode &mode) {
+    for (int i = 0; i <= 3; i++) {
+        if (name == upscaleModeName((UpscaleMode) i)) {
+            mode = (UpscaleMode) i;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,187 @@
+#include "UpscaleProtocol.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+bool makeAddress(const std::string &path, sockaddr_un &address) {
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        std::cout << "ERROR::SOCKET:: Path too long: " << path << std::endl;
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+}
+
+bool readFully(int fd, void *data, size_t size) {
+    auto *bytes = (unsigned char *) data;
+    while (size > 0) {
+        ssize_t n = read(fd, bytes, size);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        bytes += n;
+        size -= (size_t) n;
+    }
+    return true;
+}
+
+bool writeFully(int fd, const void *data, size_t size) {
+    return writeMessage(fd, data, size, nullptr, 0);
+}
+
+bool writeMessage(int fd, const void *header, size_t headerSize, const void *payload, size_t payloadSize) {
+    iovec parts[2] = {{(void *) header, headerSize}, {(void *) payload, payloadSize}};
+    iovec *next = parts;
+    int count = payloadSize > 0 ? 2 : 1;
+
+    while (count > 0) {
+        msghdr message = {};
+        message.msg_iov = next;
+        message.msg_iovlen = count;
+        ssize_t n = sendmsg(fd, &message, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            return false;
+
+        // Skip what was sent, possibly partway into an iovec
+        size_t sent = (size_t) n;
+        while (count > 0 && sent >= next->iov_len) {
+            sent -= next->iov_len;
+            next++;
+            count--;
+        }
+        if (count > 0) {
+            next->iov_base = (unsigned char *) next->iov_base + sent;
+            next->iov_len -= sent;
+        }
+    }
+    return true;
+}
+
+bool resolveOutputSize(const UpscaleRequestHeader &request, int width, int height, int &outWidth, int &outHeight) {
+    outWidth = request.outWidth;
+    outHeight = request.outHeight;
+    if ((outWidth <= 0 || outHeight <= 0) && request.scale > 0.0f && request.scale <= 64.0f) {
+        outWidth = (int) (width * request.scale + 0.5f);
+        outHeight = (int) (height * request.scale + 0.5f);
+    }
+    return outWidth > 0 && outHeight > 0 && outWidth <= UPSCALE_MAX_DIMENSION && outHeight <= UPSCALE_MAX_DIMENSION;
+}
+
+bool readResponse(int fd, UpscaleResponseHeader &header, std::vector<unsigned char> &payload, size_t maxPixelBytes) {
+    if (!readFully(fd, &header, sizeof(header)))
+        return false;
+    if (header.magic != UPSCALE_RESPONSE_MAGIC) {
+        std::cout << "ERROR::SOCKET:: Bad response magic" << std::endl;
+        return false;
+    }
+    // The length comes from the other end: size the buffer only once it matches what we expect
+    bool valid;
+    switch (header.status) {
+        case UpscaleStatus::Ok:
+            valid = header.width >= 0 && header.height >= 0 && header.payloadBytes <= maxPixelBytes &&
+                    header.payloadBytes == (uint64_t) header.width * header.height * 4;
+            break;
+        case UpscaleStatus::Busy: valid = header.payloadBytes == 0; break;
+        case UpscaleStatus::Error: valid = header.payloadBytes <= UPSCALE_MAX_ERROR_BYTES; break;
+        default: valid = false; break;
+    }
+    if (!valid) {
+        std::cout << "ERROR::SOCKET:: Unexpected response of " << header.payloadBytes << " bytes" << std::endl;
+        return false;
+    }
+    payload.resize(header.payloadBytes);
+    return readFully(fd, payload.data(), payload.size());
+}
+
+bool sendFds(int socket, const int *fds, int count) {
+    char tag = 'F';
+    iovec part = {&tag, 1};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * 8)] = {};
+    if (count < 1 || count > 8)
+        return false;
+
+    msghdr message = {};
+    message.msg_iov = &part;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = CMSG_SPACE(sizeof(int) * count);
+    cmsghdr *cmsg = CMSG_FIRSTHDR(&message);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int) * count);
+    std::memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * count);
+    return sendmsg(socket, &message, MSG_NOSIGNAL) == 1;
+}
+
+int receiveFds(int socket, int *fds, int maxCount) {
+    char tag;
+    iovec part = {&tag, 1};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * 8)] = {};
+
+    msghdr message = {};
+    message.msg_iov = &part;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    if (recvmsg(socket, &message, MSG_CMSG_CLOEXEC) != 1)
+        return 0;
+    cmsghdr *cmsg = CMSG_FIRSTHDR(&message);
+    if (!cmsg || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+        return 0;
+    int received = (int) ((cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+    int kept = std::min(received, maxCount);
+    int all[8];
+    std::memcpy(all, CMSG_DATA(cmsg), sizeof(int) * std::min(received, 8));
+    for (int i = 0; i < received && i < 8; i++) {
+        if (i < kept)
+            fds[i] = all[i];
+        else
+            close(all[i]);
+    }
+    return kept;
+}
+
+int connectUnixSocket(const std::string &path) {
+    sockaddr_un address;
+    if (!makeAddress(path, address))
+        return -1;
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || connect(fd, (sockaddr *) &address, sizeof(address)) != 0) {
+        std::cout << "ERROR::SOCKET:: Failed to connect to " << path << ": " << std::strerror(errno) << std::endl;
+        if (fd >= 0)
+            close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int listenUnixSocket(const std::string &path) {
+    sockaddr_un address;
+    if (!makeAddress(path, address))
+        return -1;
+    unlink(path.c_str());
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || bind(fd, (sockaddr *) &address, sizeof(address)) != 0 || chmod(path.c_str(), 0600) != 0 ||
+        listen(fd, 64) != 0) {
+        std::cout << "ERROR::SOCKET:: Failed to listen on " << path << ": " << std::strerror(errno) << std::endl;
+        if (fd >= 0)
+            close(fd);
+        return -1;
+    }
+    return fd;
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Wire format spoken by upscalerd over its Unix domain socket. Every message is a
+// fixed header followed by payloadBytes of payload, in host byte order (the socket
+// never leaves the machine). A connection may pipeline any number of requests;
+// responses carry the request id and can come back in a different order.
+
+constexpr uint32_t UPSCALE_REQUEST_MAGIC = 0x52535055;  // "UPSR"
+constexpr uint32_t UPSCALE_RESPONSE_MAGIC = 0x53535055; // "UPSS"
+constexpr int UPSCALE_MAX_DIMENSION = 16384;
+constexpr uint32_t UPSCALE_MAX_ERROR_BYTES = 4096;
+constexpr const char *UPSCALE_DEFAULT_SOCKET = "/tmp/upscalerd.sock";
+
+enum class UpscaleSource : uint8_t {
+    Pixels = 0, // payload is width * height RGBA8 pixels
+    Path = 1    // payload is "input\0output"; output may be empty to get the pixels back.
+                // Only served when the daemon has a --root, and only for files under it.
+};
+
+enum class UpscaleStatus : uint8_t {
+    Ok = 0,
+    Busy = 1,   // queue full, nothing was done; retry later
+    Error = 2   // payload is the error message
+};
+
+struct UpscaleRequestHeader {
+    uint32_t magic = UPSCALE_REQUEST_MAGIC;
+    uint32_t id = 0;
+    uint8_t mode = 3;           // UpscaleMode
+    UpscaleSource source = UpscaleSource::Pixels;
+    uint16_t reserved = 0;
+    float scale = 2.0f;         // used when outWidth/outHeight are 0
+    float sharpness = -1.0f;    // < 0 picks the mode's default
+    int32_t width = 0, height = 0;
+    int32_t outWidth = 0, outHeight = 0;
+    uint32_t payloadBytes = 0;
+};
+
+struct UpscaleResponseHeader {
+    uint32_t magic = UPSCALE_RESPONSE_MAGIC;
+    uint32_t id = 0;
+    UpscaleStatus status = UpscaleStatus::Ok;
+    uint8_t reserved[3] = {};
+    int32_t width = 0, height = 0; // of the RGBA8 payload, 0 when nothing is returned
+    uint32_t payloadBytes = 0;
+};
+
+// Blocking helpers; false on EOF or error. Writes never raise SIGPIPE.
+bool readFully(int fd, void *data, size_t size);
+bool writeFully(int fd, const void *data, size_t size);
+
+// Header and payload in one call, so concurrent writers only need to lock around it.
+bool writeMessage(int fd, const void *header, size_t headerSize, const void *payload, size_t payloadSize);
+
+// Output size for a request on a width x height source: outWidth/outHeight, else the
+// scale. False when it is out of range.
+bool resolveOutputSize(const UpscaleRequestHeader &request, int width, int height, int &outWidth, int &outHeight);
+
+// Client side: reads one response header and its payload; false on EOF, error, bad magic
+// or a payload that doesn't fit the header. Pixels are only accepted up to maxPixelBytes
+// (what the client asked for), error messages up to UPSCALE_MAX_ERROR_BYTES.
+bool readResponse(int fd, UpscaleResponseHeader &header, std::vector<unsigned char> &payload, size_t maxPixelBytes);
+
+// Passes file descriptors (e.g. shared-memory rings) over a Unix socket with SCM_RIGHTS.
+bool sendFds(int socket, const int *fds, int count);
+// Returns the number of descriptors received, 0 on failure.
+int receiveFds(int socket, int *fds, int maxCount);
+
+// Returns the connected socket, or -1 after printing the error.
+int connectUnixSocket(const std::string &path);
+// Removes a stale socket file, binds and listens; only the owner may connect. Returns -1
+// after printing the error.
+int listenUnixSocket(const std::string &path);
@@ -0,0 +1,184 @@
+#include "Upscaler.h"
+#include "PolyphaseFilter.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+float defaultSharpness(UpscaleMode mode) {
+    return mode == UpscaleMode::Easu ? 0.2f : 0.5f;
+}
+
+// upscaleImage with one of the shader-matching modes
+class CpuModeUpscaler : public IUpscaler {
+public:
+    explicit CpuModeUpscaler(UpscaleMode mode) : mode(mode) { sharpness = defaultSharpness(mode); }
+
+    const char *name() const override { return upscaleModeName(mode); }
+    UpscalerBackend backend() const override { return UpscalerBackend::Cpu; }
+    void setThreadPool(ThreadPool *threadPool) override { pool = threadPool; }
+
+protected:
+    void processImage(const ImageView &src, const MutableImageView &dst) override {
+        upscaleImage(src, dst, mode, sharpness, pool);
+    }
+
+private:
+    UpscaleMode mode;
+    ThreadPool *pool = nullptr;
+};
+
+// Bilinear to the output size, then the RCAS pass (fragment_rcas) at the output size.
+// RCAS is c - s * lap, the sharpen mode's formula, so that pass is sharpen at 1:1.
+class CpuRcasUpscaler : public IUpscaler {
+public:
+    CpuRcasUpscaler() { sharpness = 0.2f; }
+
+    const char *name() const override { return "rcas"; }
+    UpscalerBackend backend() const override { return UpscalerBackend::Cpu; }
+    void setThreadPool(ThreadPool *threadPool) override { pool = threadPool; }
+
+    void resize(int sw, int sh, int dw, int dh) override {
+        IUpscaler::resize(sw, sh, dw, dh);
+        if (upscaled.width != dw || upscaled.height != dh)
+            upscaled = Image(dw, dh, 4);
+    }
+
+protected:
+    void processImage(const ImageView &src, const MutableImageView &dst) override {
+        upscaleImage(src, upscaled, UpscaleMode::Bilinear, 0.0f, pool);
+        upscaleImage(upscaled, dst, UpscaleMode::Sharpen, sharpness, pool);
+    }
+
+private:
+    Image upscaled;
+    ThreadPool *pool = nullptr;
+};
+
+// Horizontal then vertical pass of a separable kernel; the weight tables are rebuilt only
+// when a size changes
+class CpuSeparableUpscaler : public IUpscaler {
+public:
+    explicit CpuSeparableUpscaler(FilterKernel kernel) : kernel(kernel) {}
+
+    const char *name() const override { return filterKernelName(kernel); }
+    UpscalerBackend backend() const override { return UpscalerBackend::Cpu; }
+    void setThreadPool(ThreadPool *threadPool) override { pool = threadPool; }
+
+    void resize(int sw, int sh, int dw, int dh) override {
+        if (sw != srcWidth || dw != dstWidth)
+            x = buildPolyphaseTable(kernel, sw, dw);
+        if (sh != srcHeight || dh != dstHeight)
+            y = buildPolyphaseTable(kernel, sh, dh);
+        IUpscaler::resize(sw, sh, dw, dh);
+    }
+
+protected:
+    void processImage(const ImageView &src, const MutableImageView &dst) override {
+        upscaleSeparable(src, dst, x, y, intermediate, pool);
+    }
+
+private:
+    FilterKernel kernel;
+    PolyphaseTable x, y;
+    std::vector<int16_t> intermediate;
+    ThreadPool *pool = nullptr;
+};
+
+struct Registration {
+    std::string name;
+    UpscalerBackend backend;
+    UpscalerFactory factory;
+};
+
+std::vector<Registration> &registrations() {
+    static std::vector<Registration> instance = [] {
+        std::vector<Registration> cpu;
+        for (int i = 0; i <= 3; i++) {
+            UpscaleMode mode = (UpscaleMode) i;
+            cpu.push_back({upscaleModeName(mode), UpscalerBackend::Cpu,
+                           [mode] { return std::make_unique<CpuModeUpscaler>(mode); }});
+        }
+        cpu.push_back({"rcas", UpscalerBackend::Cpu, [] { return std::make_unique<CpuRcasUpscaler>(); }});
+        for (FilterKernel kernel : ALL_FILTER_KERNELS)
+            cpu.push_back({filterKernelName(kernel), UpscalerBackend::Cpu,
+                           [kernel] { return std::make_unique<CpuSeparableUpscaler>(kernel); }});
+        return cpu;
+    }();
+    return instance;
+}
+
+Registration *findRegistration(const std::string &name, UpscalerBackend backend) {
+    auto &all = registrations();
+    auto it = std::find_if(all.begin(), all.end(), [&](const Registration &r) {
+        return r.backend == backend && r.name == name;
+    });
+    return it == all.end() ? nullptr : &*it;
+}
+
+}
+
+const char *upscalerBackendName(UpscalerBackend backend) {
+    return backend == UpscalerBackend::Gl ? "gl" : "cpu";
+}
+
+bool IUpscaler::init(int sw, int sh, int dw, int dh) {
+    resize(sw, sh, dw, dh);
+    return true;
+}
+
+void IUpscaler::resize(int sw, int sh, int dw, int dh) {
+    srcWidth = sw;
+    srcHeight = sh;
+    dstWidth = dw;
+    dstHeight = dh;
+}
+
+void IUpscaler::process(const ImageView &src, const MutableImageView &dst) {
+    auto start = Clock::now();
+    processImage(src, dst);
+    stats.lastMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    stats.totalMs += stats.lastMs;
+    stats.calls++;
+}
+
+bool IUpscaler::render(unsigned int srcTexture, unsigned int targetFbo) {
+    auto start = Clock::now();
+    if (!renderTexture(srcTexture, targetFbo))
+        return false;
+    stats.lastMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    stats.totalMs += stats.lastMs;
+    stats.calls++;
+    return true;
+}
+
+void registerUpscaler(const std::string &name, UpscalerBackend backend, UpscalerFactory factory) {
+    if (Registration *existing = findRegistration(name, backend))
+        existing->factory = std::move(factory);
+    else
+        registrations().push_back({name, backend, std::move(factory)});
+}
+
+std::unique_ptr<IUpscaler> createUpscaler(const std::string &name, UpscalerBackend backend) {
+    Registration *registration = findRegistration(name, backend);
+    if (!registration) {
+        std::cout << "ERROR::UPSCALER:: No " << upscalerBackendName(backend) << " upscaler named " << name << std::endl;
+        return nullptr;
+    }
+    return registration->factory();
+}
+
+bool hasUpscaler(const std::string &name, UpscalerBackend backend) {
+    return findRegistration(name, backend) != nullptr;
+}
+
+std::vector<std::string> upscalerNames(UpscalerBackend backend) {
+    std::vector<std::string> names;
+    for (const Registration &r : registrations())
+        if (r.backend == backend)
+            names.push_back(r.name);
+    return names;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "CpuUpscaler.h"
+#include "Image.h"
+
+class ThreadPool;
+
+enum class UpscalerBackend { Cpu, Gl };
+
+const char *upscalerBackendName(UpscalerBackend backend);
+
+// Wall time of process() / render() calls. For render() that is GL submission only;
+// time the GPU side with GpuTimer.
+struct UpscalerStats {
+    uint64_t calls = 0;
+    double lastMs = 0.0, totalMs = 0.0;
+
+    double averageMs() const { return calls ? totalMs / (double) calls : 0.0; }
+};
+
+// One upscaling algorithm on one backend. Instances come from the registry below, so
+// the demo, the tools and the benchmarks all run the same objects. init() once with
+// the sizes (GL backends compile their shaders there, so need a current context; CPU
+// backends only need the sizes, so resize() will do), resize() when they change, then
+// process() or render() per frame.
+class IUpscaler {
+public:
+    virtual ~IUpscaler() = default;
+
+    virtual const char *name() const = 0;
+    virtual UpscalerBackend backend() const = 0;
+
+    virtual bool init(int srcWidth, int srcHeight, int dstWidth, int dstHeight);
+    virtual void resize(int srcWidth, int srcHeight, int dstWidth, int dstHeight);
+    // Spreads the work of CPU backends across the pool; GL backends ignore it
+    virtual void setThreadPool(ThreadPool *) {}
+
+    // RGBA8 at the current sizes, any row stride (an Image converts to either view). CPU
+    // backends read and write the views in place; GL backends upload src and read dst back.
+    void process(const ImageView &src, const MutableImageView &dst);
+    // GL backends only: draws srcTexture, at the source size, into targetFbo over the
+    // whole output size. False on CPU backends.
+    bool render(unsigned int srcTexture, unsigned int targetFbo);
+
+    // In the algorithm's own units, set to its default by the registry; nearest, bilinear
+    // and the separable filters ignore it
+    float sharpness = 0.0f;
+    int srcWidth = 0, srcHeight = 0, dstWidth = 0, dstHeight = 0;
+    UpscalerStats stats;
+
+protected:
+    virtual void processImage(const ImageView &src, const MutableImageView &dst) = 0;
+    virtual bool renderTexture(unsigned int, unsigned int) { return false; }
+};
+
+using UpscalerFactory = std::function<std::unique_ptr<IUpscaler>()>;
+
+// The same name on each backend is the same algorithm. Registering a name again on a
+// backend replaces it. The CPU backends (nearest, bilinear, sharpen, easu, rcas, then the
+// separable catmull-rom, mitchell, lanczos2 and lanczos3; see PolyphaseFilter.h) are
+// always registered; the GL ones after registerGlUpscalers() (see GlUpscalers.h).
+// Register from one thread before any creates; creating from several is fine.
+void registerUpscaler(const std::string &name, UpscalerBackend backend, UpscalerFactory factory);
+// nullptr, with a message, for a name the backend doesn't have
+std::unique_ptr<IUpscaler> createUpscaler(const std::string &name, UpscalerBackend backend);
+bool hasUpscaler(const std::string &name, UpscalerBackend backend);
+// In registration order
+std::vector<std::string> upscalerNames(UpscalerBackend backend);
@@ -0,0 +1,304 @@
+#include "UpscalerApi.h"
+#include "GlUpscalers.h"
+#include "ThreadPool.h"
+#include "Upscaler.h"
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+struct upscaler {
+    std::unique_ptr<IUpscaler> impl;
+    std::unique_ptr<ThreadPool> pool;
+    // GL: FBO that upscaler_process_texture attaches the caller's output texture to
+    unsigned int fbo = 0;
+};
+
+namespace {
+
+// The modes are the CPU registry's, which always has every built-in upscaler; each of
+// them also has a GL version (createGlUpscaler)
+const std::vector<std::string> &modeNames() {
+    static const std::vector<std::string> names = upscalerNames(UpscalerBackend::Cpu);
+    return names;
+}
+
+// glad's function pointers are process-wide, so they are loaded once, by the first GL
+// upscaler_create; reloading them would swap them under upscalers in use. A failed load
+// throws out of call_once, which leaves the flag unset for the next create to retry.
+std::once_flag glLoaded;
+struct GlLoadFailed {};
+
+bool loadGl(void *(*getProcAddress)(const char *)) {
+    try {
+        std::call_once(glLoaded, [&] {
+            if (!gladLoadGLLoader((GLADloadproc) getProcAddress))
+                throw GlLoadFailed();
+        });
+        return true;
+    } catch (const GlLoadFailed &) {
+        return false;
+    }
+}
+
+// Runs an entry point's body: a C++ exception must not unwind into a C caller. The entry
+// points that can't throw (no allocation, no GL object creation) don't need it.
+template<typename Body>
+upscaler_status guarded(Body &&body) noexcept {
+    try {
+        return body();
+    } catch (const std::bad_alloc &) {
+        return UPSCALER_ERROR_OUT_OF_MEMORY;
+    } catch (...) {
+        return UPSCALER_ERROR_INTERNAL;
+    }
+}
+
+bool validSize(int srcWidth, int srcHeight, int dstWidth, int dstHeight) {
+    return srcWidth > 0 && srcHeight > 0 && dstWidth > 0 && dstHeight > 0;
+}
+
+// The caller's GL state that the upscaler passes change, put back when it goes out of scope.
+// Pixel buffers and row lengths are also reset while it lives, since the uploads and
+// readbacks assume client memory and tight (or their own) rows. GL errors already pending
+// are the caller's: they are cleared on entry, so a glGetError() after the library's calls
+// only sees its own.
+struct GlStateGuard {
+    // Textures on units 0 and 1: the separable passes bind their weights on unit 1
+    GLint drawFramebuffer = 0, readFramebuffer = 0, viewport[4] = {}, program = 0, activeTexture = 0, textures[2] = {};
+    GLint vertexArray = 0, arrayBuffer = 0, packBuffer = 0, unpackBuffer = 0;
+    GLint packAlignment = 4, unpackAlignment = 4, packRowLength = 0, unpackRowLength = 0;
+    GLboolean depthTest = GL_FALSE;
+
+    GlStateGuard() {
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &drawFramebuffer);
+        glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &readFramebuffer);
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+        glGetIntegerv(GL_ACTIVE_TEXTURE, &activeTexture);
+        for (int unit = 0; unit < 2; unit++) {
+            glActiveTexture(GL_TEXTURE0 + unit);
+            glGetIntegerv(GL_TEXTURE_BINDING_2D, &textures[unit]);
+        }
+        glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &vertexArray);
+        glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &arrayBuffer);
+        glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &packBuffer);
+        glGetIntegerv(GL_PIXEL_UNPACK_BUFFER_BINDING, &unpackBuffer);
+        glGetIntegerv(GL_PACK_ALIGNMENT, &packAlignment);
+        glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpackAlignment);
+        glGetIntegerv(GL_PACK_ROW_LENGTH, &packRowLength);
+        glGetIntegerv(GL_UNPACK_ROW_LENGTH, &unpackRowLength);
+        depthTest = glIsEnabled(GL_DEPTH_TEST);
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        while (glGetError() != GL_NO_ERROR) {
+        }
+    }
+
+    ~GlStateGuard() {
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, (GLuint) drawFramebuffer);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, (GLuint) readFramebuffer);
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+        glUseProgram((GLuint) program);
+        for (int unit = 0; unit < 2; unit++) {
+            glActiveTexture(GL_TEXTURE0 + unit);
+            glBindTexture(GL_TEXTURE_2D, (GLuint) textures[unit]);
+        }
+        glActiveTexture((GLenum) activeTexture);
+        glBindVertexArray((GLuint) vertexArray);
+        glBindBuffer(GL_ARRAY_BUFFER, (GLuint) arrayBuffer);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, (GLuint) packBuffer);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, (GLuint) unpackBuffer);
+        glPixelStorei(GL_PACK_ALIGNMENT, packAlignment);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, unpackAlignment);
+        glPixelStorei(GL_PACK_ROW_LENGTH, packRowLength);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, unpackRowLength);
+        if (depthTest)
+            glEnable(GL_DEPTH_TEST);
+    }
+};
+
+}
+
+extern "C" {
+
+int upscaler_api_version(void) {
+    return UPSCALER_API_VERSION;
+}
+
+const char *upscaler_status_string(upscaler_status status) {
+    switch (status) {
+        case UPSCALER_OK: return "ok";
+        case UPSCALER_ERROR_INVALID_ARGUMENT: return "invalid argument";
+        case UPSCALER_ERROR_UNKNOWN_MODE: return "unknown mode";
+        case UPSCALER_ERROR_GL: return "GL error";
+        case UPSCALER_ERROR_WRONG_BACKEND: return "wrong backend";
+        case UPSCALER_ERROR_OUT_OF_MEMORY: return "out of memory";
+        case UPSCALER_ERROR_INTERNAL: return "internal error";
+    }
+    return "unknown status";
+}
+
+const char *upscaler_mode_name(int index) {
+    try {
+        const std::vector<std::string> &names = modeNames();
+        return index >= 0 && index < (int) names.size() ? names[index].c_str() : nullptr;
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void upscaler_config_init(upscaler_config *config) {
+    if (!config)
+        return;
+    std::memset(config, 0, sizeof(*config));
+    config->struct_size = sizeof(*config);
+    config->backend = UPSCALER_BACKEND_CPU;
+    config->sharpness = -1.0f;
+}
+
+upscaler_status upscaler_create(const upscaler_config *config, upscaler **out) {
+    if (!config || !out || config->struct_size < offsetof(upscaler_config, sharpness))
+        return UPSCALER_ERROR_INVALID_ARGUMENT;
+    *out = nullptr;
+    return guarded([&] {
+        // A caller built against an older header passes a shorter struct; the rest keeps the defaults
+        upscaler_config c;
+        upscaler_config_init(&c);
+        std::memcpy(&c, config, std::min<size_t>(config->struct_size, sizeof(c)));
+        c.struct_size = sizeof(c);
+        if (!validSize(c.src_width, c.src_height, c.dst_width, c.dst_height) || c.threads < 0)
+            return UPSCALER_ERROR_INVALID_ARGUMENT;
+
+        std::string mode = c.mode ? c.mode : "easu";
+        const std::vector<std::string> &names = modeNames();
+        if (std::find(names.begin(), names.end(), mode) == names.end())
+            return UPSCALER_ERROR_UNKNOWN_MODE;
+
+        // Freed on every early return, and if anything below throws
+        std::unique_ptr<upscaler, decltype(&upscaler_destroy)> u(new upscaler, upscaler_destroy);
+        if (c.backend == UPSCALER_BACKEND_GL) {
+            // Our own glad function pointers, not visible to (or clashing with) the caller's
+            if (!c.gl_get_proc_address || !loadGl(c.gl_get_proc_address))
+                return UPSCALER_ERROR_GL;
+            u->impl = createGlUpscaler(mode, c.shader_dir ? c.shader_dir : "shaders");
+            if (!u->impl)
+                return UPSCALER_ERROR_UNKNOWN_MODE;
+            // Missing or broken shaders only show up as GL errors from init; the guard there
+            // first drops whatever compiling them raised
+        } else if (c.backend == UPSCALER_BACKEND_CPU) {
+            u->impl = createUpscaler(mode, UpscalerBackend::Cpu);
+            if (c.threads != 1)
+                u->pool = std::make_unique<ThreadPool>(c.threads ? (unsigned int) c.threads
+                                                                 : std::thread::hardware_concurrency());
+            u->impl->setThreadPool(u->pool.get());
+        } else {
+            return UPSCALER_ERROR_INVALID_ARGUMENT;
+        }
+
+        if (c.sharpness >= 0.0f)
+            u->impl->sharpness = c.sharpness;
+        bool ok;
+        if (c.backend == UPSCALER_BACKEND_GL) {
+            GlStateGuard guard;
+            ok = u->impl->init(c.src_width, c.src_height, c.dst_width, c.dst_height) && glGetError() == GL_NO_ERROR;
+        } else {
+            ok = u->impl->init(c.src_width, c.src_height, c.dst_width, c.dst_height);
+        }
+        if (!ok)
+            return UPSCALER_ERROR_GL;
+        *out = u.release();
+        return UPSCALER_OK;
+    });
+}
+
+void upscaler_destroy(upscaler *u) {
+    if (!u)
+        return;
+    if (u->fbo)
+        glDeleteFramebuffers(1, &u->fbo);
+    delete u;
+}
+
+upscaler_status upscaler_resize(upscaler *u, int srcWidth, int srcHeight, int dstWidth, int dstHeight) {
+    if (!u || !validSize(srcWidth, srcHeight, dstWidth, dstHeight))
+        return UPSCALER_ERROR_INVALID_ARGUMENT;
+    return guarded([&] {
+        if (u->impl->backend() == UpscalerBackend::Cpu) {
+            u->impl->resize(srcWidth, srcHeight, dstWidth, dstHeight);
+            return UPSCALER_OK;
+        }
+        // Reallocates the GL upscaler's textures and framebuffers
+        GlStateGuard guard;
+        u->impl->resize(srcWidth, srcHeight, dstWidth, dstHeight);
+        return glGetError() == GL_NO_ERROR ? UPSCALER_OK : UPSCALER_ERROR_GL;
+    });
+}
+
+upscaler_status upscaler_set_sharpness(upscaler *u, float sharpness) {
+    if (!u || !(sharpness >= 0.0f))
+        return UPSCALER_ERROR_INVALID_ARGUMENT;
+    u->impl->sharpness = sharpness;
+    return UPSCALER_OK;
+}
+
+upscaler_status upscaler_process(upscaler *u, const uint8_t *src, size_t srcStride, uint8_t *dst, size_t dstStride) {
+    if (!u || !src || !dst)
+        return UPSCALER_ERROR_INVALID_ARGUMENT;
+    IUpscaler &impl = *u->impl;
+    if (srcStride < (size_t) impl.srcWidth * 4 || dstStride < (size_t) impl.dstWidth * 4)
+        return UPSCALER_ERROR_INVALID_ARGUMENT;
+    // Views over the caller's buffers: the CPU kernels work on them directly
+    ImageView srcView(src, impl.srcWidth, impl.srcHeight, srcStride);
+    MutableImageView dstView(dst, impl.dstWidth, impl.dstHeight, dstStride);
+    return guarded([&] {
+        if (impl.backend() == UpscalerBackend::Cpu) {
+            impl.process(srcView, dstView);
+            return UPSCALER_OK;
+        }
+        GlStateGuard guard;
+        impl.process(srcView, dstView);
+        return glGetError() == GL_NO_ERROR ? UPSCALER_OK : UPSCALER_ERROR_GL;
+    });
+}
+
+upscaler_status upscaler_process_texture(upscaler *u, unsigned int srcTexture, unsigned int dstTexture) {
+    if (!u || !srcTexture || !dstTexture)
+        return UPSCALER_ERROR_INVALID_ARGUMENT;
+    if (u->impl->backend() != UpscalerBackend::Gl)
+        return UPSCALER_ERROR_WRONG_BACKEND;
+    return guarded([&] {
+        GlStateGuard guard;
+        if (!u->fbo)
+            glGenFramebuffers(1, &u->fbo);
+        // Attached on every call: a texture name the caller deleted and reused must not keep a stale attachment
+        glBindFramebuffer(GL_FRAMEBUFFER, u->fbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, dstTexture, 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+            return UPSCALER_ERROR_INVALID_ARGUMENT;
+        }
+        u->impl->render(srcTexture, u->fbo);
+        return glGetError() == GL_NO_ERROR ? UPSCALER_OK : UPSCALER_ERROR_GL;
+    });
+}
+
+upscaler_status upscaler_get_stats(const upscaler *u, uint64_t *calls, double *averageMs, double *lastMs) {
+    if (!u)
+        return UPSCALER_ERROR_INVALID_ARGUMENT;
+    const UpscalerStats &stats = u->impl->stats;
+    if (calls)
+        *calls = stats.calls;
+    if (averageMs)
+        *averageMs = stats.averageMs();
+    if (lastMs)
+        *lastMs = stats.lastMs;
+    return UPSCALER_OK;
+}
+
+}
@@ -0,0 +1,139 @@
+#pragma once
+/*
+ * C interface to the upscaler engine, built as the libupscaler shared library from the
+ * same core as the demo and the tools (see Upscaler.h). Only this header is needed to
+ * use it, from C or C++.
+ *
+ * An upscaler is one algorithm from the engine's registry ("nearest", "bilinear",
+ * "sharpen", "easu", "rcas", or a separable "catmull-rom", "mitchell", "lanczos2",
+ * "lanczos3"; upscaler_mode_name lists them) on one backend, at fixed source and output
+ * sizes (change them with upscaler_resize):
+ *
+ *   upscaler_config config;
+ *   upscaler_config_init(&config);
+ *   config.mode = "easu";
+ *   config.src_width = 960;  config.src_height = 540;
+ *   config.dst_width = 1920; config.dst_height = 1080;
+ *   upscaler *u;
+ *   if (upscaler_create(&config, &u) == UPSCALER_OK) {
+ *       upscaler_process(u, src, src_stride, dst, dst_stride);
+ *       upscaler_destroy(u);
+ *   }
+ *
+ * Pixels are RGBA8, rows top to bottom, in buffers the caller owns; strides are in
+ * bytes and may include padding. The CPU backend reads src and writes dst in place at
+ * any stride, with no internal copy. The GL backend uploads src into its own texture
+ * and reads the result straight back into dst.
+ *
+ * No C++ exception leaves the library: failures come back as an upscaler_status.
+ *
+ * One upscaler must not be used from two threads at once. Separate upscalers can run
+ * in parallel, each on its own thread pool. A GL upscaler must be used with the
+ * context it was created with current.
+ *
+ * The ABI is stable within UPSCALER_API_VERSION: functions are only added, and
+ * upscaler_config only grows at the end. Its struct_size field says how much of it the
+ * caller knows about.
+ */
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#if defined(UPSCALER_BUILDING_LIBRARY)
+#define UPSCALER_API __declspec(dllexport)
+#else
+#define UPSCALER_API __declspec(dllimport)
+#endif
+#else
+#define UPSCALER_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define UPSCALER_API_VERSION 1
+
+typedef struct upscaler upscaler;
+
+typedef enum upscaler_backend {
+    UPSCALER_BACKEND_CPU = 0,
+    UPSCALER_BACKEND_GL = 1,
+} upscaler_backend;
+
+typedef enum upscaler_status {
+    UPSCALER_OK = 0,
+    UPSCALER_ERROR_INVALID_ARGUMENT = 1,
+    UPSCALER_ERROR_UNKNOWN_MODE = 2,
+    /* GL backend: no loader given, the functions failed to load, or a GL error */
+    UPSCALER_ERROR_GL = 3,
+    /* The call needs the other backend (upscaler_process_texture on a CPU upscaler) */
+    UPSCALER_ERROR_WRONG_BACKEND = 4,
+    UPSCALER_ERROR_OUT_OF_MEMORY = 5,
+    /* Any other failure inside the library, e.g. its worker threads could not start */
+    UPSCALER_ERROR_INTERNAL = 6,
+} upscaler_status;
+
+typedef struct upscaler_config {
+    /* sizeof(upscaler_config), set by upscaler_config_init */
+    uint32_t struct_size;
+    upscaler_backend backend;
+    /* One of the names from upscaler_mode_name; NULL = "easu" */
+    const char *mode;
+    int src_width, src_height, dst_width, dst_height;
+    /* In the mode's own units; negative = the mode's default */
+    float sharpness;
+    /* CPU: worker threads, 0 = one per core, 1 = only the calling thread */
+    int threads;
+    /* GL: the context's GL 3.3 function loader (e.g. glfwGetProcAddress or
+       eglGetProcAddress); required, since the library loads its own function pointers.
+       They are loaded once per process, through the first GL upscaler's loader, so every
+       GL upscaler must use contexts those pointers are valid for. */
+    void *(*gl_get_proc_address)(const char *name);
+    /* GL: directory holding the demo's shaders; NULL = "shaders" in the working directory */
+    const char *shader_dir;
+} upscaler_config;
+
+UPSCALER_API int upscaler_api_version(void);
+UPSCALER_API const char *upscaler_status_string(upscaler_status status);
+
+/* The built-in modes, for index 0 up to the first NULL */
+UPSCALER_API const char *upscaler_mode_name(int index);
+
+/* Defaults: CPU, easu, default sharpness, one thread per core, all sizes 0 */
+UPSCALER_API void upscaler_config_init(upscaler_config *config);
+
+/* On success *out is a new upscaler, to be freed with upscaler_destroy. A GL upscaler
+   compiles its shaders here, so the caller's context must be current. */
+UPSCALER_API upscaler_status upscaler_create(const upscaler_config *config, upscaler **out);
+/* NULL is ignored. A GL upscaler frees its GL objects, so its context must be current. */
+UPSCALER_API void upscaler_destroy(upscaler *u);
+
+UPSCALER_API upscaler_status upscaler_resize(upscaler *u, int src_width, int src_height, int dst_width,
+                                             int dst_height);
+UPSCALER_API upscaler_status upscaler_set_sharpness(upscaler *u, float sharpness);
+
+/* src is src_width x src_height, dst is dst_width x dst_height, each stride at least
+   4 * width. Either backend. The GL calls here, in upscaler_create, upscaler_resize and
+   upscaler_process_texture restore the draw and read framebuffers, viewport, program,
+   textures on units 0 and 1, vertex array, array buffer, pixel pack/unpack buffers,
+   alignment and row length, and depth test state they change. They also clear any GL
+   errors already pending (glGetError until GL_NO_ERROR) so that their status reflects
+   only their own; check for yours before calling. */
+UPSCALER_API upscaler_status upscaler_process(upscaler *u, const uint8_t *src, size_t src_stride, uint8_t *dst,
+                                              size_t dst_stride);
+
+/* GL backend only, entirely on the GPU: draws the caller's src_texture (src size,
+   sampled with the filter the mode needs, which is set on it) into the caller's
+   dst_texture (an RGBA8 texture at the output size). */
+UPSCALER_API upscaler_status upscaler_process_texture(upscaler *u, unsigned int src_texture,
+                                                      unsigned int dst_texture);
+
+/* Calls so far and their average and last wall time in milliseconds; for GL textures
+   that is submission time. Any pointer may be NULL. */
+UPSCALER_API upscaler_status upscaler_get_stats(const upscaler *u, uint64_t *calls, double *average_ms,
+                                                double *last_ms);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,93 @@
+#include "Y4m.h"
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+bool readLine(FILE *file, std::string &line) {
+    line.clear();
+    int c;
+    while ((c = std::fgetc(file)) != EOF && c != '\n')
+        line.push_back((char) c);
+    return c == '\n';
+}
+
+bool readPlane(FILE *file, std::vector<unsigned char> &plane) {
+    return std::fread(plane.data(), 1, plane.size(), file) == plane.size();
+}
+
+}
+
+Y4mReader::~Y4mReader() {
+    if (file) std::fclose(file);
+}
+
+bool Y4mReader::open(const std::string &path) {
+    file = path == "-" ? stdin : std::fopen(path.c_str(), "rb");
+    if (!file) {
+        std::cout << "Failed to open " << path << std::endl;
+        return false;
+    }
+    std::setvbuf(file, nullptr, _IOFBF, 1 << 20);
+
+    std::string header;
+    if (!readLine(file, header) || header.rfind("YUV4MPEG2", 0) != 0) {
+        std::cout << "ERROR::Y4M:: Missing YUV4MPEG2 signature in " << path << std::endl;
+        return false;
+    }
+
+    std::istringstream tokens(header.substr(9));
+    std::string token;
+    while (tokens >> token) {
+        std::string value = token.substr(1);
+        switch (token[0]) {
+            case 'W': width = std::stoi(value); break;
+            case 'H': height = std::stoi(value); break;
+            case 'F': frameRate = value; break;
+            case 'A': aspect = value; break;
+            case 'I': interlace = value; break;
+            case 'C':
+                if (value.rfind("420", 0) != 0 || value.find("p1") != std::string::npos) {
+                    std::cout << "ERROR::Y4M:: Unsupported colorspace C" << value << " (only 8-bit 4:2:0)" << std::endl;
+                    return false;
+                }
+                break;
+            default: break;
+        }
+    }
+    return width > 0 && height > 0;
+}
+
+bool Y4mReader::readFrame(YuvFrame &frame) {
+    std::string line;
+    if (!readLine(file, line) || line.rfind("FRAME", 0) != 0)
+        return false;
+    frame.resize(width, height);
+    return readPlane(file, frame.y) && readPlane(file, frame.u) && readPlane(file, frame.v);
+}
+
+Y4mWriter::~Y4mWriter() {
+    if (file && file != stdout) std::fclose(file);
+    else if (file) std::fflush(file);
+}
+
+bool Y4mWriter::open(const std::string &path, int width, int height, const std::string &frameRate,
+                     const std::string &aspect, const std::string &interlace) {
+    file = path == "-" ? stdout : std::fopen(path.c_str(), "wb");
+    if (!file) {
+        std::cout << "Failed to open " << path << std::endl;
+        return false;
+    }
+    std::setvbuf(file, nullptr, _IOFBF, 1 << 20);
+    std::fprintf(file, "YUV4MPEG2 W%d H%d F%s I%s A%s C420jpeg\n", width, height, frameRate.c_str(),
+                 interlace.c_str(), aspect.c_str());
+    return true;
+}
+
+bool Y4mWriter::writeFrame(const YuvFrame &frame) {
+    std::fputs("FRAME\n", file);
+    std::fwrite(frame.y.data(), 1, frame.y.size(), file);
+    std::fwrite(frame.u.data(), 1, frame.u.size(), file);
+    std::fwrite(frame.v.data(), 1, frame.v.size(), file);
+    return !std::ferror(file);
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdio>
+#include <string>
+#include "Yuv.h"
+
+// YUV4MPEG2 stream reader, 8-bit 4:2:0 only (C420, C420jpeg, C420paldv, C420mpeg2).
+class Y4mReader {
+public:
+    ~Y4mReader();
+    bool open(const std::string &path);
+    // Resizes the frame as needed; returns false at end of stream.
+    bool readFrame(YuvFrame &frame);
+
+    int width = 0, height = 0;
+    std::string frameRate = "30:1", aspect = "1:1", interlace = "p";
+
+private:
+    FILE *file = nullptr;
+};
+
+class Y4mWriter {
+public:
+    ~Y4mWriter();
+    bool open(const std::string &path, int width, int height, const std::string &frameRate,
+              const std::string &aspect = "1:1", const std::string &interlace = "p");
+    bool writeFrame(const YuvFrame &frame);
+
+private:
+    FILE *file = nullptr;
+};
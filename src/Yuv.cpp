@@ -0,0 +1,144 @@
+#include "Yuv.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <functional>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define UPSCALER_SSE2 1
+#endif
+
+namespace {
+
+// 6-bit fixed point: R = yc*(Y-16) + rv*(V-128), G = yc*(Y-16) - gu*(U-128) - gv*(V-128), B = yc*(Y-16) + bu*(U-128)
+struct DecodeCoefficients { int yc, rv, gu, gv, bu; };
+// 8-bit fixed point forward transform
+struct EncodeCoefficients { int yr, yg, yb, ur, ug, ub, vr, vg, vb; };
+
+DecodeCoefficients decodeCoefficients(YuvMatrix matrix) {
+    if (matrix == YuvMatrix::BT601) return {75, 102, 25, 52, 129};
+    return {75, 115, 14, 34, 135};
+}
+
+EncodeCoefficients encodeCoefficients(YuvMatrix matrix) {
+    if (matrix == YuvMatrix::BT601) return {66, 129, 25, -38, -74, 112, 112, -94, -18};
+    return {47, 157, 16, -26, -87, 112, 112, -102, -10};
+}
+
+unsigned char clampByte(int v) {
+    return (unsigned char) std::clamp(v, 0, 255);
+}
+
+void decodeRow(const unsigned char *yRow, const unsigned char *uRow, const unsigned char *vRow,
+               unsigned char *out, int width, const DecodeCoefficients &k) {
+    int x = 0;
+#ifdef UPSCALER_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i y16 = _mm_set1_epi16(16), c128 = _mm_set1_epi16(128), round = _mm_set1_epi16(32);
+    const __m128i yc = _mm_set1_epi16((short) k.yc), rv = _mm_set1_epi16((short) k.rv);
+    const __m128i gu = _mm_set1_epi16((short) k.gu), gv = _mm_set1_epi16((short) k.gv), bu = _mm_set1_epi16((short) k.bu);
+    const __m128i alpha = _mm_set1_epi8((char) 0xFF);
+
+    // 16 pixels per iteration: 16 luma, 8 chroma pairs
+    for (; x + 16 <= width; x += 16) {
+        __m128i yv = _mm_loadu_si128((const __m128i *) (yRow + x));
+        __m128i uv8 = _mm_loadl_epi64((const __m128i *) (uRow + x / 2));
+        __m128i vv8 = _mm_loadl_epi64((const __m128i *) (vRow + x / 2));
+        // Duplicate each chroma sample horizontally
+        __m128i u2 = _mm_unpacklo_epi8(uv8, uv8), v2 = _mm_unpacklo_epi8(vv8, vv8);
+
+        __m128i rgbLoHi[2][3];
+        for (int half = 0; half < 2; half++) {
+            __m128i yw = half ? _mm_unpackhi_epi8(yv, zero) : _mm_unpacklo_epi8(yv, zero);
+            __m128i uw = half ? _mm_unpackhi_epi8(u2, zero) : _mm_unpacklo_epi8(u2, zero);
+            __m128i vw = half ? _mm_unpackhi_epi8(v2, zero) : _mm_unpacklo_epi8(v2, zero);
+            yw = _mm_adds_epi16(_mm_mullo_epi16(_mm_sub_epi16(yw, y16), yc), round);
+            uw = _mm_sub_epi16(uw, c128);
+            vw = _mm_sub_epi16(vw, c128);
+
+            __m128i r = _mm_adds_epi16(yw, _mm_mullo_epi16(vw, rv));
+            __m128i g = _mm_subs_epi16(_mm_subs_epi16(yw, _mm_mullo_epi16(uw, gu)), _mm_mullo_epi16(vw, gv));
+            __m128i b = _mm_adds_epi16(yw, _mm_mullo_epi16(uw, bu));
+            rgbLoHi[half][0] = _mm_srai_epi16(r, 6);
+            rgbLoHi[half][1] = _mm_srai_epi16(g, 6);
+            rgbLoHi[half][2] = _mm_srai_epi16(b, 6);
+        }
+
+        __m128i r = _mm_packus_epi16(rgbLoHi[0][0], rgbLoHi[1][0]);
+        __m128i g = _mm_packus_epi16(rgbLoHi[0][1], rgbLoHi[1][1]);
+        __m128i b = _mm_packus_epi16(rgbLoHi[0][2], rgbLoHi[1][2]);
+
+        // Interleave to RGBA
+        __m128i rg0 = _mm_unpacklo_epi8(r, g), rg1 = _mm_unpackhi_epi8(r, g);
+        __m128i ba0 = _mm_unpacklo_epi8(b, alpha), ba1 = _mm_unpackhi_epi8(b, alpha);
+        _mm_storeu_si128((__m128i *) (out + x * 4), _mm_unpacklo_epi16(rg0, ba0));
+        _mm_storeu_si128((__m128i *) (out + x * 4 + 16), _mm_unpackhi_epi16(rg0, ba0));
+        _mm_storeu_si128((__m128i *) (out + x * 4 + 32), _mm_unpacklo_epi16(rg1, ba1));
+        _mm_storeu_si128((__m128i *) (out + x * 4 + 48), _mm_unpackhi_epi16(rg1, ba1));
+    }
+#endif
+    for (; x < width; x++) {
+        int yy = k.yc * (yRow[x] - 16) + 32;
+        int u = uRow[x / 2] - 128, v = vRow[x / 2] - 128;
+        out[x * 4 + 0] = clampByte((yy + k.rv * v) >> 6);
+        out[x * 4 + 1] = clampByte((yy - k.gu * u - k.gv * v) >> 6);
+        out[x * 4 + 2] = clampByte((yy + k.bu * u) >> 6);
+        out[x * 4 + 3] = 255;
+    }
+}
+
+void forRows(int rows, ThreadPool *pool, const std::function<void(int, int)> &fn) {
+    if (pool)
+        pool->parallelFor(rows, fn);
+    else
+        fn(0, rows);
+}
+
+}
+
+void yuv420ToRgba(const YuvFrame &frame, Image &rgba, YuvMatrix matrix, ThreadPool *pool) {
+    DecodeCoefficients k = decodeCoefficients(matrix);
+    int cw = frame.chromaWidth();
+    forRows(frame.height, pool, [&](int begin, int end) {
+        for (int y = begin; y < end; y++) {
+            decodeRow(frame.y.data() + (size_t) y * frame.width,
+                      frame.u.data() + (size_t) (y / 2) * cw,
+                      frame.v.data() + (size_t) (y / 2) * cw,
+                      rgba.row(y), frame.width, k);
+        }
+    });
+}
+
+void rgbaToYuv420(const Image &rgba, YuvFrame &frame, YuvMatrix matrix, ThreadPool *pool) {
+    EncodeCoefficients k = encodeCoefficients(matrix);
+    int cw = frame.chromaWidth();
+
+    // Each task owns a pair of luma rows and the chroma row they share
+    forRows(frame.chromaHeight(), pool, [&](int begin, int end) {
+        for (int cy = begin; cy < end; cy++) {
+            int y0 = cy * 2, y1 = std::min(y0 + 1, frame.height - 1);
+            const unsigned char *rows[2] = {rgba.row(y0), rgba.row(y1)};
+
+            for (int r = 0; r < 2 && y0 + r < frame.height; r++) {
+                const unsigned char *in = rows[r];
+                unsigned char *out = frame.y.data() + (size_t) (y0 + r) * frame.width;
+                for (int x = 0; x < frame.width; x++) {
+                    const unsigned char *p = in + x * 4;
+                    out[x] = clampByte(((k.yr * p[0] + k.yg * p[1] + k.yb * p[2] + 128) >> 8) + 16);
+                }
+            }
+
+            unsigned char *uOut = frame.u.data() + (size_t) cy * cw;
+            unsigned char *vOut = frame.v.data() + (size_t) cy * cw;
+            for (int cx = 0; cx < cw; cx++) {
+                int x0 = cx * 2 * 4, x1 = std::min(cx * 2 + 1, frame.width - 1) * 4;
+                int sum[3];
+                for (int c = 0; c < 3; c++)
+                    sum[c] = rows[0][x0 + c] + rows[0][x1 + c] + rows[1][x0 + c] + rows[1][x1 + c];
+                // sum is 4x the average: fold the /4 into the shift
+                uOut[cx] = clampByte(((k.ur * sum[0] + k.ug * sum[1] + k.ub * sum[2] + 512) >> 10) + 128);
+                vOut[cx] = clampByte(((k.vr * sum[0] + k.vg * sum[1] + k.vb * sum[2] + 512) >> 10) + 128);
+            }
+        }
+    });
+}
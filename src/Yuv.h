@@ -0,0 +1,30 @@
+#pragma once
+#include <vector>
+#include "Image.h"
+
+class ThreadPool;
+
+// Planar 8-bit YUV 4:2:0; chroma planes are ceil(width/2) x ceil(height/2).
+struct YuvFrame {
+    int width = 0, height = 0;
+    std::vector<unsigned char> y, u, v;
+
+    int chromaWidth() const { return (width + 1) / 2; }
+    int chromaHeight() const { return (height + 1) / 2; }
+
+    void resize(int w, int h) {
+        width = w;
+        height = h;
+        y.resize((size_t) w * h);
+        u.resize((size_t) chromaWidth() * chromaHeight());
+        v.resize(u.size());
+    }
+};
+
+// Limited-range ("TV") coefficients, as used by Y4M content
+enum class YuvMatrix { BT601, BT709 };
+
+// Nearest chroma upsampling; SSE2 when available. rgba must already be sized.
+void yuv420ToRgba(const YuvFrame &frame, Image &rgba, YuvMatrix matrix, ThreadPool *pool = nullptr);
+// Chroma is computed from the 2x2 average. frame must already be sized.
+void rgbaToYuv420(const Image &rgba, YuvFrame &frame, YuvMatrix matrix, ThreadPool *pool = nullptr);
@@ -1,325 +1,505 @@
 #include "config.h"
 #include "Renderer.h"
+#include "CheckerboardRenderer.h"
+#include "CubeScene.h"
+#include "DemoConfig.h"
+#include "FoveatedUpscaler.h"
+#include "GlUpscalers.h"
+#include "GpuTimer.h"
+#include "GpuTrace.h"
+#include "TemporalUpscaler.h"
+#include "FrameCapture.h"
+#include "FrameStats.h"
+#include "GpuMemory.h"
 #include "Shader.h"
+#include "Tracing.h"
+#include "Upscaler.h"
+#ifndef _WIN32
+#include "TileViewer.h"
+#endif
 #include <imgui.h>
 #include <backends/imgui_impl_glfw.h>
 #include <backends/imgui_impl_opengl3.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
 #include <iostream>
+#include <memory>
+#include <thread>
 
-const unsigned int SCR_WIDTH = 800;
-const unsigned int SCR_HEIGHT = 600;
-const unsigned int FBO_WIDTH = 400;
-const unsigned int FBO_HEIGHT = 300;
+namespace {
 
-int main() {
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-    GLFWwindow *window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "FSR Demo", nullptr, nullptr);
-    glfwMakeContextCurrent(window);
-
-    if (!gladLoadGLLoader((GLADloadproc) glfwGetProcAddress)) {
-        std::cout << "Failed to initialize GLAD\n";
-        return -1;
-    }
-
-    // Query OpenGL version
-    const GLubyte* version = glGetString(GL_VERSION);
-    const GLubyte* renderer_ = glGetString(GL_RENDERER);
-    const GLubyte* vendor   = glGetString(GL_VENDOR);
-    const GLubyte* glslVersion = glGetString(GL_SHADING_LANGUAGE_VERSION);
-
-    std::cout << "OpenGL Version: " << version << std::endl;
-    std::cout << "GLSL Version: " << glslVersion << std::endl;
-    std::cout << "Renderer: " << renderer_ << std::endl;
-    std::cout << "Vendor: " << vendor << std::endl;
-
-    glEnable(GL_DEPTH_TEST);
-
-    // Setup ImGui
-    IMGUI_CHECKVERSION();
-    ImGui::CreateContext();
+// Everything that owns GL objects is a local here, so it is all released when this
+// returns, while the window's context is still current
+void runDemo(GLFWwindow *window, const DemoConfig &config) {
+    const int SCR_WIDTH = config.displayWidth, SCR_HEIGHT = config.displayHeight;
+    const int FBO_WIDTH = config.renderWidth, FBO_HEIGHT = config.renderHeight;
+    float sharpenSharpness = config.sharpenSharpness, easuSharpness = config.easuSharpness;
     ImGuiIO &io = ImGui::GetIO();
-    ImGui::StyleColorsDark();
-    ImGui_ImplGlfw_InitForOpenGL(window, true);
-    ImGui_ImplOpenGL3_Init("#version 330");
 
     // Renderer & FBO
     Renderer renderer;
     renderer.initQuad();
     renderer.initFBO(FBO_WIDTH, FBO_HEIGHT); // Render at lower resolution
 
-    // Shaders
-    Shader sceneShader("shaders/3d_vertex.txt", "shaders/3d_fragment.txt");
-    Shader nearestShader("shaders/vertex.txt", "shaders/fragment_upscale.txt");
-    Shader bilinearShader("shaders/vertex.txt", "shaders/fragment_upscale.txt");
-    Shader sharpenShader("shaders/vertex.txt", "shaders/fragment_sharpen.txt");
-    Shader easuShader("shaders/vertex.txt", "shaders/fragment_easu.txt");
-
-    nearestShader.use();
-    nearestShader.setInt("uTexture", 0);
-    bilinearShader.use();
-    bilinearShader.setInt("uTexture", 0);
-    sharpenShader.use();
-    sharpenShader.setInt("uTexture", 0);
-    easuShader.use();
-    easuShader.setInt("uTexture", 0);
-
-    // Cube setup
-    float cubeVertices[] = {
-        // positions          // texcoords
-        // Front face
-        -0.5f, -0.5f, 0.5f, 0.0f, 0.0f,
-        0.5f, -0.5f, 0.5f, 1.0f, 0.0f,
-        0.5f, 0.5f, 0.5f, 1.0f, 1.0f,
-        0.5f, 0.5f, 0.5f, 1.0f, 1.0f,
-        -0.5f, 0.5f, 0.5f, 0.0f, 1.0f,
-        -0.5f, -0.5f, 0.5f, 0.0f, 0.0f,
-
-        // Back face
-        -0.5f, -0.5f, -0.5f, 1.0f, 0.0f,
-        0.5f, -0.5f, -0.5f, 0.0f, 0.0f,
-        0.5f, 0.5f, -0.5f, 0.0f, 1.0f,
-        0.5f, 0.5f, -0.5f, 0.0f, 1.0f,
-        -0.5f, 0.5f, -0.5f, 1.0f, 1.0f,
-        -0.5f, -0.5f, -0.5f, 1.0f, 0.0f,
-
-        // Left face
-        -0.5f, -0.5f, -0.5f, 0.0f, 0.0f,
-        -0.5f, -0.5f, 0.5f, 1.0f, 0.0f,
-        -0.5f, 0.5f, 0.5f, 1.0f, 1.0f,
-        -0.5f, 0.5f, 0.5f, 1.0f, 1.0f,
-        -0.5f, 0.5f, -0.5f, 0.0f, 1.0f,
-        -0.5f, -0.5f, -0.5f, 0.0f, 0.0f,
-
-        // Right face
-        0.5f, -0.5f, -0.5f, 1.0f, 0.0f,
-        0.5f, -0.5f, 0.5f, 0.0f, 0.0f,
-        0.5f, 0.5f, 0.5f, 0.0f, 1.0f,
-        0.5f, 0.5f, 0.5f, 0.0f, 1.0f,
-        0.5f, 0.5f, -0.5f, 1.0f, 1.0f,
-        0.5f, -0.5f, -0.5f, 1.0f, 0.0f,
-
-        // Top face
-        -0.5f, 0.5f, -0.5f, 0.0f, 1.0f,
-        0.5f, 0.5f, -0.5f, 1.0f, 1.0f,
-        0.5f, 0.5f, 0.5f, 1.0f, 0.0f,
-        0.5f, 0.5f, 0.5f, 1.0f, 0.0f,
-        -0.5f, 0.5f, 0.5f, 0.0f, 0.0f,
-        -0.5f, 0.5f, -0.5f, 0.0f, 1.0f,
-
-        // Bottom face
-        -0.5f, -0.5f, -0.5f, 0.0f, 0.0f,
-        0.5f, -0.5f, -0.5f, 1.0f, 0.0f,
-        0.5f, -0.5f, 0.5f, 1.0f, 1.0f,
-        0.5f, -0.5f, 0.5f, 1.0f, 1.0f,
-        -0.5f, -0.5f, 0.5f, 0.0f, 1.0f,
-        -0.5f, -0.5f, -0.5f, 0.0f, 0.0f
+    // Frame capture (F12 toggles)
+    FrameCapture frameCapture;
+    int captureSource = 0; // 0 = upscaled output, 1 = low-res FBO
+    bool captureKeyDown = false;
+
+    // Every registered GL upscaler, low-res FBO to the window. The first four are modes 0-3;
+    // any registered after them become modes 8 and up.
+    registerGlUpscalers();
+    std::vector<std::unique_ptr<IUpscaler>> upscalers;
+    for (const std::string &name : upscalerNames(UpscalerBackend::Gl)) {
+        upscalers.push_back(createUpscaler(name, UpscalerBackend::Gl));
+        upscalers.back()->init(FBO_WIDTH, FBO_HEIGHT, SCR_WIDTH, SCR_HEIGHT);
+    }
+    // Checkerboard reconstructs at the low resolution and then upscales with EASU
+    auto upscalerForMode = [&](int m) -> IUpscaler * {
+        if (m == 6)
+            return upscalers[(int) UpscaleMode::Easu].get();
+        if (m <= 3)
+            return upscalers[m].get();
+        size_t extra = 4 + (size_t) (m - DEMO_MODE_COUNT);
+        return m >= DEMO_MODE_COUNT && extra < upscalers.size() ? upscalers[extra].get() : nullptr;
     };
 
+    CubeScene scene;
+
+    // Temporal mode: jittered low-res frames accumulated into a full-res history
+    TemporalUpscaler temporal;
+    temporal.resize(FBO_WIDTH, FBO_HEIGHT, SCR_WIDTH, SCR_HEIGHT);
+    Shader copyShader("shaders/vertex.txt", "shaders/fragment.txt");
+    copyShader.use();
+    copyShader.setInt("uTexture", 0);
+
+    // Checkerboard mode: half the low-res pixels shaded per frame, reconstructed, then EASU
+    CheckerboardRenderer checkerboard;
+    checkerboard.resize(FBO_WIDTH, FBO_HEIGHT);
+
+    // Foveated mode: EASU+RCAS only around the fovea (the mouse, or the screen centre)
+    FoveatedUpscaler foveated;
+    bool foveaFollowsMouse = true;
+    float foveaRadius = 0.2f, foveaBand = 0.1f; // fractions of the screen height
+    int foveaPeriphery = 1;                      // 0 = nearest, 1 = bilinear
+    int previousMode = -1;
+
+    GpuTimer gpuTimer;
+
+    // Chrome trace of the CPU and GPU spans (F11 starts/stops, or stops after traceFrameLimit frames)
+    GpuTrace gpuTrace;
+    traceSetThreadName("main");
+    bool traceKeyDown = false;
+    int traceFrameLimit = 300, traceFrames = 0, tracesWritten = 0;
+    auto toggleTrace = [&] {
+        if (traceActive()) {
+            std::filesystem::create_directories("traces");
+            char path[64];
+            std::snprintf(path, sizeof(path), "traces/trace_%03d.json", tracesWritten++);
+            traceStop(path);
+        } else {
+            traceFrames = 0;
+            traceStart();
+        }
+    };
 
-    unsigned int cubeVAO, cubeVBO;
-    glGenVertexArrays(1, &cubeVAO);
-    glGenBuffers(1, &cubeVBO);
-    glBindVertexArray(cubeVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(cubeVertices), cubeVertices, GL_STATIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void *) 0);
-    glEnableVertexAttribArray(0);
-
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void *) (3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-
-    glBindVertexArray(0);
-
-    unsigned int cubeTexture;
-    glGenTextures(1, &cubeTexture);
-    glBindTexture(GL_TEXTURE_2D, cubeTexture);
-
-    // Set parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    // Load image (e.g., using stb_image)
-    int width, height, nrChannels;
-    unsigned char *data = stbi_load("assets/low_res_image.png", &width, &height, &nrChannels, 0);
-    if (data) {
-        GLenum format = (nrChannels == 3) ? GL_RGB : GL_RGBA;
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-    } else {
-        std::cout << "Failed to load texture" << std::endl;
+    // Optional huge image (see tiletool pack) shown instead of the cube, upscaled tile
+    // by tile as it is panned: drag to pan, wheel to zoom
+    bool viewingImage = false;
+#ifndef _WIN32
+    std::unique_ptr<TileViewer> tileViewer;
+    if (!config.image.empty()) {
+        tileViewer = std::make_unique<TileViewer>(std::max(1u, std::thread::hardware_concurrency() - 1));
+        viewingImage = tileViewer->open(config.image);
     }
-    stbi_image_free(data);
+#endif
+
+    int mode = config.mode;
 
-    int mode = 0;
-    float fps = 0.0f;
-    float lastTime = glfwGetTime();
-    int nbFrames = 0;
+    // Every frame's CPU (frame-to-frame) and GPU time; the whole run goes to config.statsPath at exit
+    FrameStats frameStats;
+    FrameStats::Summary cpuStats, gpuStats;
+    double lastFrameTime = glfwGetTime();
+    // --benchmark: close after that many seconds and report the whole run
+    double benchmarkEnd = config.benchmarkSeconds > 0.0f ? lastFrameTime + config.benchmarkSeconds : 0.0;
 
     while (!glfwWindowShouldClose(window)) {
+        bool tracePressed = glfwGetKey(window, GLFW_KEY_F11) == GLFW_PRESS;
+        if (tracePressed && !traceKeyDown)
+            toggleTrace();
+        traceKeyDown = tracePressed;
+        if (traceActive() && traceFrameLimit > 0 && traceFrames++ == traceFrameLimit)
+            toggleTrace();
+        TRACE_ZONE("frame");
+
         // ---------------------------
-        // 1️⃣ Handle input & FPS
+        // 1️⃣ Handle input & frame times
         // ---------------------------
+        TraceZone inputZone("input");
         if (glfwGetKey(window, GLFW_KEY_1) == GLFW_PRESS) mode = 0;
         if (glfwGetKey(window, GLFW_KEY_2) == GLFW_PRESS) mode = 1;
         if (glfwGetKey(window, GLFW_KEY_3) == GLFW_PRESS) mode = 2;
         if (glfwGetKey(window, GLFW_KEY_4) == GLFW_PRESS) mode = 3;
 
-        float currentTime = glfwGetTime();
-        nbFrames++;
-        if (currentTime - lastTime >= 1.0f) {
-            fps = nbFrames / (currentTime - lastTime);
-            nbFrames = 0;
-            lastTime += 1.0f;
+        bool capturePressed = glfwGetKey(window, GLFW_KEY_F12) == GLFW_PRESS;
+        if (capturePressed && !captureKeyDown) {
+            if (frameCapture.active()) frameCapture.stop();
+            else frameCapture.start("captures", FrameCapture::Format::PNG);
         }
+        captureKeyDown = capturePressed;
+
+#ifndef _WIN32
+        if (viewingImage) {
+            // ImGui's IO still holds last frame's mouse state until NewFrame below
+            if (!io.WantCaptureMouse) {
+                if (ImGui::IsMouseDown(ImGuiMouseButton_Left))
+                    tileViewer->pan(io.MouseDelta.x, io.MouseDelta.y);
+                if (io.MouseWheel != 0.0f)
+                    tileViewer->zoomAt(std::pow(1.25, io.MouseWheel), io.MousePos.x, io.MousePos.y, SCR_WIDTH, SCR_HEIGHT);
+            }
+            float step = 10.0f;
+            if (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS) tileViewer->pan(step, 0);
+            if (glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS) tileViewer->pan(-step, 0);
+            if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS) tileViewer->pan(0, step);
+            if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS) tileViewer->pan(0, -step);
+        }
+#endif
+
+        // GpuTimer lags a few frames behind, which is fine for the distribution
+        double currentTime = glfwGetTime();
+        frameStats.record((float) ((currentTime - lastFrameTime) * 1000.0), (float) gpuTimer.lastMs);
+        frameStats.summarize(cpuStats, gpuStats);
+        lastFrameTime = currentTime;
+        if (benchmarkEnd > 0.0 && currentTime >= benchmarkEnd)
+            glfwSetWindowShouldClose(window, GLFW_TRUE);
+        inputZone.end();
 
-        // ---------------------------
-        // 2️⃣ Render cube to low-res FBO (only if mode != 4)
-        // ---------------------------
         // ---------------------------
         // 2️⃣ Render cube to low-res FBO (only if not native mode)
         // ---------------------------
-        if (mode != 4) {
+        gpuTimer.begin();
+        TraceZone sceneZone("scene pass");
+        gpuTrace.begin("scene pass");
+        float time = (float) glfwGetTime();
+        glm::mat4 model = scene.model(time), view = scene.view();
+        glm::mat4 lowResProjection = scene.projection(FBO_WIDTH / (float) FBO_HEIGHT);
+        if (mode == 5) {
+            if (previousMode != 5) {
+                temporal.reset();
+                scene.resetMotion();
+            }
+            temporal.nextFrame();
+        }
+        if (mode == 6) {
+            if (previousMode != 6) {
+                checkerboard.reset();
+                scene.resetMotion();
+            }
+            checkerboard.nextFrame();
+        }
+        if (mode != 4 && !viewingImage) {
             glBindFramebuffer(GL_FRAMEBUFFER, renderer.fbo);
             glEnable(GL_DEPTH_TEST);
             glViewport(0, 0, FBO_WIDTH, FBO_HEIGHT);
-            glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-            sceneShader.use();
-            sceneShader.setInt("uTexture", 0);
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, cubeTexture);
-
-            glm::mat4 model = glm::scale(glm::rotate(glm::mat4(1.0f),
-                                                     (float) glfwGetTime() / 10,
-                                                     glm::vec3(0, 1, 0)),
-                                         glm::vec3(2.0f));
-            glm::mat4 view = glm::lookAt(glm::vec3(0, 0, 4.0f),
-                                         glm::vec3(0, 0, 0),
-                                         glm::vec3(0, 1, 0));
-            glm::mat4 projection = glm::perspective(glm::radians(45.0f),
-                                                    FBO_WIDTH / (float) FBO_HEIGHT,
-                                                    0.1f, 100.0f);
-
-            sceneShader.setMat4("model", model);
-            sceneShader.setMat4("view", view);
-            sceneShader.setMat4("projection", projection);
-
-            glBindVertexArray(cubeVAO);
-            glDrawArrays(GL_TRIANGLES, 0, 36);
-            glBindVertexArray(0);
+            renderer.clearFBO(0.1f, 0.1f, 0.1f);
+            if (mode == 6)
+                checkerboard.beginScene();
+            scene.draw(model, view, lowResProjection,
+                       mode == 5 ? temporal.jitterProjection(lowResProjection) : lowResProjection);
+            if (mode == 5)
+                temporal.resolve(renderer.fboTextureLinear, renderer.fboVelocityTexture, renderer.fboDepthTexture);
+            if (mode == 6) {
+                checkerboard.endScene();
+                checkerboard.reconstruct(renderer.fboTextureLinear, renderer.fboVelocityTexture, renderer.fboDepthTexture);
+            }
 
             glBindFramebuffer(GL_FRAMEBUFFER, 0);
         }
+        previousMode = mode;
+        gpuTrace.end();
+        sceneZone.end();
 
         // ---------------------------
         // 3️⃣ Render fullscreen quad OR native cube
         // ---------------------------
+        TraceZone upscaleZone("upscale pass");
+        gpuTrace.begin("upscale pass");
         glDisable(GL_DEPTH_TEST);
         glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
         glClear(GL_COLOR_BUFFER_BIT);
 
-        if (mode == 4) {
+        if (viewingImage) {
+#ifndef _WIN32
+            // Tiles are upscaled on the CPU by the selected mode's registry upscaler (EASU for the
+            // scene-only modes); native shows source tiles
+            const char *tileUpscaler = mode <= 3 || mode >= DEMO_MODE_COUNT ? demoModeName(mode) : "easu";
+            tileViewer->draw(SCR_WIDTH, SCR_HEIGHT, tileUpscaler, mode == 2 ? sharpenSharpness : easuSharpness, mode != 4);
+#endif
+        } else if (mode == 4) {
             // Native render
             glEnable(GL_DEPTH_TEST);
+            glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
             glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-            sceneShader.use();
-            sceneShader.setInt("uTexture", 0);
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, cubeTexture);
-
-            glm::mat4 model = glm::scale(glm::rotate(glm::mat4(1.0f),
-                                                     (float) glfwGetTime() / 10,
-                                                     glm::vec3(0, 1, 0)),
-                                         glm::vec3(2.0f));
-            glm::mat4 view = glm::lookAt(glm::vec3(0, 0, 4.0f),
-                                         glm::vec3(0, 0, 0),
-                                         glm::vec3(0, 1, 0));
-            glm::mat4 projection = glm::perspective(glm::radians(45.0f),
-                                                    SCR_WIDTH / (float) SCR_HEIGHT,
-                                                    0.1f, 100.0f);
-
-            sceneShader.setMat4("model", model);
-            sceneShader.setMat4("view", view);
-            sceneShader.setMat4("projection", projection);
-
-            glBindVertexArray(cubeVAO);
-            glDrawArrays(GL_TRIANGLES, 0, 36);
-            glBindVertexArray(0);
-        } else {
-            // Upscaled FBO
-            switch (mode) {
-                case 0: nearestShader.use();
-                    glBindTexture(GL_TEXTURE_2D, renderer.fboTextureLinear);
-                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-                    break;
-                case 1: bilinearShader.use();
-                    glBindTexture(GL_TEXTURE_2D, renderer.fboTextureLinear);
-                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-                    break;
-                case 2: sharpenShader.use();
-                    glBindTexture(GL_TEXTURE_2D, renderer.fboTextureLinear);
-                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-                    sharpenShader.setFloat("uSharpness", 0.5f);
-                    break;
-                case 3: easuShader.use();
-                    glBindTexture(GL_TEXTURE_2D, renderer.fboTextureLinear);
-                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-                    easuShader.setVec2("uTexSize", glm::vec2(FBO_WIDTH, FBO_HEIGHT));
-                    easuShader.setVec2("uScreenSize", glm::vec2(SCR_WIDTH, SCR_HEIGHT));
-                    easuShader.setFloat("uSharpness", 0.2f);
-                    break;
+            scene.draw(model, view, scene.projection(SCR_WIDTH / (float) SCR_HEIGHT));
+        } else if (mode == 7) {
+            Fovea fovea;
+            fovea.x = SCR_WIDTH * 0.5f;
+            fovea.y = SCR_HEIGHT * 0.5f;
+            if (foveaFollowsMouse) {
+                double mouseX, mouseY;
+                glfwGetCursorPos(window, &mouseX, &mouseY);
+                fovea.x = (float) mouseX;
+                fovea.y = (float) (SCR_HEIGHT - mouseY);
             }
+            fovea.radius = foveaRadius * SCR_HEIGHT;
+            fovea.band = foveaBand * SCR_HEIGHT;
+            foveated.draw(renderer.fboTextureLinear, FBO_WIDTH, FBO_HEIGHT, SCR_WIDTH, SCR_HEIGHT, fovea,
+                          (UpscaleMode) foveaPeriphery, easuSharpness);
+        } else if (mode == 5) {
+            copyShader.use();
+            glBindTexture(GL_TEXTURE_2D, temporal.outputTexture());
             renderer.renderQuad();
+        } else if (IUpscaler *upscaler = upscalerForMode(mode)) {
+            // Sharpen has its own strength; EASU and everything after it share the RCAS one
+            upscaler->sharpness = mode == 2 ? sharpenSharpness : easuSharpness;
+            upscaler->render(mode == 6 ? checkerboard.outputTexture() : renderer.fboTextureLinear, 0);
         }
 
+        gpuTrace.end();
+        upscaleZone.end();
+        gpuTimer.end();
+
+        // Read back before the overlay is drawn so captures don't include ImGui
+        TraceZone captureZone("capture");
+        if (captureSource == 0)
+            frameCapture.capture(0, GL_BACK, SCR_WIDTH, SCR_HEIGHT);
+        else
+            frameCapture.capture(renderer.fbo, GL_COLOR_ATTACHMENT0, FBO_WIDTH, FBO_HEIGHT);
+        captureZone.end();
 
         glEnable(GL_DEPTH_TEST);
 
         // ---------------------------
         // 4️⃣ Render ImGui overlay
         // ---------------------------
+        TraceZone imguiZone("imgui");
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
 
         ImGui::Begin("Info");
-        ImGui::Text("FPS: %.1f", fps);
-        ImGui::Text("Mode: %d", mode);
+        ImGui::Text("Frame (last %d): p50 %.2f ms (%.0f FPS)  p95 %.2f  p99 %.2f  max %.2f", frameStats.count,
+                    cpuStats.p50, cpuStats.p50 > 0.0f ? 1000.0f / cpuStats.p50 : 0.0f, cpuStats.p95, cpuStats.p99,
+                    cpuStats.max);
+        ImGui::Text("GPU (scene + upscale): p50 %.2f ms  p95 %.2f  p99 %.2f  max %.2f", gpuStats.p50, gpuStats.p95,
+                    gpuStats.p99, gpuStats.max);
+        float graphMax = std::max(cpuStats.max, 1000.0f / 60.0f);
+        ImGui::PlotLines("Frame ms", frameStats.cpuRing, frameStats.count, frameStats.ringStart(), nullptr, 0.0f,
+                         graphMax, ImVec2(0, 60));
+        ImGui::PlotLines("GPU ms", frameStats.gpuRing, frameStats.count, frameStats.ringStart(), nullptr, 0.0f,
+                         graphMax, ImVec2(0, 40));
+        // Whole-run histogram, 0.25 ms buckets up to twice the rolling p99
+        int buckets = std::clamp((int) (cpuStats.p99 * 2.0f / FrameStats::BUCKET_MS) + 1, 1, FrameStats::BUCKETS);
+        ImGui::PlotHistogram("Frame histogram", [](void *data, int i) {
+            return (float) ((const uint32_t *) data)[i];
+        }, frameStats.cpuHistogram, buckets, 0, nullptr, 0.0f, FLT_MAX, ImVec2(0, 60));
+        ImGui::Text("Mode: %d (%s)  Render %dx%d -> %dx%d (%.2fx)", mode, demoModeName(mode), FBO_WIDTH, FBO_HEIGHT,
+                    SCR_WIDTH, SCR_HEIGHT, SCR_WIDTH / (float) FBO_WIDTH);
         ImGui::Text("Toggle mode:");
         if (ImGui::Button("Nearest")) mode = 0;
         if (ImGui::Button("Bilinear")) mode = 1;
         if (ImGui::Button("Sharpen")) mode = 2;
         if (ImGui::Button("EASU+RCAS")) mode = 3;
         if (ImGui::Button("Native High-Res")) mode = 4;
+        if (ImGui::Button("Temporal (TAAU)")) mode = 5;
+        if (ImGui::Button("Checkerboard + EASU")) mode = 6;
+        if (ImGui::Button("Foveated EASU")) mode = 7;
+        for (size_t i = 4; i < upscalers.size(); i++) {
+            if (ImGui::Button(upscalers[i]->name()))
+                mode = DEMO_MODE_COUNT + (int) (i - 4);
+        }
+        if (mode == 2)
+            ImGui::SliderFloat("Sharpness", &sharpenSharpness, 0.0f, 1.0f);
+        if (mode == 3 || mode >= 6)
+            ImGui::SliderFloat("RCAS sharpness", &easuSharpness, 0.0f, 1.0f);
+
+        if (mode == 7) {
+            ImGui::Separator();
+            ImGui::Checkbox("Fovea follows mouse", &foveaFollowsMouse);
+            ImGui::SliderFloat("Radius", &foveaRadius, 0.0f, 1.0f);
+            ImGui::SliderFloat("Blend band", &foveaBand, 0.0f, 0.5f);
+            ImGui::RadioButton("Nearest periphery", &foveaPeriphery, 0);
+            ImGui::SameLine();
+            ImGui::RadioButton("Bilinear periphery", &foveaPeriphery, 1);
+            ImGui::Text("EASU+RCAS on %.1f%% of the output (%zu rects), %.1f%% of its cost saved",
+                        foveated.fullFraction * 100.0, foveated.fullRects.size(), (1.0 - foveated.fullFraction) * 100.0);
+        }
+
+#ifndef _WIN32
+        if (tileViewer && tileViewer->isOpen()) {
+            ImGui::Separator();
+            ImGui::Checkbox("Show tiled image", &viewingImage);
+            if (viewingImage) {
+                double mb = tileViewer->tileBytes() / (1024.0 * 1024.0);
+                ImGui::Text("Zoom: %.2fx  Level: %dx", tileViewer->zoom, tileViewer->level);
+                ImGui::Text("Visible: %d  GPU hits: %d  Fallback: %d", tileViewer->visibleTiles, tileViewer->gpuHits,
+                            tileViewer->fallbackTiles);
+                ImGui::Text("Uploads: %d (+%d prefetched)", tileViewer->uploads, tileViewer->prefetchUploads);
+                ImGui::Text("RAM tier: %zu tiles (%.0f MB)", tileViewer->cpuTiles(), tileViewer->cpuTiles() * mb);
+                ImGui::Text("GPU tier: %zu tiles (%.0f MB)", tileViewer->gpuTiles(), tileViewer->gpuTiles() * mb);
+                uint64_t upscaled = tileViewer->tilesUpscaled;
+                ImGui::Text("Upscaled: %llu tiles, %.2f ms each", (unsigned long long) upscaled,
+                            upscaled ? tileViewer->upscaleMs / upscaled : 0.0);
+                ImGui::Text("Draw: %.2f ms", tileViewer->drawMs);
+            }
+        }
+#endif
+
+        ImGui::Separator();
+        ImGui::RadioButton("Capture output", &captureSource, 0);
+        ImGui::SameLine();
+        ImGui::RadioButton("Capture low-res", &captureSource, 1);
+        if (ImGui::Button(frameCapture.active() ? "Stop capture (F12)" : "Start capture (F12)")) {
+            if (frameCapture.active()) frameCapture.stop();
+            else frameCapture.start("captures", FrameCapture::Format::PNG);
+        }
+        if (frameCapture.active()) {
+            ImGui::Text("Written: %d  Dropped: %d", frameCapture.framesWritten(), frameCapture.framesDropped);
+            ImGui::Text("Map + copy: %.2f ms", frameCapture.lastMapMs);
+        }
+
+        ImGui::Separator();
+        const GpuMemoryStats &gpuMemory = gpuMemoryStats();
+        ImGui::Text("GPU memory: %.1f MB (high-water %.1f MB), %d allocations", gpuMemory.totalBytes / 1048576.0,
+                    gpuMemory.totalHighWater / 1048576.0, gpuMemory.allocations);
+        if (ImGui::TreeNode("GPU memory breakdown")) {
+            for (int c = 0; c < (int) GpuMemoryCategory::Count; c++)
+                ImGui::Text("%s: %.1f MB (high-water %.1f MB)", gpuMemoryCategoryName((GpuMemoryCategory) c),
+                            gpuMemory.bytes[c] / 1048576.0, gpuMemory.highWater[c] / 1048576.0);
+            gpuMemoryForEachLabel([](const char *label, GpuMemoryCategory category, size_t bytes, int allocations) {
+                ImGui::BulletText("%s (%s): %.2f MB in %d", label, gpuMemoryCategoryName(category), bytes / 1048576.0,
+                                  allocations);
+            });
+            ImGui::TreePop();
+        }
+
+        ImGui::Separator();
+        ImGui::InputInt("Trace frames (0 = until stopped)", &traceFrameLimit);
+        traceFrameLimit = std::max(0, traceFrameLimit);
+        if (ImGui::Button(traceActive() ? "Stop trace (F11)" : "Record trace (F11)"))
+            toggleTrace();
+        if (traceActive())
+            ImGui::Text("Tracing: %d frames", traceFrames);
+        else if (tracesWritten > 0)
+            ImGui::Text("Last trace: traces/trace_%03d.json", tracesWritten - 1);
         ImGui::End();
 
         ImGui::Render();
+        gpuTrace.begin("imgui");
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        gpuTrace.end();
+        imguiZone.end();
 
         // ---------------------------
         // 5️⃣ Swap buffers / poll events
         // ---------------------------
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        {
+            TRACE_ZONE("swap");
+            glfwSwapBuffers(window);
+        }
+        {
+            TRACE_ZONE("poll events");
+            glfwPollEvents();
+        }
+        gpuTrace.collect();
+    }
+
+    frameCapture.stop();
+    frameStats.writeCsv(config.statsPath);
+    if (benchmarkEnd > 0.0) {
+        FrameStats::Summary cpu = frameStats.runSummary(false), gpu = frameStats.runSummary(true);
+        std::cout << "Benchmark: " << demoModeName(config.mode) << " " << FBO_WIDTH << "x" << FBO_HEIGHT << " -> "
+                  << SCR_WIDTH << "x" << SCR_HEIGHT << ", " << frameStats.frames << " frames\n"
+                  << "  frame ms: p50 " << cpu.p50 << "  p95 " << cpu.p95 << "  p99 " << cpu.p99 << "  max " << cpu.max
+                  << "\n  GPU ms:   p50 " << gpu.p50 << "  p95 " << gpu.p95 << "  p99 " << gpu.p99 << "  max " << gpu.max
+                  << "\n  written to " << config.statsPath << std::endl;
     }
+    upscalers.clear();
+    renderer.releaseFBO();
+    renderer.releaseQuad();
+    if (traceActive())
+        toggleTrace();
+#ifndef _WIN32
+    tileViewer.reset();
+#endif
+}
+
+}
+
+int main(int argc, char **argv) {
+    // Resolutions, mode, sharpness and benchmark length (see DemoConfig.h)
+    DemoConfig config;
+    if (!parseDemoArgs(config, argc, argv)) {
+        printDemoUsage();
+        return 1;
+    }
+    config.resolveRenderSize();
+    std::cout << "Rendering at " << config.renderWidth << "x" << config.renderHeight << ", displaying at "
+              << config.displayWidth << "x" << config.displayHeight << ", mode " << demoModeName(config.mode) << std::endl;
+
+    // Shaders and assets are loaded relative to the data directory; paths given on the
+    // command line stay relative to where the demo was started
+    if (!config.dataDir.empty()) {
+        if (!config.image.empty())
+            config.image = std::filesystem::absolute(config.image).string();
+        config.statsPath = std::filesystem::absolute(config.statsPath).string();
+        std::error_code error;
+        std::filesystem::current_path(config.dataDir, error);
+        if (error) {
+            std::cout << "ERROR::CONFIG:: Could not enter data directory " << config.dataDir << std::endl;
+            return 1;
+        }
+    }
+
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    GLFWwindow *window = glfwCreateWindow(config.displayWidth, config.displayHeight, "FSR Demo", nullptr, nullptr);
+    glfwMakeContextCurrent(window);
+
+    if (!gladLoadGLLoader((GLADloadproc) glfwGetProcAddress)) {
+        std::cout << "Failed to initialize GLAD\n";
+        return -1;
+    }
+
+    // Query OpenGL version
+    const GLubyte* version = glGetString(GL_VERSION);
+    const GLubyte* renderer_ = glGetString(GL_RENDERER);
+    const GLubyte* vendor   = glGetString(GL_VENDOR);
+    const GLubyte* glslVersion = glGetString(GL_SHADING_LANGUAGE_VERSION);
+
+    std::cout << "OpenGL Version: " << version << std::endl;
+    std::cout << "GLSL Version: " << glslVersion << std::endl;
+    std::cout << "Renderer: " << renderer_ << std::endl;
+    std::cout << "Vendor: " << vendor << std::endl;
+
+    glEnable(GL_DEPTH_TEST);
+
+    // Setup ImGui
+    IMGUI_CHECKVERSION();
+    ImGui::CreateContext();
+    ImGui::StyleColorsDark();
+    ImGui_ImplGlfw_InitForOpenGL(window, true);
+    ImGui_ImplOpenGL3_Init("#version 330");
 
+    runDemo(window, config);
+    // Every GL owner is gone by now, so anything still registered really leaked
+    gpuMemoryPrintReport();
 
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
@@ -0,0 +1,237 @@
+// Upscales directories of images to PNG.
+//
+// Files move through three stages in chunks: a reader thread loads a whole chunk
+// with BatchFileIo (io_uring when available), the main thread decodes, upscales
+// and PNG-encodes the chunk in memory across the pool (one file per task, since
+// the images are small), and a writer thread stores the encoded files in one
+// batch. Reading, compute and writing of neighbouring chunks overlap; --trace writes
+// a Chrome trace of every stage and worker to check that they do.
+//
+// Each output is named after its input's stem. When two inputs share a stem
+// (a/img.png and b/img.jpg) the later one in sorted order gets a numbered name
+// (img-1.png), so nothing is overwritten.
+//
+//   batchupscale [--scale F] [--mode nearest|bilinear|sharpen|easu|rcas|catmull-rom|mitchell|lanczos2|lanczos3]
+//                [--sharpness S] [--threads N] [--chunk N] [--queue-depth N] [--no-uring]
+//                [--trace trace.json] -o outdir (dir | image)...
+
+#include "BatchFileIo.h"
+#include "BoundedQueue.h"
+#include "ThreadPool.h"
+#include "Tracing.h"
+#include "Upscaler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+bool isImageFile(const fs::path &path) {
+    std::string ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return (char) std::tolower(c); });
+    return ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".bmp" || ext == ".tga" || ext == ".gif" ||
+           ext == ".psd" || ext == ".hdr" || ext == ".pic" || ext == ".pnm" || ext == ".ppm" || ext == ".pgm";
+}
+
+// One output name per input, unique within the output directory
+std::vector<std::string> outputNames(const std::vector<std::string> &files) {
+    std::vector<std::string> names;
+    std::set<std::string> taken;
+    for (const std::string &file : files) {
+        std::string stem = fs::path(file).stem().string(), name = stem + ".png";
+        for (int n = 1; !taken.insert(name).second; n++)
+            name = stem + "-" + std::to_string(n) + ".png";
+        if (name != stem + ".png")
+            std::cerr << file << ": another input is also named " << stem << ", writing " << name << std::endl;
+        names.push_back(name);
+    }
+    return names;
+}
+
+double msSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+void printUsage() {
+    std::cerr << "Usage: batchupscale [--scale F]\n"
+                 "                    [--mode nearest|bilinear|sharpen|easu|rcas|catmull-rom|mitchell|lanczos2|lanczos3]\n"
+                 "                    [--sharpness S] [--threads N] [--chunk N] [--queue-depth N] [--no-uring] [--trace trace.json]\n"
+                 "                    -o outdir (dir | image)..."
+              << std::endl;
+}
+
+}
+
+int main(int argc, char **argv) {
+    float scale = 2.0f, sharpness = -1.0f;
+    std::string mode = "easu";
+    unsigned int threads = std::thread::hardware_concurrency(), queueDepth = 64;
+    size_t chunkSize = 256;
+    bool allowUring = true;
+    fs::path outDir;
+    std::string tracePath;
+    std::vector<std::string> inputs;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--scale" && i + 1 < argc) scale = std::stof(argv[++i]);
+        else if (arg == "--mode" && i + 1 < argc) {
+            mode = argv[++i];
+            if (!hasUpscaler(mode, UpscalerBackend::Cpu)) { printUsage(); return 1; }
+        }
+        else if (arg == "--sharpness" && i + 1 < argc) sharpness = std::stof(argv[++i]);
+        else if (arg == "--threads" && i + 1 < argc) threads = (unsigned int) std::stoi(argv[++i]);
+        else if (arg == "--chunk" && i + 1 < argc) chunkSize = (size_t) std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--queue-depth" && i + 1 < argc) queueDepth = (unsigned int) std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--no-uring") allowUring = false;
+        else if (arg == "--trace" && i + 1 < argc) tracePath = argv[++i];
+        else if (arg == "-o" && i + 1 < argc) outDir = argv[++i];
+        else inputs.push_back(arg);
+    }
+    if (inputs.empty() || outDir.empty()) {
+        printUsage();
+        return 1;
+    }
+    std::vector<std::string> files;
+    for (const std::string &input : inputs) {
+        std::error_code error;
+        if (fs::is_directory(input, error)) {
+            for (const auto &entry : fs::directory_iterator(input, error))
+                if (entry.is_regular_file() && isImageFile(entry.path())) files.push_back(entry.path().string());
+        } else {
+            files.push_back(input);
+        }
+    }
+    std::sort(files.begin(), files.end());
+    files.erase(std::unique(files.begin(), files.end()), files.end());
+    std::vector<std::string> outputs = outputNames(files);
+    fs::create_directories(outDir);
+
+    struct Chunk {
+        size_t first = 0;
+        std::vector<FileRead> reads;
+        std::vector<FileWrite> writes;
+    };
+
+    BoundedQueue<Chunk> toProcess(2), toWrite(2);
+    std::atomic<uint64_t> readSyscalls = 0, writeSyscalls = 0, bytesRead = 0, bytesWritten = 0;
+    std::atomic<int> failures = 0, written = 0;
+    std::atomic<double> readMs = 0.0, writeMs = 0.0;
+    std::atomic<bool> usingUring = false;
+    if (!tracePath.empty()) {
+        traceSetThreadName("main (compute)");
+        traceStart();
+    }
+    auto start = Clock::now();
+
+    std::thread reader([&] {
+        traceSetThreadName("reader");
+        BatchFileIo io(queueDepth, allowUring);
+        usingUring = io.usingUring();
+        for (size_t first = 0; first < files.size(); first += chunkSize) {
+            Chunk chunk;
+            chunk.first = first;
+            for (size_t i = first; i < std::min(files.size(), first + chunkSize); i++)
+                chunk.reads.push_back({files[i], {}, false});
+            auto t = Clock::now();
+            {
+                TRACE_ZONE("read chunk");
+                io.readFiles(chunk.reads);
+            }
+            readMs = readMs + msSince(t);
+            for (const FileRead &read : chunk.reads)
+                bytesRead += read.data.size();
+            toProcess.push(std::move(chunk));
+        }
+        readSyscalls = io.syscalls;
+        toProcess.close();
+    });
+
+    std::thread writer([&] {
+        traceSetThreadName("writer");
+        BatchFileIo io(queueDepth, allowUring);
+        while (auto chunk = toWrite.pop()) {
+            auto t = Clock::now();
+            TraceZone writeZone("write chunk");
+            io.writeFiles(chunk->writes);
+            writeZone.end();
+            writeMs = writeMs + msSince(t);
+            for (const FileWrite &write : chunk->writes) {
+                if (write.ok) {
+                    written++;
+                    bytesWritten += write.data.size();
+                } else {
+                    failures++;
+                }
+            }
+        }
+        writeSyscalls = io.syscalls;
+    });
+
+    ThreadPool pool(threads);
+    double computeMs = 0.0;
+    while (auto chunk = toProcess.pop()) {
+        auto t = Clock::now();
+        TraceZone computeZone("compute chunk");
+        std::vector<FileWrite> writes(chunk->reads.size());
+        pool.parallelFor((int) chunk->reads.size(), [&](int begin, int end) {
+            Image src, dst;
+            std::unique_ptr<IUpscaler> upscaler = createUpscaler(mode, UpscalerBackend::Cpu);
+            if (sharpness >= 0.0f)
+                upscaler->sharpness = sharpness;
+            for (int i = begin; i < end; i++) {
+                const FileRead &read = chunk->reads[i];
+                writes[i].path = (outDir / outputs[chunk->first + i]).string();
+                TraceZone decodeZone("decode");
+                if (!read.ok || !decodeImage(read.data.data(), read.data.size(), src, 4, read.path))
+                    continue;
+                decodeZone.end();
+                int w = std::max(1, (int) (src.width * scale + 0.5f)), h = std::max(1, (int) (src.height * scale + 0.5f));
+                if (dst.width != w || dst.height != h)
+                    dst = Image(w, h, 4);
+                {
+                    TRACE_ZONE("upscale");
+                    upscaler->resize(src.width, src.height, w, h);
+                    upscaler->process(src, dst);
+                }
+                TRACE_ZONE("encode");
+                encodeImagePng(dst, writes[i].data);
+            }
+        });
+        computeZone.end();
+        computeMs += msSince(t);
+
+        // Files that failed to load or decode are left out of the write batch
+        Chunk out;
+        for (FileWrite &write : writes) {
+            if (write.data.empty()) failures++;
+            else out.writes.push_back(std::move(write));
+        }
+        toWrite.push(std::move(out));
+    }
+    toWrite.close();
+    reader.join();
+    writer.join();
+    if (!tracePath.empty())
+        traceStop(tracePath);
+
+    double totalMs = msSince(start);
+    std::cerr << written << " of " << files.size() << " files in " << totalMs / 1000.0 << " s ("
+              << (totalMs > 0 ? written * 1000.0 / totalMs : 0.0) << " files/s), " << failures << " failed, I/O via "
+              << (usingUring ? "io_uring" : "pread/pwrite") << std::endl;
+    std::cerr << "  read " << bytesRead / 1e6 << " MB in " << readMs / 1000.0 << " s with " << readSyscalls
+              << " syscalls; wrote " << bytesWritten / 1e6 << " MB in " << writeMs / 1000.0 << " s with "
+              << writeSyscalls << " syscalls; decode+upscale+encode " << computeMs / 1000.0 << " s" << std::endl;
+    return failures > 0 ? 1 : 0;
+}
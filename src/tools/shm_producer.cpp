@@ -0,0 +1,150 @@
+// Stand-in for a renderer process feeding upscaler_shm.
+//
+// Receives the two ring memfds, draws a moving test pattern directly into input
+// slots (optionally paced to --fps) and consumes the upscaled frames on a second
+// thread, measuring end-to-end latency from the timestamp that rides with each
+// frame. --socket-baseline also times pushing the same bytes through a socketpair,
+// which is what the rings replace.
+//
+//   shm_producer [--socket PATH] [--frames N] [--fps F] [--socket-baseline]
+
+#include "SharedFrameRing.h"
+#include "UpscaleProtocol.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+double percentile(const std::vector<double> &sorted, double p) {
+    if (sorted.empty())
+        return 0.0;
+    return sorted[std::min(sorted.size() - 1, (size_t) (p * (sorted.size() - 1) + 0.5))];
+}
+
+// Bands that scroll one step per frame, written row by row like a renderer would
+void drawFrame(unsigned char *pixels, int width, int height, uint64_t frame) {
+    for (int y = 0; y < height; y++) {
+        unsigned char *row = pixels + (size_t) y * width * 4;
+        std::memset(row, (int) ((y + frame * 4) & 255), (size_t) width * 4);
+        for (int x = (int) (frame % 64); x < width; x += 64)
+            row[x * 4] = 255;
+    }
+}
+
+// Milliseconds per frame to send `inBytes` one way and `outBytes` back over a socketpair
+double socketBaselineMs(size_t inBytes, size_t outBytes, int frames) {
+    int pair[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0)
+        return 0.0;
+    std::vector<unsigned char> in(inBytes, 1), out(outBytes, 2);
+
+    std::thread peer([&] {
+        std::vector<unsigned char> inCopy(inBytes), outCopy(outBytes, 3);
+        for (int i = 0; i < frames; i++) {
+            if (!readFully(pair[1], inCopy.data(), inBytes) || !writeFully(pair[1], outCopy.data(), outBytes))
+                break;
+        }
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; i++) {
+        if (!writeFully(pair[0], in.data(), inBytes) || !readFully(pair[0], out.data(), outBytes))
+            break;
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    peer.join();
+    close(pair[0]);
+    close(pair[1]);
+    return ms / frames;
+}
+
+void printUsage() {
+    std::cerr << "Usage: shm_producer [--socket PATH] [--frames N] [--fps F] [--socket-baseline]" << std::endl;
+}
+
+}
+
+int main(int argc, char **argv) {
+    std::string socketPath = "/tmp/upscaler_shm.sock";
+    int frames = 300;
+    double fps = 0.0;
+    bool baseline = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc) socketPath = argv[++i];
+        else if (arg == "--frames" && i + 1 < argc) frames = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--fps" && i + 1 < argc) fps = std::stod(argv[++i]);
+        else if (arg == "--socket-baseline") baseline = true;
+        else { printUsage(); return 1; }
+    }
+
+    int connection = connectUnixSocket(socketPath);
+    if (connection < 0)
+        return 1;
+    int fds[2];
+    if (receiveFds(connection, fds, 2) != 2) {
+        std::cerr << "Did not receive the ring descriptors" << std::endl;
+        return 1;
+    }
+    SharedFrameRing input, output;
+    if (!input.attach(fds[0]) || !output.attach(fds[1]))
+        return 1;
+
+    std::vector<double> latencies;
+    latencies.reserve(frames);
+    uint64_t checksum = 0;
+    std::thread consumer([&] {
+        SharedFrameInfo info;
+        while ((int) latencies.size() < frames) {
+            const unsigned char *pixels = output.acquireRead(info);
+            if (!pixels)
+                break;
+            latencies.push_back((SharedFrameRing::nowNs() - info.timestampNs) / 1e6);
+            checksum += pixels[output.frameBytes() / 2];
+            output.releaseRead();
+        }
+    });
+
+    uint64_t waitNs = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; i++) {
+        if (fps > 0.0)
+            std::this_thread::sleep_until(start + std::chrono::duration<double>(i / fps));
+
+        uint64_t t = SharedFrameRing::nowNs();
+        unsigned char *pixels = input.acquireWrite();
+        waitNs += SharedFrameRing::nowNs() - t;
+        if (!pixels)
+            break;
+        drawFrame(pixels, input.width(), input.height(), (uint64_t) i);
+        input.commitWrite({(uint64_t) i, SharedFrameRing::nowNs()});
+    }
+    consumer.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    input.close();
+    close(connection);
+
+    std::sort(latencies.begin(), latencies.end());
+    std::cout << input.width() << "x" << input.height() << " -> " << output.width() << "x" << output.height() << ": "
+              << latencies.size() << " frames in " << seconds << " s, " << latencies.size() / seconds << " fps"
+              << std::endl;
+    std::cout << "  latency ms: p50 " << percentile(latencies, 0.5) << ", p95 " << percentile(latencies, 0.95)
+              << ", p99 " << percentile(latencies, 0.99) << ", max " << (latencies.empty() ? 0.0 : latencies.back())
+              << std::endl;
+    std::cout << "  producer blocked on a full ring " << waitNs / 1e6 / frames << " ms/frame (checksum " << checksum
+              << ")" << std::endl;
+    if (baseline) {
+        std::cout << "  socketpair copy of the same frames: "
+                  << socketBaselineMs(input.frameBytes(), output.frameBytes(), std::min(frames, 100))
+                  << " ms/frame" << std::endl;
+    }
+    return 0;
+}
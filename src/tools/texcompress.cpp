@@ -0,0 +1,95 @@
+// Offline BC1/BC3/BC7 encoder: converts PNG/JPG assets into mipmapped KTX2 files
+// that TextureLoader can upload without any runtime encoding.
+//
+//   texcompress [--format bc1|bc3|bc7] [--threads N] [--no-mips] [-o outdir] image...
+
+#include "BlockCompression.h"
+#include "Image.h"
+#include "Ktx2.h"
+#include "ThreadPool.h"
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static void printUsage() {
+    std::cout << "Usage: texcompress [--format bc1|bc3|bc7] [--threads N] [--no-mips] [-o outdir] image..." << std::endl;
+}
+
+int main(int argc, char **argv) {
+    BlockFormat format = BlockFormat::BC7;
+    unsigned int threads = std::thread::hardware_concurrency();
+    bool mips = true;
+    std::string outDir;
+    std::vector<std::string> inputs;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--format" && i + 1 < argc) {
+            std::string name = argv[++i];
+            if (name == "bc1") format = BlockFormat::BC1;
+            else if (name == "bc3") format = BlockFormat::BC3;
+            else if (name == "bc7") format = BlockFormat::BC7;
+            else { printUsage(); return 1; }
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = (unsigned int) std::stoi(argv[++i]);
+        } else if (arg == "--no-mips") {
+            mips = false;
+        } else if (arg == "-o" && i + 1 < argc) {
+            outDir = argv[++i];
+        } else if (arg == "-h" || arg == "--help") {
+            printUsage();
+            return 0;
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+    if (inputs.empty()) {
+        printUsage();
+        return 1;
+    }
+
+    ThreadPool pool(threads);
+    int failures = 0;
+
+    for (const std::string &input : inputs) {
+        auto start = std::chrono::steady_clock::now();
+
+        Image image;
+        if (!loadImage(input, image, 4)) {
+            failures++;
+            continue;
+        }
+
+        Ktx2Texture ktx;
+        ktx.vkFormat = vkFormatFromBlock(format);
+        ktx.width = image.width;
+        ktx.height = image.height;
+
+        Image level = image;
+        while (true) {
+            ktx.levels.push_back(compressImage(level.pixels.data(), level.width, level.height, format, &pool));
+            if (!mips || (level.width == 1 && level.height == 1))
+                break;
+            level = downsampleImage(level);
+        }
+
+        std::filesystem::path outPath = std::filesystem::path(input).replace_extension(".ktx2");
+        if (!outDir.empty())
+            outPath = std::filesystem::path(outDir) / outPath.filename();
+
+        if (!saveKtx2(outPath.string(), ktx)) {
+            std::cout << "Failed to write " << outPath << std::endl;
+            failures++;
+            continue;
+        }
+
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << input << " -> " << outPath.string() << " (" << blockFormatName(format) << ", "
+                  << image.width << "x" << image.height << ", " << ktx.levels.size() << " levels, "
+                  << ms << " ms)" << std::endl;
+    }
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,210 @@
+// Converts between images and the mmapped tiled container, and upscales tiled
+// files (or a region of them) without decoding them as a whole.
+//
+//   tiletool pack [--tile N] input.png output.tiles
+//   tiletool unpack input.tiles output.png
+//   tiletool upscale [--scale F] [--mode nearest|bilinear|sharpen|easu] [--sharpness S]
+//                    [--region X,Y,W,H] [--threads N] input.tiles output.tiles
+//   tiletool info input.tiles
+//   tiletool check [--threads N]
+//
+// check is the regression test for the tiled path: it upscales synthetic images through
+// small tiles and from their exact source footprints, whole and by narrow regions, at
+// non-integer ratios, and exits 1 unless every mode matches the full-frame upscale byte
+// for byte.
+
+#include "TiledImage.h"
+#include "ThreadPool.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+void printUsage() {
+    std::cerr << "Usage: tiletool pack [--tile N] input.png output.tiles\n"
+                 "       tiletool unpack input.tiles output.png\n"
+                 "       tiletool upscale [--scale F] [--mode nearest|bilinear|sharpen|easu] [--sharpness S]\n"
+                 "                        [--region X,Y,W,H] [--threads N] input.tiles output.tiles\n"
+                 "       tiletool info input.tiles\n"
+                 "       tiletool check [--threads N]" << std::endl;
+}
+
+// Deterministic noise with hard edges, so every tap and Laplacian neighbour matters
+Image checkPattern(int width, int height) {
+    Image image(width, height, 4);
+    uint32_t state = 12345;
+    for (unsigned char &value : image.pixels) {
+        state = state * 1664525u + 1013904223u;
+        value = (unsigned char) (state >> 24);
+    }
+    return image;
+}
+
+// Upscales one synthetic image through tiles (whole and one region at a time) and from
+// exactly the source window upscaleFootprint gives each region, and compares every run
+// with the full-frame upscale; prints and returns the number of mismatching runs
+int checkTiled(const std::filesystem::path &dir, int width, int height, int outWidth, int outHeight, int tileSize,
+               ThreadPool &pool) {
+    Image source = checkPattern(width, height);
+    TiledImage src;
+    if (!src.create((dir / "src.tiles").string(), width, height, tileSize) || !imageToTiles(source, src))
+        return 1;
+
+    // Narrow column and row strips at both edges and in the middle, plus the whole image
+    const int regions[][4] = {{0, 0, outWidth, outHeight}, {0, 0, 2, outHeight}, {outWidth - 2, 0, outWidth, outHeight},
+                              {0, 0, outWidth, 2}, {0, outHeight - 2, outWidth, outHeight},
+                              {outWidth / 2 - 1, outHeight / 2 - 1, outWidth / 2 + 1, outHeight / 2 + 1}};
+    int failures = 0;
+    for (UpscaleMode mode : {UpscaleMode::Nearest, UpscaleMode::Bilinear, UpscaleMode::Sharpen, UpscaleMode::Easu}) {
+        float sharpness = mode == UpscaleMode::Easu ? 0.2f : 0.5f;
+        Image whole(outWidth, outHeight, 4);
+        upscaleImage(source, whole, mode, sharpness);
+        for (const int *r : regions) {
+            auto report = [&](const Image &out, const char *path) {
+                for (int y = r[1]; y < r[3]; y++) {
+                    if (std::memcmp(out.row(y) + (size_t) r[0] * 4, whole.row(y) + (size_t) r[0] * 4,
+                                    (size_t) (r[2] - r[0]) * 4) != 0) {
+                        std::cout << width << "x" << height << " -> " << outWidth << "x" << outHeight << ", "
+                                  << tileSize << "px tiles, " << upscaleModeName(mode) << ", region " << r[0] << ","
+                                  << r[1] << " - " << r[2] << "," << r[3] << ": FAIL, " << path
+                                  << " differs from the full frame" << std::endl;
+                        failures++;
+                        return;
+                    }
+                }
+            };
+
+            TiledImage dst;
+            if (!dst.create((dir / "dst.tiles").string(), outWidth, outHeight, tileSize))
+                return failures + 1;
+            upscaleTiled(src, dst, mode, sharpness, &pool, r[0], r[1], r[2], r[3]);
+            report(tilesToImage(dst), "tiled");
+
+            // A window sized exactly to the footprint, so reading past it is a heap overflow
+            int sx0, sy0, sx1, sy1;
+            upscaleFootprint(width, height, outWidth, outHeight, r[0], r[1], r[2], r[3], sx0, sy0, sx1, sy1);
+            std::vector<unsigned char> window((size_t) (sx1 - sx0) * (sy1 - sy0) * 4);
+            for (int y = sy0; y < sy1; y++)
+                std::memcpy(window.data() + (size_t) (y - sy0) * (sx1 - sx0) * 4, source.row(y) + (size_t) sx0 * 4,
+                            (size_t) (sx1 - sx0) * 4);
+            ImageView view(window.data(), width, height, (size_t) (sx1 - sx0) * 4);
+            view.originX = sx0;
+            view.originY = sy0;
+            Image windowed(outWidth, outHeight, 4);
+            upscaleRect(view, windowed, r[0], r[1], r[2], r[3], mode, sharpness);
+            report(windowed, "footprint window");
+        }
+    }
+    return failures;
+}
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        printUsage();
+        return 1;
+    }
+    std::string command = argv[1];
+    int tileSize = 256, threads = (int) std::thread::hardware_concurrency();
+    float scale = 2.0f, sharpness = -1.0f;
+    UpscaleMode mode = UpscaleMode::Easu;
+    int region[4] = {0, 0, -1, -1};
+    bool hasRegion = false;
+    std::vector<std::string> paths;
+
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--tile" && i + 1 < argc) tileSize = std::stoi(argv[++i]);
+        else if (arg == "--scale" && i + 1 < argc) scale = std::stof(argv[++i]);
+        else if (arg == "--mode" && i + 1 < argc) {
+            if (!parseUpscaleMode(argv[++i], mode)) { printUsage(); return 1; }
+        }
+        else if (arg == "--sharpness" && i + 1 < argc) sharpness = std::stof(argv[++i]);
+        else if (arg == "--threads" && i + 1 < argc) threads = std::stoi(argv[++i]);
+        else if (arg == "--region" && i + 1 < argc) {
+            hasRegion = std::sscanf(argv[++i], "%d,%d,%d,%d", &region[0], &region[1], &region[2], &region[3]) == 4;
+            if (!hasRegion) { printUsage(); return 1; }
+        }
+        else paths.push_back(arg);
+    }
+
+    if (command == "info" && paths.size() == 1) {
+        TiledImage tiles;
+        if (!tiles.open(paths[0]))
+            return 1;
+        std::cout << tiles.width << "x" << tiles.height << ", " << tiles.tileSize << "px tiles, " << tiles.tilesX << "x"
+                  << tiles.tilesY << " tiles" << std::endl;
+        return 0;
+    }
+
+    if (command == "check" && paths.empty()) {
+        std::filesystem::path dir = std::filesystem::temp_directory_path() / ("tiletool-check-" + std::to_string(getpid()));
+        std::filesystem::create_directories(dir);
+        ThreadPool pool((unsigned int) std::max(1, threads));
+        // Ratios just above 1, an odd fraction and a plain 2x, through tiles of 16 and 64
+        const int sizes[][4] = {{1000, 8, 1001, 16}, {1000, 40, 1001, 41}, {97, 61, 233, 150}, {160, 90, 320, 180}};
+        int failures = 0, runs = 0;
+        for (const int *size : sizes) {
+            for (int tile : {16, 64}) {
+                failures += checkTiled(dir, size[0], size[1], size[2], size[3], tile, pool);
+                runs += 4 * 6 * 2;
+            }
+        }
+        std::filesystem::remove_all(dir);
+        std::cout << runs - failures << "/" << runs << " tiled and windowed upscales match the full frame" << std::endl;
+        return failures > 0 ? 1 : 0;
+    }
+
+    if (command == "pack" && paths.size() == 2) {
+        Image image;
+        TiledImage tiles;
+        if (!loadImage(paths[0], image, 4) || !tiles.create(paths[1], image.width, image.height, tileSize) ||
+            !imageToTiles(image, tiles))
+            return 1;
+        return 0;
+    }
+
+    if (command == "unpack" && paths.size() == 2) {
+        TiledImage tiles;
+        if (!tiles.open(paths[0]) || !saveImagePng(paths[1], tilesToImage(tiles)))
+            return 1;
+        return 0;
+    }
+
+    if (command == "upscale" && paths.size() == 2) {
+        if (sharpness < 0.0f)
+            sharpness = mode == UpscaleMode::Easu ? 0.2f : 0.5f;
+        TiledImage src, dst;
+        if (!src.open(paths[0]))
+            return 1;
+        int outWidth = (int) (src.width * scale + 0.5f), outHeight = (int) (src.height * scale + 0.5f);
+
+        // A region only updates an existing output of the right size, so repeated runs fill it in
+        bool reuse = hasRegion && std::filesystem::exists(paths[1]) && dst.open(paths[1], true) &&
+                     dst.width == outWidth && dst.height == outHeight;
+        if (!reuse && !dst.create(paths[1], outWidth, outHeight, src.tileSize))
+            return 1;
+
+        ThreadPool pool((unsigned int) std::max(1, threads));
+        auto start = std::chrono::steady_clock::now();
+        if (hasRegion)
+            upscaleTiled(src, dst, mode, sharpness, &pool, region[0], region[1], region[0] + region[2], region[1] + region[3]);
+        else
+            upscaleTiled(src, dst, mode, sharpness, &pool);
+        dst.flush();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cerr << src.width << "x" << src.height << " -> " << outWidth << "x" << outHeight << " "
+                  << upscaleModeName(mode) << (hasRegion ? " (region)" : "") << " in " << ms << " ms" << std::endl;
+        return 0;
+    }
+
+    printUsage();
+    return 1;
+}
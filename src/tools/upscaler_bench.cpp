@@ -0,0 +1,560 @@
+// Upscaler micro-benchmark.
+//
+// For every mode, times the RGB path a video frame would take today
+// (YUV->RGBA, upscale, RGBA->YUV) against upscaling the 4:2:0 planes directly,
+// on the CPU and optionally through GL. A mostly static sequence then compares
+// upscaling every frame in full with redrawing only dirty tiles, and the sharpening
+// modes are rerun with bilinear on flat (low luma variance) tiles. --scene renders the
+// demo cube natively and at the source size followed by each GL mode, the temporal
+// resolve, checkerboard reconstruction + EASU and a centred fovea of EASU over a bilinear
+// periphery, and reports each one's frame time and PSNR / SSIM / MS-SSIM against native.
+// Each mode also scores a 2x round trip (halve the source, upscale it back) against the
+// source, with the time the metrics themselves took. --perf adds per-call hardware
+// counters (cycles, IPC, bytes per cycle, cache and branch misses) for the CPU kernels.
+// Every registered upscaler (rcas and the separable catmull-rom, mitchell, lanczos2 and
+// lanczos3 included) is then timed and scored through IUpscaler, the objects the demo and
+// batchupscale run, with its quality and time relative to EASU; --mode picks one of them.
+//
+//   upscaler_bench [--size WxH] [--scale F] [--iterations N] [--threads N]
+//                  [--mode nearest|bilinear|sharpen|easu|rcas|catmull-rom|mitchell|lanczos2|lanczos3]
+//                  [--input image.png] [--gl]
+//                  [--edge-threshold T] [--scene] [--frames N] [--perf]
+
+#include "CheckerboardRenderer.h"
+#include "CpuUpscaler.h"
+#include "CubeScene.h"
+#include "DirtyTiles.h"
+#include "EdgeTiles.h"
+#include "FoveatedUpscaler.h"
+#include "GlUpscaler.h"
+#include "GlUpscalers.h"
+#include "Image.h"
+#include "ImageMetrics.h"
+#include "PerfCounters.h"
+#include "TemporalUpscaler.h"
+#include "ThreadPool.h"
+#include "Upscaler.h"
+#include "Yuv.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchResult {
+    std::string name;
+    double msPerFrame = 0.0;
+};
+
+// Quality per millisecond against EASU: the PSNR difference and the time ratio
+std::string versusEasu(double psnr, double ms, double easuPsnr, double easuMs) {
+    if (easuMs <= 0.0)
+        return "";
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(2) << "  vs easu " << std::showpos << psnr - easuPsnr << std::noshowpos
+        << " dB in " << ms / easuMs << "x the time";
+    return out.str();
+}
+
+// One warm-up call, then the average over the remaining iterations
+double timeRuns(int iterations, const std::function<void()> &run) {
+    run();
+    auto start = Clock::now();
+    for (int i = 0; i < iterations; i++)
+        run();
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count() / iterations;
+}
+
+// Gradients, a checkerboard and a few hard diagonal edges so every kernel has work
+Image syntheticImage(int width, int height) {
+    Image image(width, height, 4);
+    for (int y = 0; y < height; y++) {
+        unsigned char *row = image.row(y);
+        for (int x = 0; x < width; x++) {
+            bool check = ((x / 16) + (y / 16)) & 1;
+            bool edge = ((x + y) / 24) & 1;
+            row[x * 4 + 0] = (unsigned char) (x * 255 / std::max(width - 1, 1));
+            row[x * 4 + 1] = (unsigned char) (y * 255 / std::max(height - 1, 1));
+            row[x * 4 + 2] = check ? (edge ? 230 : 40) : 128;
+            row[x * 4 + 3] = 255;
+        }
+    }
+    return image;
+}
+
+// The background with a small sprite sliding across it and a blinking cursor, like a
+// UI capture or a fixed camera: most tiles never change between frames
+std::vector<Image> staticHeavySequence(const Image &background, int frames) {
+    std::vector<Image> sequence;
+    for (int f = 0; f < frames; f++) {
+        Image frame = background;
+        int size = std::max(8, background.height / 12);
+        int sx = (f * 7) % std::max(1, background.width - size), sy = background.height / 3;
+        for (int y = sy; y < std::min(background.height, sy + size); y++)
+            for (int x = sx; x < sx + size; x++)
+                std::memcpy(frame.row(y) + x * 4, "\xff\x40\x20\xff", 4);
+        if (f & 1) {
+            int cx = background.width * 3 / 4, cy = background.height * 3 / 4;
+            for (int y = cy; y < std::min(background.height, cy + 16); y++)
+                for (int x = cx; x < std::min(background.width, cx + 2); x++)
+                    std::memcpy(frame.row(y) + x * 4, "\xff\xff\xff\xff", 4);
+        }
+        sequence.push_back(std::move(frame));
+    }
+    return sequence;
+}
+
+Image readFramebuffer(unsigned int fbo, int width, int height) {
+    Image image(width, height, 4);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, image.pixels.data());
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return image;
+}
+
+// The demo's cube, `frames` frames of animation at 60 Hz per variant. Timing is GPU
+// throughput (one glFinish per run); quality is the last frame against the native render.
+// Each named GL upscaler is drawn through IUpscaler::render, as the demo does.
+void runSceneBenchmark(int renderWidth, int renderHeight, int outputWidth, int outputHeight, int frames,
+                       const std::vector<std::string> &upscalerNames, float sharpness, ThreadPool &pool) {
+    CubeScene scene;
+    Renderer lowRes, native;
+    lowRes.initFBO(renderWidth, renderHeight);
+    native.initFBO(outputWidth, outputHeight);
+    GlUpscaler upscaler;
+    upscaler.resize(renderWidth, renderHeight, outputWidth, outputHeight);
+    TemporalUpscaler temporal;
+    temporal.resize(renderWidth, renderHeight, outputWidth, outputHeight);
+    CheckerboardRenderer checkerboard;
+    checkerboard.resize(renderWidth, renderHeight);
+
+    glm::mat4 view = scene.view();
+    glm::mat4 lowResProjection = scene.projection(renderWidth / (float) renderHeight);
+    glm::mat4 nativeProjection = scene.projection(outputWidth / (float) outputHeight);
+    auto drawScene = [&](Renderer &target, int width, int height, const glm::mat4 &model,
+                         const glm::mat4 &projection, const glm::mat4 &jitteredProjection) {
+        glBindFramebuffer(GL_FRAMEBUFFER, target.fbo);
+        glViewport(0, 0, width, height);
+        glEnable(GL_DEPTH_TEST);
+        target.clearFBO(0.1f, 0.1f, 0.1f);
+        scene.draw(model, view, projection, jitteredProjection);
+        glDisable(GL_DEPTH_TEST);
+    };
+    auto timeFrames = [&](const std::function<void(float)> &frame) {
+        glFinish();
+        auto start = Clock::now();
+        for (int i = 0; i < frames; i++)
+            frame(i / 60.0f);
+        glFinish();
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count() / frames;
+    };
+
+    struct SceneResult {
+        std::string name;
+        double msPerFrame;
+        QualityMetrics quality;
+    };
+    std::vector<SceneResult> results;
+    Image reference;
+    auto score = [&](unsigned int fbo) {
+        return compareImages(readFramebuffer(fbo, outputWidth, outputHeight), reference, &pool);
+    };
+
+    double nativeMs = timeFrames([&](float time) {
+        drawScene(native, outputWidth, outputHeight, scene.model(time), nativeProjection, nativeProjection);
+    });
+    reference = readFramebuffer(native.fbo, outputWidth, outputHeight);
+    results.push_back({"native", nativeMs, {99.0, 1.0, 1.0}});
+
+    for (const std::string &name : upscalerNames) {
+        if (!hasUpscaler(name, UpscalerBackend::Gl))
+            continue;
+        std::unique_ptr<IUpscaler> registered = createUpscaler(name, UpscalerBackend::Gl);
+        registered->init(renderWidth, renderHeight, outputWidth, outputHeight);
+        if (sharpness >= 0.0f)
+            registered->sharpness = sharpness;
+        double ms = timeFrames([&](float time) {
+            drawScene(lowRes, renderWidth, renderHeight, scene.model(time), lowResProjection, lowResProjection);
+            registered->render(lowRes.fboTextureLinear, upscaler.fbo);
+        });
+        results.push_back({name, ms, score(upscaler.fbo)});
+    }
+
+    temporal.reset();
+    scene.resetMotion();
+    double temporalMs = timeFrames([&](float time) {
+        temporal.nextFrame();
+        drawScene(lowRes, renderWidth, renderHeight, scene.model(time), lowResProjection,
+                  temporal.jitterProjection(lowResProjection));
+        temporal.resolve(lowRes.fboTextureLinear, lowRes.fboVelocityTexture, lowRes.fboDepthTexture);
+    });
+    results.push_back({"temporal", temporalMs, score(temporal.outputFbo())});
+
+    checkerboard.reset();
+    scene.resetMotion();
+    double checkerboardMs = timeFrames([&](float time) {
+        checkerboard.nextFrame();
+        glBindFramebuffer(GL_FRAMEBUFFER, lowRes.fbo);
+        glViewport(0, 0, renderWidth, renderHeight);
+        lowRes.clearFBO(0.1f, 0.1f, 0.1f);
+        checkerboard.beginScene();
+        scene.draw(scene.model(time), view, lowResProjection);
+        checkerboard.endScene();
+        glDisable(GL_DEPTH_TEST);
+        checkerboard.reconstruct(lowRes.fboTextureLinear, lowRes.fboVelocityTexture, lowRes.fboDepthTexture);
+        upscaler.render(checkerboard.outputTexture(), UpscaleMode::Easu, sharpness >= 0.0f ? sharpness : 0.2f);
+    });
+    results.push_back({"checkerboard + easu", checkerboardMs, score(upscaler.fbo)});
+
+    FoveatedUpscaler foveated;
+    Fovea fovea;
+    fovea.x = outputWidth * 0.5f;
+    fovea.y = outputHeight * 0.5f;
+    fovea.radius = outputHeight * 0.2f;
+    fovea.band = outputHeight * 0.1f;
+    double foveatedMs = timeFrames([&](float time) {
+        drawScene(lowRes, renderWidth, renderHeight, scene.model(time), lowResProjection, lowResProjection);
+        glBindFramebuffer(GL_FRAMEBUFFER, upscaler.fbo);
+        foveated.draw(lowRes.fboTextureLinear, renderWidth, renderHeight, outputWidth, outputHeight, fovea,
+                      UpscaleMode::Bilinear, sharpness >= 0.0f ? sharpness : 0.2f);
+    });
+    results.push_back({"foveated easu (" + std::to_string((int) (foveated.fullFraction * 100.0 + 0.5)) + "% full)",
+                       foveatedMs, score(upscaler.fbo)});
+
+    std::cout << "scene: " << renderWidth << "x" << renderHeight << " -> " << outputWidth << "x" << outputHeight
+              << ", " << frames << " frames" << std::endl;
+    auto easu = std::find_if(results.begin(), results.end(), [](const SceneResult &r) { return r.name == "easu"; });
+    for (const SceneResult &r : results) {
+        std::cout << "  " << std::left << std::setw(28) << r.name << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(9) << r.msPerFrame << " ms  " << std::setprecision(2) << std::setw(6)
+                  << r.quality.psnr << " dB  SSIM " << std::setprecision(4) << r.quality.ssim << "  MS-SSIM "
+                  << r.quality.msSsim;
+        if (easu != results.end() && &r != &*easu && r.name != "native")
+            std::cout << versusEasu(r.quality.psnr, r.msPerFrame, easu->quality.psnr, easu->msPerFrame);
+        std::cout << std::endl;
+    }
+    lowRes.releaseFBO();
+    native.releaseFBO();
+}
+
+// One warm-up call, then the counters of `iterations` calls across all threads, per call.
+// Bytes are what one call reads and writes, so bytes per cycle is against the sum over cores.
+void printKernelCounters(PerfCounters &counters, const char *name, int iterations, double bytesPerCall,
+                         const std::function<void()> &run) {
+    run();
+    counters.start();
+    for (int i = 0; i < iterations; i++)
+        run();
+    PerfSample sample = counters.stop();
+
+    auto format = [](bool valid, const char *spec, double value) {
+        char text[32] = "n/a";
+        if (valid)
+            std::snprintf(text, sizeof(text), spec, value);
+        return std::string(text);
+    };
+    auto millions = [&](PerfSample::Event event) {
+        return format(sample.valid[event], "%.3f M", sample.counts[event] / iterations / 1e6);
+    };
+    double cycles = sample.counts[PerfSample::Cycles] / iterations;
+    std::cout << "    " << std::left << std::setw(26) << name << std::right << millions(PerfSample::Cycles)
+              << " cycles, IPC " << format(sample.valid[PerfSample::Instructions], "%.2f", sample.ipc()) << ", "
+              << format(cycles > 0, "%.2f", bytesPerCall / cycles) << " B/cycle, L1D misses "
+              << millions(PerfSample::L1dMisses) << ", LLC misses " << millions(PerfSample::LlcMisses)
+              << ", branch misses " << millions(PerfSample::BranchMisses) << std::endl;
+}
+
+void printUsage() {
+    std::cerr << "Usage: upscaler_bench [--size WxH] [--scale F] [--iterations N] [--threads N]\n"
+                 "                      [--mode nearest|bilinear|sharpen|easu|rcas|catmull-rom|mitchell|lanczos2|lanczos3]\n"
+                 "                      [--input image.png] [--gl]\n"
+                 "                      [--edge-threshold T] [--scene] [--frames N] [--perf]" << std::endl;
+}
+
+void printResults(const std::vector<BenchResult> &results, double megapixels) {
+    for (const BenchResult &r : results) {
+        std::cout << "  " << std::left << std::setw(28) << r.name << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(9) << r.msPerFrame << " ms  " << std::setprecision(1) << std::setw(8)
+                  << megapixels * 1000.0 / r.msPerFrame << " MP/s" << std::endl;
+    }
+}
+
+}
+
+int main(int argc, char **argv) {
+    int srcWidth = 960, srcHeight = 540, iterations = 20, sceneFrames = 60;
+    float scale = 2.0f, sharpness = -1.0f, edgeThreshold = 64.0f;
+    unsigned int threads = std::thread::hardware_concurrency();
+    std::vector<UpscaleMode> modes = {UpscaleMode::Nearest, UpscaleMode::Bilinear, UpscaleMode::Sharpen, UpscaleMode::Easu};
+    std::vector<std::string> registeredNames = upscalerNames(UpscalerBackend::Cpu);
+    std::string inputPath;
+    bool useGl = false, scene = false, perf = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--size" && i + 1 < argc) std::sscanf(argv[++i], "%dx%d", &srcWidth, &srcHeight);
+        else if (arg == "--scale" && i + 1 < argc) scale = std::stof(argv[++i]);
+        else if (arg == "--iterations" && i + 1 < argc) iterations = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--threads" && i + 1 < argc) threads = (unsigned int) std::stoi(argv[++i]);
+        else if (arg == "--sharpness" && i + 1 < argc) sharpness = std::stof(argv[++i]);
+        else if (arg == "--edge-threshold" && i + 1 < argc) edgeThreshold = std::stof(argv[++i]);
+        else if (arg == "--mode" && i + 1 < argc) {
+            // Any registered upscaler, with easu as the baseline; the per-path breakdown
+            // only exists for the UpscaleModes
+            std::string name = argv[++i];
+            UpscaleMode mode;
+            if (!hasUpscaler(name, UpscalerBackend::Cpu)) { printUsage(); return 1; }
+            registeredNames = {name};
+            if (name != "easu")
+                registeredNames.insert(registeredNames.begin(), "easu");
+            modes.clear();
+            if (parseUpscaleMode(name, mode))
+                modes = {mode};
+        }
+        else if (arg == "--input" && i + 1 < argc) inputPath = argv[++i];
+        else if (arg == "--gl") useGl = true;
+        else if (arg == "--scene") useGl = scene = true;
+        else if (arg == "--frames" && i + 1 < argc) sceneFrames = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--perf") perf = true;
+        else { printUsage(); return 1; }
+    }
+
+    Image source;
+    if (!inputPath.empty()) {
+        if (!loadImage(inputPath, source, 4))
+            return 1;
+    } else {
+        source = syntheticImage(srcWidth, srcHeight);
+    }
+    int dstWidth = (int) (source.width * scale + 0.5f), dstHeight = (int) (source.height * scale + 0.5f);
+
+    ThreadPool pool(threads);
+    YuvFrame yuvIn, yuvOut;
+    yuvIn.resize(source.width, source.height);
+    yuvOut.resize(dstWidth, dstHeight);
+    rgbaToYuv420(source, yuvIn, YuvMatrix::BT709, &pool);
+    Image rgbIn(source.width, source.height, 4), rgbOut(dstWidth, dstHeight, 4);
+    std::vector<Image> sequence = staticHeavySequence(source, 16);
+    std::unique_ptr<PerfCounters> counters;
+    if (perf) {
+        counters = std::make_unique<PerfCounters>(&pool);
+        if (!counters->available()) {
+            std::cerr << "Hardware counters are unavailable (no PMU exposed here, or perf_event_paranoid > 2)"
+                      << std::endl;
+            counters.reset();
+        }
+    }
+    // Round trip for the quality line: the halved source upscaled back onto the source grid
+    Image halfSource = downsampleImage(source);
+    Image roundTrip(halfSource.width * 2, halfSource.height * 2, 4);
+    ImageView roundTripReference(source.pixels.data(), roundTrip.width, roundTrip.height,
+                                 (size_t) source.width * 4, 4);
+
+    GLFWwindow *glWindow = nullptr;
+    std::unique_ptr<GlUpscaler> glUpscaler;
+    if (useGl) {
+        glWindow = createHeadlessContext();
+        if (!glWindow) {
+            std::cerr << "Failed to create a headless GL context" << std::endl;
+            return 1;
+        }
+        glUpscaler = std::make_unique<GlUpscaler>();
+        glUpscaler->resize(source.width, source.height, dstWidth, dstHeight);
+        registerGlUpscalers();
+    }
+
+    double megapixels = (double) dstWidth * dstHeight / 1e6;
+    std::cout << source.width << "x" << source.height << " -> " << dstWidth << "x" << dstHeight << ", "
+              << pool.size() << " threads, " << iterations << " iterations" << std::endl;
+
+    for (UpscaleMode mode : modes) {
+        float s = sharpness >= 0.0f ? sharpness : (mode == UpscaleMode::Easu ? 0.2f : 0.5f);
+        std::vector<BenchResult> results;
+
+        // Convert-upscale-convert, as y4mupscale does without --yuv
+        auto rgbPath = [&](const std::function<void()> &upscale) {
+            return [&, upscale] {
+                yuv420ToRgba(yuvIn, rgbIn, YuvMatrix::BT709, &pool);
+                upscale();
+                rgbaToYuv420(rgbOut, yuvOut, YuvMatrix::BT709, &pool);
+            };
+        };
+
+        results.push_back({"cpu rgba upscale only", timeRuns(iterations, [&] {
+            upscaleImage(rgbIn, rgbOut, mode, s, &pool);
+        })});
+        results.push_back({"cpu convert-upscale-convert", timeRuns(iterations, rgbPath([&] {
+            upscaleImage(rgbIn, rgbOut, mode, s, &pool);
+        }))});
+        results.push_back({"cpu yuv420 native", timeRuns(iterations, [&] {
+            upscaleYuv420(yuvIn, yuvOut, mode, s, &pool);
+        })});
+
+        if (glUpscaler) {
+            results.push_back({"gl convert-upscale-convert", timeRuns(iterations, rgbPath([&] {
+                glUpscaler->process(rgbIn, rgbOut, mode, s);
+            }))});
+            results.push_back({"gl yuv420 native", timeRuns(iterations, [&] {
+                glUpscaler->processYuv(yuvIn, yuvOut, mode, s);
+            })});
+        }
+
+        // Static-heavy sequence; the warm-up frame is all dirty and left out of the redraw share
+        size_t frame = 0;
+        results.push_back({"cpu full (static sequence)", timeRuns(iterations, [&] {
+            upscaleImage(sequence[frame++ % sequence.size()], rgbOut, mode, s, &pool);
+        })});
+        DirtyTileTracker tracker;
+        double redrawn = 0.0;
+        int updates = 0;
+        frame = 0;
+        results.push_back({"cpu incremental (static)", timeRuns(iterations, [&] {
+            const Image &f = sequence[frame++ % sequence.size()];
+            tracker.update(f, dstWidth, dstHeight);
+            upscaleRects(f, rgbOut, tracker.outputRects, mode, s, &pool);
+            if (updates++ > 0)
+                redrawn += tracker.outputFraction;
+        })});
+        double cpuSpeedup = results[results.size() - 2].msPerFrame / results.back().msPerFrame;
+
+        if (glUpscaler) {
+            frame = 0;
+            results.push_back({"gl full (static sequence)", timeRuns(iterations, [&] {
+                glUpscaler->process(sequence[frame++ % sequence.size()], rgbOut, mode, s);
+            })});
+            tracker.reset();
+            frame = 0;
+            results.push_back({"gl incremental (static)", timeRuns(iterations, [&] {
+                const Image &f = sequence[frame++ % sequence.size()];
+                tracker.update(f, dstWidth, dstHeight);
+                glUpscaler->processRects(f, rgbOut, tracker.sourceRects, tracker.outputRects, mode, s);
+            })});
+        }
+
+        upscaleImage(halfSource, roundTrip, mode, s, &pool);
+        auto scoreStart = Clock::now();
+        QualityMetrics quality = compareImages(roundTrip, roundTripReference, &pool);
+        double scoreMs = std::chrono::duration<double, std::milli>(Clock::now() - scoreStart).count();
+
+        // Edge mask: only the sharpening modes have anything to skip
+        bool edgeMask = mode == UpscaleMode::Sharpen || mode == UpscaleMode::Easu;
+        EdgeTileClassifier edgeTiles;
+        double edgeSpeedup = 0.0, glEdgeSpeedup = 0.0, cpuEdgePsnr = 0.0, glEdgePsnr = 0.0;
+        if (edgeMask) {
+            Image full(dstWidth, dstHeight, 4), masked(dstWidth, dstHeight, 4);
+            double fullMs = timeRuns(iterations, [&] {
+                upscaleImage(source, full, mode, s, &pool);
+            });
+            results.push_back({"cpu edge-masked", timeRuns(iterations, [&] {
+                edgeTiles.classify(source, dstWidth, dstHeight, edgeThreshold, &pool);
+                upscaleEdgeMasked(source, masked, edgeTiles, mode, s, &pool);
+            })});
+            edgeSpeedup = fullMs / results.back().msPerFrame;
+            cpuEdgePsnr = imagePsnr(masked, full, &pool);
+            if (glUpscaler) {
+                double glFullMs = timeRuns(iterations, [&] {
+                    glUpscaler->process(source, full, mode, s);
+                });
+                results.push_back({"gl edge-masked", timeRuns(iterations, [&] {
+                    edgeTiles.classify(source, dstWidth, dstHeight, edgeThreshold, &pool);
+                    glUpscaler->processEdgeMasked(source, masked, edgeTiles.flatRects, edgeTiles.edgeRects, mode, s);
+                })});
+                glEdgeSpeedup = glFullMs / results.back().msPerFrame;
+                glUpscaler->process(source, full, mode, s);
+                glEdgePsnr = imagePsnr(masked, full, &pool);
+            }
+        }
+
+        std::cout << upscaleModeName(mode) << ":" << std::endl;
+        printResults(results, megapixels);
+        double share = redrawn * 100.0 / std::max(1, updates - 1);
+        std::cout << "  static sequence: redrew " << std::setprecision(1) << share << "% of the output ("
+                  << 100.0 - share << "% skipped), cpu " << std::setprecision(2) << cpuSpeedup << "x faster"
+                  << std::endl;
+        std::cout << "  2x round trip: PSNR " << quality.psnr << " dB, SSIM " << std::setprecision(4) << quality.ssim
+                  << ", MS-SSIM " << quality.msSsim << " (scored in " << std::setprecision(1) << scoreMs << " ms)"
+                  << std::endl;
+        if (edgeMask) {
+            std::cout << "  edge mask: full kernel on " << std::setprecision(1) << edgeTiles.edgeFraction * 100.0
+                      << "% of the output, cpu " << std::setprecision(2) << edgeSpeedup
+                      << "x faster than the full image, PSNR vs full kernel " << cpuEdgePsnr << " dB";
+            if (glUpscaler)
+                std::cout << "; gl " << glEdgeSpeedup << "x, " << glEdgePsnr << " dB";
+            std::cout << std::endl;
+        }
+
+        if (counters) {
+            double rgbaBytes = ((double) source.width * source.height + (double) dstWidth * dstHeight) * 4.0;
+            std::cout << "  hardware counters per call (all threads):" << std::endl;
+            printKernelCounters(*counters, "cpu rgba upscale", iterations, rgbaBytes, [&] {
+                upscaleImage(rgbIn, rgbOut, mode, s, &pool);
+            });
+            printKernelCounters(*counters, "cpu yuv420 native", iterations, rgbaBytes * 1.5 / 4.0, [&] {
+                upscaleYuv420(yuvIn, yuvOut, mode, s, &pool);
+            });
+            if (edgeMask) {
+                Image masked(dstWidth, dstHeight, 4);
+                printKernelCounters(*counters, "cpu edge-masked", iterations, rgbaBytes, [&] {
+                    edgeTiles.classify(source, dstWidth, dstHeight, edgeThreshold, &pool);
+                    upscaleEdgeMasked(source, masked, edgeTiles, mode, s, &pool);
+                });
+            }
+        }
+    }
+
+    // The plain RGBA upscale through the registry, as the demo and batchupscale run it
+    std::cout << "registered upscalers (2x round trip quality):" << std::endl;
+    for (UpscalerBackend backend : {UpscalerBackend::Cpu, UpscalerBackend::Gl}) {
+        if (backend == UpscalerBackend::Gl && !glUpscaler)
+            continue;
+        double easuPsnr = 0.0, easuMs = 0.0;
+        for (const std::string &name : registeredNames) {
+            if (!hasUpscaler(name, backend))
+                continue;
+            std::unique_ptr<IUpscaler> upscaler = createUpscaler(name, backend);
+            upscaler->setThreadPool(&pool);
+            if (sharpness >= 0.0f)
+                upscaler->sharpness = sharpness;
+            upscaler->init(halfSource.width, halfSource.height, roundTrip.width, roundTrip.height);
+            upscaler->process(halfSource, roundTrip);
+            QualityMetrics quality = compareImages(roundTrip, roundTripReference, &pool);
+            upscaler->resize(source.width, source.height, dstWidth, dstHeight);
+            double ms = timeRuns(iterations, [&] {
+                upscaler->process(source, rgbOut);
+            });
+            std::string label = std::string(upscalerBackendName(backend)) + " " + name;
+            std::cout << "  " << std::left << std::setw(28) << label << std::right << std::fixed
+                      << std::setprecision(3) << std::setw(9) << ms << " ms  " << std::setprecision(1) << std::setw(8)
+                      << megapixels * 1000.0 / ms << " MP/s  " << std::setprecision(2) << std::setw(6) << quality.psnr
+                      << " dB  SSIM " << std::setprecision(4) << quality.ssim << "  MS-SSIM " << quality.msSsim
+                      << (name == "easu" ? "" : versusEasu(quality.psnr, ms, easuPsnr, easuMs)) << std::endl;
+            if (name == "easu") {
+                easuPsnr = quality.psnr;
+                easuMs = ms;
+            }
+        }
+    }
+
+    if (scene)
+        runSceneBenchmark(source.width, source.height, dstWidth, dstHeight, sceneFrames, registeredNames, sharpness,
+                          pool);
+
+    if (glWindow) {
+        glUpscaler.reset();
+        glfwTerminate();
+    }
+    return 0;
+}
@@ -0,0 +1,123 @@
+// Sends one upscale request to upscalerd and saves the result.
+//
+// By default the image is loaded here and its pixels travel over the socket; with
+// --path only the two file names are sent and the daemon does the file I/O (both must
+// be under the daemon's --root).
+// Busy answers are retried with exponential backoff.
+//
+//   upscaler_client [--socket PATH] [--scale F | --size WxH] [--mode nearest|bilinear|sharpen|easu]
+//                   [--sharpness S] [--path] input.png output.png
+
+#include "Image.h"
+#include "UpscaleMode.h"
+#include "UpscaleProtocol.h"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+void printUsage() {
+    std::cerr << "Usage: upscaler_client [--socket PATH] [--scale F | --size WxH] [--mode nearest|bilinear|sharpen|easu]\n"
+                 "                       [--sharpness S] [--path] input.png output.png" << std::endl;
+}
+
+}
+
+int main(int argc, char **argv) {
+    std::string socketPath = UPSCALE_DEFAULT_SOCKET, inputPath, outputPath;
+    UpscaleRequestHeader request;
+    UpscaleMode mode = UpscaleMode::Easu;
+    bool sendPaths = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc) socketPath = argv[++i];
+        else if (arg == "--scale" && i + 1 < argc) request.scale = std::stof(argv[++i]);
+        else if (arg == "--size" && i + 1 < argc) std::sscanf(argv[++i], "%dx%d", &request.outWidth, &request.outHeight);
+        else if (arg == "--mode" && i + 1 < argc) {
+            if (!parseUpscaleMode(argv[++i], mode)) { printUsage(); return 1; }
+        }
+        else if (arg == "--sharpness" && i + 1 < argc) request.sharpness = std::stof(argv[++i]);
+        else if (arg == "--path") sendPaths = true;
+        else if (inputPath.empty()) inputPath = arg;
+        else if (outputPath.empty()) outputPath = arg;
+        else { printUsage(); return 1; }
+    }
+    if (inputPath.empty() || outputPath.empty()) {
+        printUsage();
+        return 1;
+    }
+    request.mode = (uint8_t) mode;
+    request.id = 1;
+
+    Image input;
+    std::string paths;
+    const void *payload;
+    // Pixels come back only without --path, and never more than asked for
+    size_t expectedBytes = 0;
+    if (sendPaths) {
+        // The daemon has its own working directory
+        paths = std::filesystem::absolute(inputPath).string() + '\0' + std::filesystem::absolute(outputPath).string();
+        request.source = UpscaleSource::Path;
+        request.payloadBytes = (uint32_t) paths.size();
+        payload = paths.data();
+    } else {
+        if (!loadImage(inputPath, input, 4))
+            return 1;
+        request.source = UpscaleSource::Pixels;
+        request.width = input.width;
+        request.height = input.height;
+        request.payloadBytes = (uint32_t) input.pixels.size();
+        payload = input.pixels.data();
+        int outWidth, outHeight;
+        if (!resolveOutputSize(request, input.width, input.height, outWidth, outHeight)) {
+            std::cerr << "Bad output size" << std::endl;
+            return 1;
+        }
+        expectedBytes = (size_t) outWidth * outHeight * 4;
+    }
+
+    int fd = connectUnixSocket(socketPath);
+    if (fd < 0)
+        return 1;
+
+    auto start = std::chrono::steady_clock::now();
+    UpscaleResponseHeader response;
+    std::vector<unsigned char> result;
+    for (int attempt = 0;; attempt++) {
+        if (!writeMessage(fd, &request, sizeof(request), payload, request.payloadBytes) ||
+            !readResponse(fd, response, result, expectedBytes)) {
+            std::cerr << "Connection to upscalerd lost" << std::endl;
+            close(fd);
+            return 1;
+        }
+        if (response.status != UpscaleStatus::Busy || attempt == 8)
+            break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1 << attempt));
+    }
+    close(fd);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    if (response.status == UpscaleStatus::Busy) {
+        std::cerr << "upscalerd stayed busy, giving up" << std::endl;
+        return 1;
+    }
+    if (response.status == UpscaleStatus::Error) {
+        std::cerr << "upscalerd: " << std::string(result.begin(), result.end()) << std::endl;
+        return 1;
+    }
+
+    if (!sendPaths) {
+        Image output(response.width, response.height, 4);
+        output.pixels = std::move(result);
+        if (!saveImagePng(outputPath, output))
+            return 1;
+    }
+    std::cerr << outputPath << " (" << ms << " ms)" << std::endl;
+    return 0;
+}
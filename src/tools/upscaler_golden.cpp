@@ -0,0 +1,330 @@
+// Golden-image regression check for the upscalers.
+//
+// Renders fixed, deterministic frames through every path: every registered upscaler on
+// the CPU and on GL plus the 4:2:0 and edge-masked paths on a halved still image, and the demo cube at a fixed
+// animation time natively, through each GL mode, the temporal resolve, checkerboard + EASU
+// and the foveated pass. Each output is compared with its PNG in the golden directory:
+// CPU outputs must match byte for byte (the kernels are deterministic integer code), GL
+// outputs must clear a per-case PSNR/SSIM floor (drivers round and rasterise
+// differently), and the report shows how its quality against the reference
+// (the full-size image, or the native render) moved from the golden's. Exits 1 on any failure.
+//
+//   upscaler_golden [--update] [--dir goldens] [--cpu-only] [--threads N]
+
+#include "CheckerboardRenderer.h"
+#include "CpuUpscaler.h"
+#include "CubeScene.h"
+#include "EdgeTiles.h"
+#include "FoveatedUpscaler.h"
+#include "GlUpscaler.h"
+#include "GlUpscalers.h"
+#include "Image.h"
+#include "ImageMetrics.h"
+#include "TemporalUpscaler.h"
+#include "ThreadPool.h"
+#include "Upscaler.h"
+#include "Yuv.h"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Scene cases render the frame at this animation time; the temporal and checkerboard
+// cases accumulate HISTORY_FRAMES frames at 60 Hz ending on it.
+constexpr float FIXED_TIME = 1.25f;
+constexpr int HISTORY_FRAMES = 16;
+constexpr int SCENE_WIDTH = 320, SCENE_HEIGHT = 180;
+// Luma variance (8-bit units squared) above which a tile of the halved image counts as an
+// edge tile; at this level about 40% of the output takes the cheap filter
+constexpr float EDGE_MASK_THRESHOLD = 800.0f;
+
+struct Tolerance {
+    double minPsnr, minSsim;
+    // Every byte must match; the floors are ignored
+    bool exact = false;
+};
+// Same result with any thread count and with or without SSE2, so a 1-LSB change is a regression
+constexpr Tolerance CPU_EXACT = {0.0, 0.0, true};
+constexpr Tolerance GL_IMAGE_TOLERANCE = {40.0, 0.99};
+constexpr Tolerance GL_SCENE_TOLERANCE = {35.0, 0.98};
+// Accumulated history amplifies small per-frame differences
+constexpr Tolerance GL_HISTORY_TOLERANCE = {30.0, 0.95};
+
+struct GoldenCase {
+    std::string name;
+    Image output;
+    const Image *reference;
+    Tolerance tolerance;
+};
+
+float defaultSharpness(UpscaleMode mode) {
+    return mode == UpscaleMode::Easu ? 0.2f : 0.5f;
+}
+
+Image readFramebuffer(unsigned int fbo, int width, int height) {
+    Image image(width, height, 4);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, image.pixels.data());
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return image;
+}
+
+// "<backend>-<name>" for every upscaler the backend has registered, at its default sharpness
+void addRegisteredCases(UpscalerBackend backend, const Image &half, const Image &reference, ThreadPool &pool,
+                        Tolerance tolerance, std::vector<GoldenCase> &cases) {
+    int width = half.width * 2, height = half.height * 2;
+    for (const std::string &name : upscalerNames(backend)) {
+        std::unique_ptr<IUpscaler> upscaler = createUpscaler(name, backend);
+        upscaler->setThreadPool(&pool);
+        upscaler->init(half.width, half.height, width, height);
+        Image out(width, height, 4);
+        upscaler->process(half, out);
+        cases.push_back({std::string(upscalerBackendName(backend)) + "-" + name, std::move(out), &reference, tolerance});
+    }
+}
+
+// False if the edge mask has no flat tiles, which would make its case a copy of plain EASU
+bool addCpuCases(const Image &half, const Image &reference, ThreadPool &pool, std::vector<GoldenCase> &cases) {
+    int width = half.width * 2, height = half.height * 2;
+    addRegisteredCases(UpscalerBackend::Cpu, half, reference, pool, CPU_EXACT, cases);
+
+    YuvFrame yuvIn, yuvOut;
+    yuvIn.resize(half.width, half.height);
+    yuvOut.resize(width, height);
+    rgbaToYuv420(half, yuvIn, YuvMatrix::BT709, &pool);
+    upscaleYuv420(yuvIn, yuvOut, UpscaleMode::Easu, defaultSharpness(UpscaleMode::Easu), &pool);
+    Image yuvRgb(width, height, 4);
+    yuv420ToRgba(yuvOut, yuvRgb, YuvMatrix::BT709, &pool);
+    cases.push_back({"cpu-yuv420-easu", std::move(yuvRgb), &reference, CPU_EXACT});
+
+    EdgeTileClassifier edgeTiles;
+    edgeTiles.classify(half, width, height, EDGE_MASK_THRESHOLD, &pool);
+    if (edgeTiles.flatRects.empty()) {
+        std::cerr << "Edge mask at threshold " << EDGE_MASK_THRESHOLD << " has no flat tiles" << std::endl;
+        return false;
+    }
+    Image masked(width, height, 4);
+    upscaleEdgeMasked(half, masked, edgeTiles, UpscaleMode::Easu, defaultSharpness(UpscaleMode::Easu), &pool);
+    cases.push_back({"cpu-edge-masked-easu", std::move(masked), &reference, CPU_EXACT});
+    return true;
+}
+
+void addGlImageCases(const Image &half, const Image &reference, ThreadPool &pool, std::vector<GoldenCase> &cases) {
+    int width = half.width * 2, height = half.height * 2;
+    addRegisteredCases(UpscalerBackend::Gl, half, reference, pool, GL_IMAGE_TOLERANCE, cases);
+    GlUpscaler upscaler;
+    upscaler.resize(half.width, half.height, width, height);
+
+    YuvFrame yuvIn, yuvOut;
+    yuvIn.resize(half.width, half.height);
+    yuvOut.resize(width, height);
+    rgbaToYuv420(half, yuvIn, YuvMatrix::BT709, &pool);
+    upscaler.processYuv(yuvIn, yuvOut, UpscaleMode::Easu, defaultSharpness(UpscaleMode::Easu));
+    Image yuvRgb(width, height, 4);
+    yuv420ToRgba(yuvOut, yuvRgb, YuvMatrix::BT709, &pool);
+    cases.push_back({"gl-yuv420-easu", std::move(yuvRgb), &reference, GL_IMAGE_TOLERANCE});
+}
+
+// The demo cube at FIXED_TIME; nativeOut receives the native render every other case is scored against.
+void addSceneCases(Image &nativeOut, std::vector<GoldenCase> &cases) {
+    int renderWidth = SCENE_WIDTH, renderHeight = SCENE_HEIGHT;
+    int outputWidth = SCENE_WIDTH * 2, outputHeight = SCENE_HEIGHT * 2;
+    CubeScene scene;
+    Renderer lowRes, native;
+    lowRes.initFBO(renderWidth, renderHeight);
+    native.initFBO(outputWidth, outputHeight);
+    GlUpscaler upscaler;
+    upscaler.resize(renderWidth, renderHeight, outputWidth, outputHeight);
+
+    glm::mat4 view = scene.view();
+    glm::mat4 lowResProjection = scene.projection(renderWidth / (float) renderHeight);
+    glm::mat4 nativeProjection = scene.projection(outputWidth / (float) outputHeight);
+    auto drawScene = [&](Renderer &target, int width, int height, float time, const glm::mat4 &projection,
+                         const glm::mat4 &jitteredProjection) {
+        glBindFramebuffer(GL_FRAMEBUFFER, target.fbo);
+        glViewport(0, 0, width, height);
+        glEnable(GL_DEPTH_TEST);
+        target.clearFBO(0.1f, 0.1f, 0.1f);
+        scene.draw(scene.model(time), view, projection, jitteredProjection);
+        glDisable(GL_DEPTH_TEST);
+    };
+    // Frames leading up to FIXED_TIME, for the passes that keep history
+    auto runHistory = [&](const std::function<void(float)> &frame) {
+        scene.resetMotion();
+        for (int i = HISTORY_FRAMES - 1; i >= 0; i--)
+            frame(FIXED_TIME - i / 60.0f);
+    };
+
+    scene.resetMotion();
+    drawScene(native, outputWidth, outputHeight, FIXED_TIME, nativeProjection, nativeProjection);
+    nativeOut = readFramebuffer(native.fbo, outputWidth, outputHeight);
+    cases.push_back({"scene-native", nativeOut, &nativeOut, GL_SCENE_TOLERANCE});
+
+    // Each registered GL upscaler drawn into the GlUpscaler's output target
+    for (const std::string &name : upscalerNames(UpscalerBackend::Gl)) {
+        std::unique_ptr<IUpscaler> registered = createUpscaler(name, UpscalerBackend::Gl);
+        registered->init(renderWidth, renderHeight, outputWidth, outputHeight);
+        scene.resetMotion();
+        drawScene(lowRes, renderWidth, renderHeight, FIXED_TIME, lowResProjection, lowResProjection);
+        registered->render(lowRes.fboTextureLinear, upscaler.fbo);
+        cases.push_back({"scene-" + name, readFramebuffer(upscaler.fbo, outputWidth, outputHeight), &nativeOut,
+                         GL_SCENE_TOLERANCE});
+    }
+
+    TemporalUpscaler temporal;
+    temporal.resize(renderWidth, renderHeight, outputWidth, outputHeight);
+    runHistory([&](float time) {
+        temporal.nextFrame();
+        drawScene(lowRes, renderWidth, renderHeight, time, lowResProjection, temporal.jitterProjection(lowResProjection));
+        temporal.resolve(lowRes.fboTextureLinear, lowRes.fboVelocityTexture, lowRes.fboDepthTexture);
+    });
+    cases.push_back({"scene-temporal", readFramebuffer(temporal.outputFbo(), outputWidth, outputHeight), &nativeOut,
+                     GL_HISTORY_TOLERANCE});
+
+    CheckerboardRenderer checkerboard;
+    checkerboard.resize(renderWidth, renderHeight);
+    runHistory([&](float time) {
+        checkerboard.nextFrame();
+        glBindFramebuffer(GL_FRAMEBUFFER, lowRes.fbo);
+        glViewport(0, 0, renderWidth, renderHeight);
+        lowRes.clearFBO(0.1f, 0.1f, 0.1f);
+        checkerboard.beginScene();
+        scene.draw(scene.model(time), view, lowResProjection);
+        checkerboard.endScene();
+        glDisable(GL_DEPTH_TEST);
+        checkerboard.reconstruct(lowRes.fboTextureLinear, lowRes.fboVelocityTexture, lowRes.fboDepthTexture);
+        upscaler.render(checkerboard.outputTexture(), UpscaleMode::Easu, defaultSharpness(UpscaleMode::Easu));
+    });
+    cases.push_back({"scene-checkerboard-easu", readFramebuffer(upscaler.fbo, outputWidth, outputHeight), &nativeOut,
+                     GL_HISTORY_TOLERANCE});
+
+    FoveatedUpscaler foveated;
+    Fovea fovea;
+    fovea.x = outputWidth * 0.5f;
+    fovea.y = outputHeight * 0.5f;
+    fovea.radius = outputHeight * 0.2f;
+    fovea.band = outputHeight * 0.1f;
+    scene.resetMotion();
+    drawScene(lowRes, renderWidth, renderHeight, FIXED_TIME, lowResProjection, lowResProjection);
+    glBindFramebuffer(GL_FRAMEBUFFER, upscaler.fbo);
+    foveated.draw(lowRes.fboTextureLinear, renderWidth, renderHeight, outputWidth, outputHeight, fovea,
+                  UpscaleMode::Bilinear, defaultSharpness(UpscaleMode::Easu));
+    cases.push_back({"scene-foveated-easu", readFramebuffer(upscaler.fbo, outputWidth, outputHeight), &nativeOut,
+                     GL_SCENE_TOLERANCE});
+    lowRes.releaseFBO();
+    native.releaseFBO();
+}
+
+void printUsage() {
+    std::cerr << "Usage: upscaler_golden [--update] [--dir goldens] [--cpu-only] [--threads N]" << std::endl;
+}
+
+}
+
+int main(int argc, char **argv) {
+    std::string dir = "goldens", inputPath = "assets/low_res_image2.png";
+    unsigned int threads = std::thread::hardware_concurrency();
+    bool update = false, cpuOnly = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--update") update = true;
+        else if (arg == "--dir" && i + 1 < argc) dir = argv[++i];
+        else if (arg == "--cpu-only") cpuOnly = true;
+        else if (arg == "--threads" && i + 1 < argc) threads = (unsigned int) std::stoi(argv[++i]);
+        else { printUsage(); return 1; }
+    }
+
+    // Upscaling the halved image back to (the even part of) its own size gives every image case a reference
+    Image source;
+    if (!loadImage(inputPath, source, 4))
+        return 1;
+    Image half = downsampleImage(source);
+    Image imageReference(half.width * 2, half.height * 2, 4);
+    for (int y = 0; y < imageReference.height; y++)
+        std::copy_n(source.row(y), (size_t) imageReference.width * 4, imageReference.row(y));
+
+    ThreadPool pool(threads);
+    std::vector<GoldenCase> cases;
+    if (!addCpuCases(half, imageReference, pool, cases))
+        return 1;
+
+    Image sceneReference;
+    GLFWwindow *glWindow = nullptr;
+    if (!cpuOnly) {
+        glWindow = createHeadlessContext();
+        if (!glWindow) {
+            std::cerr << "Failed to create a headless GL context (use --cpu-only)" << std::endl;
+            return 1;
+        }
+        registerGlUpscalers();
+        addGlImageCases(half, imageReference, pool, cases);
+        addSceneCases(sceneReference, cases);
+        glfwTerminate();
+    }
+
+    if (update) {
+        std::filesystem::create_directories(dir);
+        for (const GoldenCase &c : cases) {
+            if (!saveImagePng(dir + "/" + c.name + ".png", c.output))
+                return 1;
+        }
+        std::cout << "wrote " << cases.size() << " goldens to " << dir << "/" << std::endl;
+        return 0;
+    }
+
+    int failures = 0;
+    std::cout << std::left << std::setw(26) << "case" << std::right << std::setw(10) << "psnr  " << std::setw(9)
+              << "ssim" << std::setw(10) << "ms-ssim" << "   quality vs reference (delta from golden)" << std::endl;
+    for (const GoldenCase &c : cases) {
+        Image golden;
+        std::string path = dir + "/" + c.name + ".png";
+        if (!std::filesystem::exists(path) || !loadImage(path, golden, 4)) {
+            std::cout << std::left << std::setw(26) << c.name << " FAIL: no golden at " << path << std::endl;
+            failures++;
+            continue;
+        }
+        if (golden.width != c.output.width || golden.height != c.output.height) {
+            std::cout << std::left << std::setw(26) << c.name << " FAIL: golden is " << golden.width << "x"
+                      << golden.height << ", output is " << c.output.width << "x" << c.output.height << std::endl;
+            failures++;
+            continue;
+        }
+
+        QualityMetrics vsGolden = compareImages(c.output, golden, &pool);
+        QualityMetrics now = compareImages(c.output, *c.reference, &pool);
+        QualityMetrics then = compareImages(golden, *c.reference, &pool);
+        bool pass = c.tolerance.exact ? c.output.pixels == golden.pixels
+                                      : vsGolden.psnr >= c.tolerance.minPsnr && vsGolden.ssim >= c.tolerance.minSsim;
+        if (!pass)
+            failures++;
+
+        std::cout << std::left << std::setw(26) << c.name << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(8) << vsGolden.psnr << "dB" << std::setprecision(4) << std::setw(9) << vsGolden.ssim
+                  << std::setw(10) << vsGolden.msSsim << "   " << std::setprecision(2) << now.psnr << " dB ("
+                  << std::showpos << now.psnr - then.psnr << std::noshowpos << "), SSIM " << std::setprecision(4)
+                  << now.ssim << " (" << std::showpos << now.ssim - then.ssim << std::noshowpos << ")";
+        if (!pass && c.tolerance.exact) {
+            size_t differing = 0;
+            for (size_t i = 0; i < golden.pixels.size(); i++)
+                differing += c.output.pixels[i] != golden.pixels[i];
+            std::cout << "  FAIL: needs an exact match, " << differing << " bytes differ";
+        } else if (!pass) {
+            std::cout << "  FAIL: needs " << std::setprecision(1) << c.tolerance.minPsnr << " dB / SSIM "
+                      << std::setprecision(3) << c.tolerance.minSsim;
+        }
+        std::cout << std::endl;
+    }
+
+    std::cout << cases.size() - failures << "/" << cases.size() << " cases match their goldens" << std::endl;
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,203 @@
+// Load generator for upscalerd.
+//
+// Opens N connections, each keeping up to --inflight pixel requests outstanding
+// (a sender and a receiver thread per connection, so neither side of the socket
+// can stall the other), and reports throughput, latency percentiles and how
+// often the daemon pushed back with Busy. Busy requests are re-sent after a
+// short pause; their latency counts from the first send.
+//
+//   upscaler_loadgen [--socket PATH] [--connections N] [--requests N] [--inflight N]
+//                    [--size WxH] [--scale F] [--mode nearest|bilinear|sharpen|easu]
+
+#include "Image.h"
+#include "UpscaleMode.h"
+#include "UpscaleProtocol.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    std::string socketPath = UPSCALE_DEFAULT_SOCKET;
+    int connections = 4, requests = 200, inflight = 4;
+    int width = 256, height = 256;
+    float scale = 2.0f;
+    UpscaleMode mode = UpscaleMode::Easu;
+};
+
+struct ConnectionResult {
+    std::vector<double> latencies;
+    uint64_t busy = 0, errors = 0;
+    bool failed = false;
+};
+
+// Ids waiting to be (re)sent and the number of free in-flight slots
+struct SendState {
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<uint32_t> retries;
+    int slots = 0;
+    bool done = false;
+};
+
+void runConnection(const Options &options, const Image &image, ConnectionResult &result) {
+    int fd = connectUnixSocket(options.socketPath);
+    if (fd < 0) {
+        result.failed = true;
+        return;
+    }
+
+    std::vector<Clock::time_point> sentAt(options.requests);
+    SendState state;
+    state.slots = options.inflight;
+
+    UpscaleRequestHeader request;
+    request.mode = (uint8_t) options.mode;
+    request.scale = options.scale;
+    request.width = image.width;
+    request.height = image.height;
+    request.payloadBytes = (uint32_t) image.pixels.size();
+    int outWidth = 0, outHeight = 0;
+    resolveOutputSize(request, image.width, image.height, outWidth, outHeight);
+
+    std::thread sender([&] {
+        uint32_t nextId = 0;
+        while (true) {
+            uint32_t id;
+            {
+                std::unique_lock lock(state.mutex);
+                state.changed.wait(lock, [&] {
+                    return state.done || (state.slots > 0 && (!state.retries.empty() || nextId < (uint32_t) options.requests));
+                });
+                if (state.done)
+                    return;
+                state.slots--;
+                if (!state.retries.empty()) {
+                    id = state.retries.front();
+                    state.retries.pop_front();
+                } else {
+                    id = nextId++;
+                    sentAt[id] = Clock::now();
+                }
+            }
+            request.id = id;
+            if (!writeMessage(fd, &request, sizeof(request), image.pixels.data(), image.pixels.size()))
+                return;
+        }
+    });
+
+    UpscaleResponseHeader response;
+    std::vector<unsigned char> payload;
+    int completed = 0;
+    while (completed < options.requests) {
+        if (!readResponse(fd, response, payload, (size_t) outWidth * outHeight * 4) || response.id >= (uint32_t) options.requests) {
+            result.failed = true;
+            break;
+        }
+        if (response.status == UpscaleStatus::Busy) {
+            // Back off a little so the daemon can drain before the retry
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        std::lock_guard lock(state.mutex);
+        state.slots++;
+        if (response.status == UpscaleStatus::Busy) {
+            result.busy++;
+            state.retries.push_back(response.id);
+        } else {
+            if (response.status == UpscaleStatus::Ok)
+                result.latencies.push_back(std::chrono::duration<double, std::milli>(Clock::now() - sentAt[response.id]).count());
+            else
+                result.errors++;
+            completed++;
+        }
+        state.changed.notify_one();
+    }
+
+    {
+        std::lock_guard lock(state.mutex);
+        state.done = true;
+        state.changed.notify_one();
+    }
+    shutdown(fd, SHUT_RDWR);
+    sender.join();
+    close(fd);
+}
+
+double percentile(const std::vector<double> &sorted, double p) {
+    if (sorted.empty())
+        return 0.0;
+    size_t index = std::min(sorted.size() - 1, (size_t) (p * (sorted.size() - 1) + 0.5));
+    return sorted[index];
+}
+
+void printUsage() {
+    std::cerr << "Usage: upscaler_loadgen [--socket PATH] [--connections N] [--requests N] [--inflight N]\n"
+                 "                        [--size WxH] [--scale F] [--mode nearest|bilinear|sharpen|easu]" << std::endl;
+}
+
+}
+
+int main(int argc, char **argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc) options.socketPath = argv[++i];
+        else if (arg == "--connections" && i + 1 < argc) options.connections = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--requests" && i + 1 < argc) options.requests = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--inflight" && i + 1 < argc) options.inflight = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--size" && i + 1 < argc) std::sscanf(argv[++i], "%dx%d", &options.width, &options.height);
+        else if (arg == "--scale" && i + 1 < argc) options.scale = std::stof(argv[++i]);
+        else if (arg == "--mode" && i + 1 < argc) {
+            if (!parseUpscaleMode(argv[++i], options.mode)) { printUsage(); return 1; }
+        }
+        else { printUsage(); return 1; }
+    }
+
+    Image image(options.width, options.height, 4);
+    for (size_t i = 0; i < image.pixels.size(); i++)
+        image.pixels[i] = (unsigned char) ((i * 2654435761u) >> 24);
+
+    std::vector<ConnectionResult> results(options.connections);
+    std::vector<std::thread> threads;
+    auto start = Clock::now();
+    for (int c = 0; c < options.connections; c++)
+        threads.emplace_back(runConnection, std::cref(options), std::cref(image), std::ref(results[c]));
+    for (std::thread &thread : threads)
+        thread.join();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<double> latencies;
+    uint64_t busy = 0, errors = 0;
+    int failed = 0;
+    for (const ConnectionResult &r : results) {
+        latencies.insert(latencies.end(), r.latencies.begin(), r.latencies.end());
+        busy += r.busy;
+        errors += r.errors;
+        failed += r.failed;
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    double outPixels = (double) (int) (options.width * options.scale + 0.5f) * (int) (options.height * options.scale + 0.5f);
+    std::cout << options.connections << " connections x " << options.requests << " requests, " << options.width << "x"
+              << options.height << " x" << options.scale << " " << upscaleModeName(options.mode) << std::endl;
+    std::cout << "  " << latencies.size() << " ok in " << seconds << " s: " << latencies.size() / seconds << " req/s, "
+              << latencies.size() * outPixels / 1e6 / seconds << " MP/s out" << std::endl;
+    std::cout << "  latency ms: p50 " << percentile(latencies, 0.5) << ", p95 " << percentile(latencies, 0.95)
+              << ", p99 " << percentile(latencies, 0.99) << ", max " << (latencies.empty() ? 0.0 : latencies.back())
+              << std::endl;
+    std::cout << "  busy " << busy << ", errors " << errors << ", failed connections " << failed << std::endl;
+    return failed > 0 ? 1 : 0;
+}
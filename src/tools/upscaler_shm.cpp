@@ -0,0 +1,136 @@
+// Upscaler side of the shared-memory frame exchange.
+//
+// For each producer that connects to the control socket, two SharedFrameRings are
+// created (low-res input, upscaled output) and their memfds are handed over with
+// SCM_RIGHTS; after that the socket only tells us when the producer exits. Frames are upscaled straight from an
+// input slot into an output slot, so nothing is copied or allocated per frame.
+// The session ends when the producer closes the input ring.
+//
+//   upscaler_shm [--socket PATH] [--size WxH] [--scale F] [--slots N]
+//                [--mode nearest|bilinear|sharpen|easu] [--sharpness S] [--threads N]
+
+#include "CpuUpscaler.h"
+#include "SharedFrameRing.h"
+#include "ThreadPool.h"
+#include "UpscaleProtocol.h"
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <iostream>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+std::atomic<bool> stopRequested = false;
+
+void onSignal(int) {
+    stopRequested = true;
+}
+
+void printUsage() {
+    std::cerr << "Usage: upscaler_shm [--socket PATH] [--size WxH] [--scale F] [--slots N]\n"
+                 "                    [--mode nearest|bilinear|sharpen|easu] [--sharpness S] [--threads N]" << std::endl;
+}
+
+}
+
+int main(int argc, char **argv) {
+    std::string socketPath = "/tmp/upscaler_shm.sock";
+    int width = 960, height = 540, slots = 4;
+    float scale = 2.0f, sharpness = -1.0f;
+    UpscaleMode mode = UpscaleMode::Easu;
+    unsigned int threads = std::thread::hardware_concurrency();
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc) socketPath = argv[++i];
+        else if (arg == "--size" && i + 1 < argc) std::sscanf(argv[++i], "%dx%d", &width, &height);
+        else if (arg == "--scale" && i + 1 < argc) scale = std::stof(argv[++i]);
+        else if (arg == "--slots" && i + 1 < argc) slots = std::stoi(argv[++i]);
+        else if (arg == "--mode" && i + 1 < argc) {
+            if (!parseUpscaleMode(argv[++i], mode)) { printUsage(); return 1; }
+        }
+        else if (arg == "--sharpness" && i + 1 < argc) sharpness = std::stof(argv[++i]);
+        else if (arg == "--threads" && i + 1 < argc) threads = (unsigned int) std::stoi(argv[++i]);
+        else { printUsage(); return 1; }
+    }
+    if (sharpness < 0.0f)
+        sharpness = mode == UpscaleMode::Easu ? 0.2f : 0.5f;
+    int outWidth = (int) (width * scale + 0.5f), outHeight = (int) (height * scale + 0.5f);
+
+    int listenFd = listenUnixSocket(socketPath);
+    if (listenFd < 0)
+        return 1;
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    ThreadPool pool(threads);
+
+    std::cerr << "upscaler_shm on " << socketPath << ": " << width << "x" << height << " -> " << outWidth << "x"
+              << outHeight << " " << upscaleModeName(mode) << ", " << slots << " slots" << std::endl;
+
+    while (!stopRequested) {
+        pollfd listener = {listenFd, POLLIN, 0};
+        if (poll(&listener, 1, 200) <= 0)
+            continue;
+        int connection = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (connection < 0)
+            continue;
+
+        SharedFrameRing input, output;
+        if (!input.create("upscaler-input", slots, width, height) ||
+            !output.create("upscaler-output", slots, outWidth, outHeight)) {
+            close(connection);
+            continue;
+        }
+        int fds[2] = {input.fd(), output.fd()};
+        if (!sendFds(connection, fds, 2)) {
+            close(connection);
+            continue;
+        }
+        auto producerGone = [&] {
+            pollfd peer = {connection, POLLIN, 0};
+            return poll(&peer, 1, 0) > 0 && (peer.revents & (POLLHUP | POLLERR | POLLIN));
+        };
+
+        uint64_t frames = 0, busyNs = 0;
+        SharedFrameInfo info;
+        while (!stopRequested) {
+            const unsigned char *src = input.acquireRead(info, 200);
+            if (!src) {
+                // A timeout while the producer is idle, or it closed the ring and it is drained
+                if (input.isClosed() || producerGone())
+                    break;
+                continue;
+            }
+            unsigned char *dst = nullptr;
+            while (!dst && !stopRequested && !output.isClosed() && !producerGone())
+                dst = output.acquireWrite(200);
+            if (!dst)
+                break;
+
+            uint64_t start = SharedFrameRing::nowNs();
+            upscaleImage(ImageView(src, width, height, (size_t) width * 4),
+                         MutableImageView(dst, outWidth, outHeight, (size_t) outWidth * 4), mode, sharpness, &pool);
+            busyNs += SharedFrameRing::nowNs() - start;
+
+            // The producer's timestamp travels with the frame for end-to-end latency
+            output.commitWrite(info);
+            input.releaseRead();
+            frames++;
+        }
+        output.close();
+        input.close();
+        close(connection);
+
+        std::cerr << "session: " << frames << " frames, upscale " << (frames ? busyNs / 1e6 / frames : 0.0)
+                  << " ms/frame" << std::endl;
+    }
+
+    close(listenFd);
+    unlink(socketPath.c_str());
+    return 0;
+}
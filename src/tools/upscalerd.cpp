@@ -0,0 +1,436 @@
+// Long-lived upscaling daemon on a Unix domain socket (protocol in UpscaleProtocol.h).
+//
+// One reader thread per connection parses requests and hands them to a single
+// upscale worker through a bounded queue. When the queue is full the reader stops
+// reading, so the client's writes block (socket flow control); after
+// --busy-after-ms the request is answered with Busy instead. The worker drains
+// everything already queued (optionally waiting --batch-window-us for more) and
+// runs the batch in one thread-pool dispatch, or back to back on one GL context
+// whose shaders stay compiled for the daemon's lifetime. A reply thread writes
+// results (or PNG files) so slow clients never stall the worker. Pixel buffers
+// are recycled through a pool.
+//
+// The socket is only open to the daemon's user. Path requests make the daemon read
+// and write files with its own privileges, so they are refused unless --root names
+// a directory, and then only served for files under it (after resolving symlinks).
+//
+//   upscalerd [--socket PATH] [--threads N] [--queue N] [--batch N] [--batch-window-us U]
+//             [--busy-after-ms M] [--root DIR] [--gl]
+
+#include "BoundedQueue.h"
+#include "CpuUpscaler.h"
+#include "GlUpscaler.h"
+#include "ThreadPool.h"
+#include "UpscaleProtocol.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <tuple>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::atomic<bool> stopRequested = false;
+
+void onSignal(int) {
+    stopRequested = true;
+}
+
+struct Connection {
+    int fd;
+    std::mutex writeMutex;
+
+    explicit Connection(int fd) : fd(fd) {}
+    ~Connection() { close(fd); }
+
+    bool reply(uint32_t id, UpscaleStatus status, int width = 0, int height = 0, const void *payload = nullptr,
+               size_t payloadSize = 0) {
+        UpscaleResponseHeader header;
+        header.id = id;
+        header.status = status;
+        header.width = width;
+        header.height = height;
+        header.payloadBytes = (uint32_t) payloadSize;
+        std::lock_guard lock(writeMutex);
+        return writeMessage(fd, &header, sizeof(header), payload, payloadSize);
+    }
+
+    bool replyError(uint32_t id, const std::string &message) {
+        return reply(id, UpscaleStatus::Error, 0, 0, message.data(),
+                     std::min(message.size(), (size_t) UPSCALE_MAX_ERROR_BYTES));
+    }
+};
+
+struct Job {
+    std::shared_ptr<Connection> connection;
+    uint32_t id = 0;
+    UpscaleMode mode = UpscaleMode::Easu;
+    float sharpness = 0.2f;
+    std::string outputPath;
+    Image src, dst;
+    Clock::time_point received;
+};
+
+// Recycles pixel storage between requests; keeps at most `limit` idle buffers.
+class BufferPool {
+public:
+    explicit BufferPool(size_t limit) : limit(limit) {}
+
+    Image acquire(int width, int height) {
+        Image image;
+        {
+            std::lock_guard lock(mutex);
+            if (!buffers.empty()) {
+                image.pixels = std::move(buffers.back());
+                buffers.pop_back();
+            }
+        }
+        image.width = width;
+        image.height = height;
+        image.channels = 4;
+        image.pixels.resize((size_t) width * height * 4);
+        return image;
+    }
+
+    void release(Image &image) {
+        if (image.pixels.capacity() == 0)
+            return;
+        std::lock_guard lock(mutex);
+        if (buffers.size() < limit)
+            buffers.push_back(std::move(image.pixels));
+        image = Image();
+    }
+
+private:
+    size_t limit;
+    std::vector<std::vector<unsigned char>> buffers;
+    std::mutex mutex;
+};
+
+struct Stats {
+    std::atomic<uint64_t> requests = 0, busy = 0, errors = 0, batches = 0, batchedRequests = 0;
+    std::atomic<double> latencyMs = 0.0;
+};
+
+struct Daemon {
+    BoundedQueue<std::unique_ptr<Job>> requests, replies;
+    BufferPool buffers;
+    ThreadPool pool;
+    Stats stats;
+    size_t maxBatch;
+    std::chrono::microseconds batchWindow;
+    std::chrono::milliseconds busyAfter;
+    // Canonical directory Path requests are confined to; empty refuses them
+    std::filesystem::path root;
+    GLFWwindow *glWindow = nullptr;
+
+    Daemon(size_t queueDepth, unsigned int threads, size_t maxBatch, int batchWindowUs, int busyAfterMs)
+        : requests(queueDepth), replies(queueDepth), buffers(queueDepth * 2 + 8), pool(threads),
+          maxBatch(maxBatch), batchWindow(batchWindowUs), busyAfter(busyAfterMs) {}
+
+    bool resolvePath(const std::string &requested, std::filesystem::path &resolved) const;
+    void serveConnection(const std::shared_ptr<Connection> &connection);
+    void upscaleLoop();
+    void replyLoop();
+};
+
+bool skipPayload(int fd, size_t size) {
+    char scratch[4096];
+    while (size > 0) {
+        size_t n = std::min(size, sizeof(scratch));
+        if (!readFully(fd, scratch, n))
+            return false;
+        size -= n;
+    }
+    return true;
+}
+
+// Follows symlinks in every existing component, so a link inside the root can't point out of it
+bool Daemon::resolvePath(const std::string &requested, std::filesystem::path &resolved) const {
+    std::error_code error;
+    std::filesystem::path path(requested);
+    resolved = std::filesystem::weakly_canonical(path.is_absolute() ? path : root / path, error);
+    if (error)
+        return false;
+    std::filesystem::path relative = resolved.lexically_relative(root);
+    return !relative.empty() && *relative.begin() != "..";
+}
+
+void Daemon::serveConnection(const std::shared_ptr<Connection> &connection) {
+    const size_t maxPayload = (size_t) 64 << 20;
+    UpscaleRequestHeader request;
+
+    while (readFully(connection->fd, &request, sizeof(request))) {
+        if (request.magic != UPSCALE_REQUEST_MAGIC) {
+            connection->replyError(request.id, "bad request magic");
+            break;
+        }
+        stats.requests++;
+        auto job = std::make_unique<Job>();
+        job->connection = connection;
+        job->id = request.id;
+        job->received = Clock::now();
+
+        // Anything that leaves the payload unread is answered, then the payload is skipped
+        std::string error;
+        if (request.payloadBytes > maxPayload)
+            error = "payload too large";
+        else if (request.mode > (uint8_t) UpscaleMode::Easu)
+            error = "unknown mode";
+        else if (request.source == UpscaleSource::Pixels &&
+                 (request.width <= 0 || request.height <= 0 || request.width > UPSCALE_MAX_DIMENSION ||
+                  request.height > UPSCALE_MAX_DIMENSION ||
+                  request.payloadBytes != (uint64_t) request.width * request.height * 4))
+            error = "pixel payload does not match width x height x 4";
+        else if (request.source != UpscaleSource::Pixels && request.source != UpscaleSource::Path)
+            error = "unknown source";
+        else if (request.source == UpscaleSource::Path && root.empty())
+            error = "path sources are disabled (start upscalerd with --root DIR)";
+        if (!error.empty()) {
+            stats.errors++;
+            connection->replyError(request.id, error);
+            if (request.payloadBytes > maxPayload || !skipPayload(connection->fd, request.payloadBytes))
+                break;
+            continue;
+        }
+
+        if (request.source == UpscaleSource::Pixels) {
+            job->src = buffers.acquire(request.width, request.height);
+            if (!readFully(connection->fd, job->src.pixels.data(), request.payloadBytes))
+                break;
+        } else {
+            std::string paths(request.payloadBytes, '\0');
+            if (!readFully(connection->fd, paths.data(), paths.size()))
+                break;
+            size_t split = paths.find('\0');
+            std::string inputPath = paths.substr(0, split), outputPath;
+            if (split != std::string::npos)
+                outputPath = paths.c_str() + split + 1;
+            std::filesystem::path input, output;
+            if (!resolvePath(inputPath, input) || (!outputPath.empty() && !resolvePath(outputPath, output))) {
+                stats.errors++;
+                connection->replyError(request.id, "paths must be under " + root.string());
+                continue;
+            }
+            job->outputPath = output.string();
+            if (!loadImage(input.string(), job->src, 4)) {
+                stats.errors++;
+                connection->replyError(request.id, "failed to load " + inputPath);
+                continue;
+            }
+        }
+
+        int outWidth, outHeight;
+        if (!resolveOutputSize(request, job->src.width, job->src.height, outWidth, outHeight)) {
+            stats.errors++;
+            connection->replyError(request.id, "bad output size");
+            buffers.release(job->src);
+            continue;
+        }
+
+        job->mode = (UpscaleMode) request.mode;
+        job->sharpness = request.sharpness >= 0.0f ? request.sharpness : (job->mode == UpscaleMode::Easu ? 0.2f : 0.5f);
+        job->dst = buffers.acquire(outWidth, outHeight);
+
+        if (!requests.pushUntil(job, Clock::now() + busyAfter)) {
+            stats.busy++;
+            buffers.release(job->src);
+            buffers.release(job->dst);
+            connection->reply(request.id, UpscaleStatus::Busy);
+        }
+    }
+}
+
+void Daemon::upscaleLoop() {
+    std::unique_ptr<GlUpscaler> gl;
+    if (glWindow) {
+        glfwMakeContextCurrent(glWindow);
+        gl = std::make_unique<GlUpscaler>();
+    }
+
+    std::vector<std::unique_ptr<Job>> batch;
+    std::vector<UpscaleTask> tasks;
+    while (auto first = requests.pop()) {
+        batch.clear();
+        batch.push_back(std::move(*first));
+        auto deadline = Clock::now() + batchWindow;
+        while (batch.size() < maxBatch) {
+            auto next = requests.popUntil(deadline);
+            if (!next)
+                break;
+            batch.push_back(std::move(*next));
+        }
+
+        if (gl) {
+            // Same-sized jobs back to back so the textures are only reallocated on size changes
+            std::stable_sort(batch.begin(), batch.end(), [](const auto &a, const auto &b) {
+                return std::tie(a->src.width, a->src.height, a->dst.width, a->dst.height) <
+                       std::tie(b->src.width, b->src.height, b->dst.width, b->dst.height);
+            });
+            for (auto &job : batch) {
+                gl->resize(job->src.width, job->src.height, job->dst.width, job->dst.height);
+                gl->process(job->src, job->dst, job->mode, job->sharpness);
+            }
+        } else {
+            tasks.clear();
+            for (auto &job : batch)
+                tasks.push_back({job->src, job->dst, job->mode, job->sharpness});
+            upscaleBatch(tasks.data(), tasks.size(), &pool);
+        }
+
+        stats.batches++;
+        stats.batchedRequests += batch.size();
+        for (auto &job : batch)
+            replies.push(std::move(job));
+    }
+
+    if (gl) {
+        gl.reset();
+        glfwMakeContextCurrent(nullptr);
+    }
+    replies.close();
+}
+
+void Daemon::replyLoop() {
+    while (auto next = replies.pop()) {
+        Job &job = **next;
+        buffers.release(job.src);
+        if (!job.outputPath.empty()) {
+            if (saveImagePng(job.outputPath, job.dst))
+                job.connection->reply(job.id, UpscaleStatus::Ok);
+            else
+                job.connection->replyError(job.id, "failed to write " + job.outputPath);
+        } else {
+            job.connection->reply(job.id, UpscaleStatus::Ok, job.dst.width, job.dst.height, job.dst.pixels.data(),
+                                  job.dst.pixels.size());
+        }
+        buffers.release(job.dst);
+        stats.latencyMs = stats.latencyMs + std::chrono::duration<double, std::milli>(Clock::now() - job.received).count();
+    }
+}
+
+void printUsage() {
+    std::cerr << "Usage: upscalerd [--socket PATH] [--threads N] [--queue N] [--batch N] [--batch-window-us U]\n"
+                 "                 [--busy-after-ms M] [--root DIR] [--gl]"
+              << std::endl;
+}
+
+}
+
+int main(int argc, char **argv) {
+    std::string socketPath = UPSCALE_DEFAULT_SOCKET;
+    unsigned int threads = std::thread::hardware_concurrency();
+    int queueDepth = 64, maxBatch = 16, batchWindowUs = 0, busyAfterMs = 100;
+    bool useGl = false;
+    std::string root;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc) socketPath = argv[++i];
+        else if (arg == "--threads" && i + 1 < argc) threads = (unsigned int) std::stoi(argv[++i]);
+        else if (arg == "--queue" && i + 1 < argc) queueDepth = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--batch" && i + 1 < argc) maxBatch = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--batch-window-us" && i + 1 < argc) batchWindowUs = std::max(0, std::stoi(argv[++i]));
+        else if (arg == "--busy-after-ms" && i + 1 < argc) busyAfterMs = std::max(0, std::stoi(argv[++i]));
+        else if (arg == "--root" && i + 1 < argc) root = argv[++i];
+        else if (arg == "--gl") useGl = true;
+        else { printUsage(); return 1; }
+    }
+
+    Daemon daemon(queueDepth, threads, maxBatch, batchWindowUs, busyAfterMs);
+    if (!root.empty()) {
+        std::error_code error;
+        daemon.root = std::filesystem::canonical(root, error);
+        if (error || !std::filesystem::is_directory(daemon.root)) {
+            std::cerr << "Not a directory: " << root << std::endl;
+            return 1;
+        }
+    }
+
+    // The context is created here and made current on the worker, as in y4mupscale
+    if (useGl) {
+        daemon.glWindow = createHeadlessContext();
+        if (!daemon.glWindow) {
+            std::cerr << "Failed to create a headless GL context" << std::endl;
+            return 1;
+        }
+        glfwMakeContextCurrent(nullptr);
+    }
+
+    int listenFd = listenUnixSocket(socketPath);
+    if (listenFd < 0)
+        return 1;
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    std::thread upscaleThread([&] { daemon.upscaleLoop(); });
+    std::thread replyThread([&] { daemon.replyLoop(); });
+
+    struct Client {
+        std::shared_ptr<Connection> connection;
+        std::thread thread;
+        std::atomic<bool> done = false;
+    };
+    std::list<Client> clients;
+
+    std::cerr << "upscalerd listening on " << socketPath << (useGl ? " (GL)" : " (CPU)") << std::endl;
+    while (!stopRequested) {
+        // Finished readers are joined here; their socket closes once the last reply is out
+        for (auto it = clients.begin(); it != clients.end();) {
+            if (it->done) {
+                it->thread.join();
+                it = clients.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        pollfd listener = {listenFd, POLLIN, 0};
+        if (poll(&listener, 1, 200) <= 0)
+            continue;
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0)
+            continue;
+
+        Client &client = clients.emplace_back();
+        client.connection = std::make_shared<Connection>(fd);
+        client.thread = std::thread([&daemon, &client] {
+            daemon.serveConnection(client.connection);
+            client.done = true;
+        });
+    }
+
+    close(listenFd);
+    unlink(socketPath.c_str());
+    for (Client &client : clients)
+        shutdown(client.connection->fd, SHUT_RDWR);
+    for (Client &client : clients)
+        client.thread.join();
+    daemon.requests.close();
+    upscaleThread.join();
+    replyThread.join();
+
+    uint64_t batches = daemon.stats.batches, batched = daemon.stats.batchedRequests;
+    std::cerr << "upscalerd: " << daemon.stats.requests << " requests, " << batched << " upscaled in " << batches
+              << " batches (" << (batches ? (double) batched / batches : 0.0) << " per batch), "
+              << daemon.stats.busy << " busy, " << daemon.stats.errors << " errors, mean latency "
+              << (batched ? daemon.stats.latencyMs / batched : 0.0) << " ms" << std::endl;
+
+    if (daemon.glWindow)
+        glfwTerminate();
+    return 0;
+}
@@ -0,0 +1,222 @@
+// Offline video upscaler: YUV4MPEG2 in, YUV4MPEG2 out.
+//
+// Decode (read + YUV->RGB), upscale and encode (RGB->YUV + write) run on three
+// threads connected by bounded queues; a fixed set of frame jobs is recycled so
+// the steady state does no allocation. With --yuv the planes are upscaled
+// directly (luma with the chosen mode, chroma bilinear) and both conversions
+// are skipped. With --incremental only the output tiles affected by tiles that
+// changed since the previous frame are upscaled again (RGB path only).
+//
+//   y4mupscale [--scale 2 | --size WxH] [--mode nearest|bilinear|sharpen|easu]
+//              [--sharpness S] [--matrix 601|709] [--threads N] [--queue N] [--gl]
+//              [--yuv | --incremental] input.y4m output.y4m          ("-" for stdin/stdout)
+
+#include "BoundedQueue.h"
+#include "CpuUpscaler.h"
+#include "DirtyTiles.h"
+#include "GlUpscaler.h"
+#include "ThreadPool.h"
+#include "Y4m.h"
+#include "Yuv.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace {
+
+struct FrameJob {
+    YuvFrame yuvIn, yuvOut;
+    Image rgbIn, rgbOut;
+    bool last = false;
+};
+
+using Clock = std::chrono::steady_clock;
+
+double msSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+void printUsage() {
+    std::cerr << "Usage: y4mupscale [--scale F | --size WxH] [--mode nearest|bilinear|sharpen|easu] [--sharpness S]\n"
+                 "                  [--matrix 601|709] [--threads N] [--queue N] [--gl] [--yuv | --incremental]\n"
+                 "                  input.y4m output.y4m" << std::endl;
+}
+
+}
+
+int main(int argc, char **argv) {
+    float scale = 2.0f, sharpness = 0.2f;
+    int outWidth = 0, outHeight = 0;
+    UpscaleMode mode = UpscaleMode::Easu;
+    YuvMatrix matrix = YuvMatrix::BT709;
+    unsigned int threads = std::thread::hardware_concurrency();
+    int queueDepth = 4;
+    bool useGl = false, nativeYuv = false, incremental = false;
+    std::string inputPath, outputPath;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--scale" && i + 1 < argc) scale = std::stof(argv[++i]);
+        else if (arg == "--size" && i + 1 < argc) std::sscanf(argv[++i], "%dx%d", &outWidth, &outHeight);
+        else if (arg == "--mode" && i + 1 < argc) {
+            if (!parseUpscaleMode(argv[++i], mode)) { printUsage(); return 1; }
+        }
+        else if (arg == "--sharpness" && i + 1 < argc) sharpness = std::stof(argv[++i]);
+        else if (arg == "--matrix" && i + 1 < argc) matrix = std::string(argv[++i]) == "601" ? YuvMatrix::BT601 : YuvMatrix::BT709;
+        else if (arg == "--threads" && i + 1 < argc) threads = (unsigned int) std::stoi(argv[++i]);
+        else if (arg == "--queue" && i + 1 < argc) queueDepth = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--gl") useGl = true;
+        else if (arg == "--yuv") nativeYuv = true;
+        else if (arg == "--incremental") incremental = true;
+        else if (inputPath.empty()) inputPath = arg;
+        else if (outputPath.empty()) outputPath = arg;
+        else { printUsage(); return 1; }
+    }
+    if (inputPath.empty() || outputPath.empty() || (nativeYuv && incremental)) {
+        printUsage();
+        return 1;
+    }
+
+    Y4mReader reader;
+    if (!reader.open(inputPath))
+        return 1;
+    if (outWidth <= 0 || outHeight <= 0) {
+        outWidth = (int) (reader.width * scale + 0.5f);
+        outHeight = (int) (reader.height * scale + 0.5f);
+    }
+
+    Y4mWriter writer;
+    if (!writer.open(outputPath, outWidth, outHeight, reader.frameRate, reader.aspect, reader.interlace))
+        return 1;
+
+    // GL contexts must be created on the main thread; the upscale thread makes it current
+    GLFWwindow *glWindow = nullptr;
+    std::unique_ptr<GlUpscaler> glUpscaler;
+    if (useGl) {
+        glWindow = createHeadlessContext();
+        if (!glWindow) {
+            std::cerr << "Failed to create a headless GL context" << std::endl;
+            return 1;
+        }
+        glUpscaler = std::make_unique<GlUpscaler>();
+        glUpscaler->resize(reader.width, reader.height, outWidth, outHeight);
+        glfwMakeContextCurrent(nullptr);
+    }
+
+    // Conversion and CPU upscaling share one pool; each stage only uses it for its own frame
+    ThreadPool pool(threads);
+
+    // Jobs in flight bound the memory use: one per queue slot plus one per stage
+    int jobCount = queueDepth * 2 + 3;
+    BoundedQueue<std::unique_ptr<FrameJob>> freeJobs(jobCount), toUpscale(queueDepth), toEncode(queueDepth);
+    for (int i = 0; i < jobCount; i++) {
+        auto job = std::make_unique<FrameJob>();
+        job->yuvIn.resize(reader.width, reader.height);
+        if (!nativeYuv) {
+            job->rgbIn = Image(reader.width, reader.height, 4);
+            job->rgbOut = Image(outWidth, outHeight, 4);
+        }
+        job->yuvOut.resize(outWidth, outHeight);
+        freeJobs.push(std::move(job));
+    }
+
+    std::atomic<double> decodeMs = 0.0, upscaleMs = 0.0, encodeMs = 0.0;
+    std::atomic<int> framesWritten = 0;
+    double redrawnFraction = 0.0;
+    auto start = Clock::now();
+
+    std::thread decodeThread([&] {
+        while (auto job = freeJobs.pop()) {
+            auto t = Clock::now();
+            bool ok = reader.readFrame((*job)->yuvIn);
+            if (ok && !nativeYuv)
+                yuv420ToRgba((*job)->yuvIn, (*job)->rgbIn, matrix, &pool);
+            decodeMs = decodeMs + msSince(t);
+            (*job)->last = !ok;
+            toUpscale.push(std::move(*job));
+            if (!ok)
+                break;
+        }
+    });
+
+    std::thread upscaleThread([&] {
+        if (glWindow)
+            glfwMakeContextCurrent(glWindow);
+        // Incremental mode redraws into one persistent output and copies it into each job
+        DirtyTileTracker tracker;
+        Image current(incremental ? outWidth : 0, incremental ? outHeight : 0, 4);
+        while (auto job = toUpscale.pop()) {
+            if (!(*job)->last) {
+                auto t = Clock::now();
+                if (nativeYuv && glUpscaler)
+                    glUpscaler->processYuv((*job)->yuvIn, (*job)->yuvOut, mode, sharpness);
+                else if (nativeYuv)
+                    upscaleYuv420((*job)->yuvIn, (*job)->yuvOut, mode, sharpness, &pool);
+                else if (incremental) {
+                    tracker.update((*job)->rgbIn, outWidth, outHeight);
+                    if (glUpscaler)
+                        glUpscaler->processRects((*job)->rgbIn, current, tracker.sourceRects, tracker.outputRects, mode, sharpness);
+                    else
+                        upscaleRects((*job)->rgbIn, current, tracker.outputRects, mode, sharpness, &pool);
+                    (*job)->rgbOut.pixels = current.pixels;
+                    redrawnFraction += tracker.outputFraction;
+                }
+                else if (glUpscaler)
+                    glUpscaler->process((*job)->rgbIn, (*job)->rgbOut, mode, sharpness);
+                else
+                    upscaleImage((*job)->rgbIn, (*job)->rgbOut, mode, sharpness, &pool);
+                upscaleMs = upscaleMs + msSince(t);
+            }
+            bool last = (*job)->last;
+            toEncode.push(std::move(*job));
+            if (last)
+                break;
+        }
+        if (glWindow)
+            glfwMakeContextCurrent(nullptr);
+    });
+
+    std::thread encodeThread([&] {
+        while (auto job = toEncode.pop()) {
+            if ((*job)->last)
+                break;
+            auto t = Clock::now();
+            if (!nativeYuv)
+                rgbaToYuv420((*job)->rgbOut, (*job)->yuvOut, matrix, &pool);
+            writer.writeFrame((*job)->yuvOut);
+            encodeMs = encodeMs + msSince(t);
+            framesWritten++;
+            freeJobs.push(std::move(*job));
+        }
+        freeJobs.close();
+    });
+
+    decodeThread.join();
+    upscaleThread.join();
+    encodeThread.join();
+
+    double totalMs = msSince(start);
+    int frames = framesWritten;
+    std::cerr << reader.width << "x" << reader.height << " -> " << outWidth << "x" << outHeight
+              << " " << upscaleModeName(mode) << (useGl ? " (GL" : " (CPU") << (nativeYuv ? ", YUV)" : ")") << ": "
+              << frames << " frames in " << totalMs / 1000.0 << " s, "
+              << (totalMs > 0 ? frames * 1000.0 / totalMs : 0.0) << " fps" << std::endl;
+    if (frames > 0) {
+        std::cerr << "  per frame: decode " << decodeMs / frames << " ms, upscale " << upscaleMs / frames
+                  << " ms, encode " << encodeMs / frames << " ms" << std::endl;
+        if (incremental)
+            std::cerr << "  incremental: redrew " << redrawnFraction * 100.0 / frames << "% of the output ("
+                      << 100.0 - redrawnFraction * 100.0 / frames << "% skipped)" << std::endl;
+    }
+
+    if (glWindow) {
+        glfwMakeContextCurrent(glWindow);
+        glUpscaler.reset();
+        glfwTerminate();
+    }
+    return 0;
+}
@@ -1,4 +1,5 @@
 #include "triangle_mesh.h"
+#include "GpuMemory.h"
 #include <vector>
 #include <glad/glad.h>
 
@@ -16,7 +17,7 @@ TriangleMesh::TriangleMesh() {
     glGenBuffers(1, &VBO);
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
     size_t bufferSize = data.size() * sizeof(float);
-    glBufferData(GL_ARRAY_BUFFER, bufferSize, data.data(),
+    gpuBufferData(VBO, GL_ARRAY_BUFFER, "triangle mesh", bufferSize, data.data(),
             GL_STATIC_DRAW);
 
     //position
@@ -37,5 +38,5 @@ void TriangleMesh::draw() const {
 
 TriangleMesh::~TriangleMesh() {
     glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
+    gpuDeleteBuffers(1, &VBO);
 }
\ No newline at end of file